@@ -0,0 +1,29 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Global tables of the BindlessTable, bound once per command buffer
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+// PhongMaterial parameters
+layout(std430, set = 1, binding = 1) readonly buffer Material {
+    vec4 color;
+    uint texture;
+    float specular;
+    float shininess;
+} materials[];
+
+layout(location = 0) in vec2 inTexCoord;
+layout(location = 1) flat in uint inMaterial;
+
+layout(location = 0) out vec4 outColor;
+
+const uint NO_TEXTURE = 0xffffffffu;
+
+void main() {
+    // Instances of one draw may use different materials, so the index is not uniform
+    outColor = materials[nonuniformEXT(inMaterial)].color;
+    uint textureIndex = materials[nonuniformEXT(inMaterial)].texture;
+    if (textureIndex != NO_TEXTURE) {
+        outColor *= texture(textures[nonuniformEXT(textureIndex)], inTexCoord);
+    }
+}
@@ -0,0 +1,27 @@
+#version 450
+
+layout(location = 0) in vec3 inPosition;
+// Meshes without texture coordinates feed the position here, see PhongMaterial
+layout(location = 2) in vec2 inTexCoord;
+
+// Per instance, see InstanceData
+layout(location = 11) in mat4 inTransform;
+layout(location = 15) in uint inMaterial;
+
+layout(location = 0) out vec2 outTexCoord;
+layout(location = 1) flat out uint outMaterial;
+// Read by the G-buffer shaders only, see DeferredRenderer
+layout(location = 2) out vec3 outWorldPosition;
+
+// Frame constants from the uniform ring of the frame, see Engine
+layout(set = 0, binding = 0) uniform Frame {
+    mat4 viewProjection;
+} frame;
+
+void main() {
+    vec4 worldPosition = inTransform * vec4(inPosition, 1.0);
+    gl_Position = frame.viewProjection * worldPosition;
+    outWorldPosition = worldPosition.xyz;
+    outTexCoord = inTexCoord;
+    outMaterial = inMaterial;
+}
@@ -0,0 +1,20 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+// Forward shading with clustered lighting without bindless table, every material has the same fixed color
+#define LIGHT_SET 1
+#include "clustered_shading.glsl"
+
+layout(location = 2) in vec3 inWorldPosition;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // Flat normal of the triangle, meshes do not need normals of their own
+    vec3 normal = normalize(cross(dFdy(inWorldPosition), dFdx(inWorldPosition)));
+    vec3 viewDirection = viewDirectionAt(fragmentPosition());
+    normal = faceforward(normal, -viewDirection, normal);
+
+    vec3 albedo = vec3(1.0, 0.0, 0.0);
+    outColor = vec4(shadeClustered(inWorldPosition, normal, viewDirection, albedo, vec2(0.5, 32.0 / 256.0)), 1.0);
+}
@@ -0,0 +1,44 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Forward shading with clustered lighting, the material parameters of bindless.frag lit by the lights of the
+// fragment's cluster
+#define LIGHT_SET 2
+#include "clustered_shading.glsl"
+
+// Global tables of the BindlessTable, bound once per command buffer
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+// PhongMaterial parameters
+layout(std430, set = 1, binding = 1) readonly buffer Material {
+    vec4 color;
+    uint texture;
+    float specular;
+    float shininess;
+} materials[];
+
+layout(location = 0) in vec2 inTexCoord;
+layout(location = 1) flat in uint inMaterial;
+layout(location = 2) in vec3 inWorldPosition;
+
+layout(location = 0) out vec4 outColor;
+
+const uint NO_TEXTURE = 0xffffffffu;
+
+void main() {
+    vec4 albedo = materials[nonuniformEXT(inMaterial)].color;
+    uint textureIndex = materials[nonuniformEXT(inMaterial)].texture;
+    if (textureIndex != NO_TEXTURE) {
+        albedo *= texture(textures[nonuniformEXT(textureIndex)], inTexCoord);
+    }
+    vec2 material = vec2(materials[nonuniformEXT(inMaterial)].specular,
+                         materials[nonuniformEXT(inMaterial)].shininess / 256.0);
+
+    // Flat normal of the triangle, meshes do not need normals of their own
+    vec3 normal = normalize(cross(dFdy(inWorldPosition), dFdx(inWorldPosition)));
+    vec3 viewDirection = viewDirectionAt(fragmentPosition());
+    normal = faceforward(normal, -viewDirection, normal);
+
+    outColor = vec4(shadeClustered(inWorldPosition, normal, viewDirection, albedo.rgb, material), albedo.a);
+}
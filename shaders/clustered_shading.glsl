@@ -0,0 +1,43 @@
+// Shading with the lights of the cluster of a fragment, included by the fragment shaders of clustered lighting.
+// LIGHT_SET is the set of the LightCuller's light set in the including shader.
+
+#include "clusters.glsl"
+#include "lights.glsl"
+
+layout(std430, set = LIGHT_SET, binding = 0) readonly buffer Lights {
+    Light lights[];
+};
+
+layout(std430, set = LIGHT_SET, binding = 1) readonly buffer Clusters {
+    Cluster clusters[];
+};
+
+layout(std430, set = LIGHT_SET, binding = 2) readonly buffer ClusteringBlock {
+    Clustering clustering;
+};
+
+// Device coordinates of the fragment
+vec2 fragmentPosition() {
+    return gl_FragCoord.xy * clustering.inverseExtent * 2.0 - 1.0;
+}
+
+// Towards the eye along the ray of the fragment, works for perspective and orthographic projections
+vec3 viewDirectionAt(vec2 position) {
+    return normalize(unproject(clustering.inverseViewProjection, position, 0.0) -
+                     unproject(clustering.inverseViewProjection, position, 1.0));
+}
+
+vec3 shadeClustered(vec3 position, vec3 normal, vec3 viewDirection, vec3 albedo, vec2 material) {
+    uvec2 tile = min(uvec2(gl_FragCoord.xy * clustering.inverseExtent * vec2(CLUSTER_COUNT_X, CLUSTER_COUNT_Y)),
+                     uvec2(CLUSTER_COUNT_X - 1u, CLUSTER_COUNT_Y - 1u));
+    float depth = dot(position - clustering.nearPoint.xyz, clustering.axis.xyz);
+    uint slice = uint(clamp(depth * float(CLUSTER_COUNT_Z), 0.0, float(CLUSTER_COUNT_Z - 1u)));
+    uint cluster = (slice * CLUSTER_COUNT_Y + tile.y) * CLUSTER_COUNT_X + tile.x;
+
+    vec3 color = clustering.ambient.rgb * albedo;
+    uint count = min(clusters[cluster].count, MAX_LIGHTS_PER_CLUSTER);
+    for (uint i = 0; i < count; i++) {
+        color += shadeLight(lights[clusters[cluster].lights[i]], position, normal, viewDirection, albedo, material);
+    }
+    return color;
+}
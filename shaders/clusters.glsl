@@ -0,0 +1,30 @@
+// Cluster grid of the LightCuller, included by light_cull.comp and clustered_shading.glsl. The constants match
+// those of the LightCuller.
+
+const uint CLUSTER_COUNT_X = 16u;
+const uint CLUSTER_COUNT_Y = 9u;
+const uint CLUSTER_COUNT_Z = 24u;
+const uint MAX_LIGHTS_PER_CLUSTER = 128u;
+
+// Lights touching the cluster, at most MAX_LIGHTS_PER_CLUSTER
+struct Cluster {
+    uint count;
+    uint lights[MAX_LIGHTS_PER_CLUSTER];
+};
+
+// LightCuller::ClusteringData (std430). Tiles split the screen, slices the depth range between the near and the far
+// plane along the view axis: dot(p - nearPoint, axis) is 0 on the near plane and 1 on the far plane.
+struct Clustering {
+    mat4 inverseViewProjection;
+    vec4 nearPoint;
+    vec4 axis;
+    vec4 ambient;
+    vec2 inverseExtent;
+    uint lightCount;
+    uint padding;
+};
+
+vec3 unproject(mat4 inverseViewProjection, vec2 position, float depth) {
+    vec4 world = inverseViewProjection * vec4(position, depth, 1.0);
+    return world.xyz / world.w;
+}
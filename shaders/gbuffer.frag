@@ -0,0 +1,16 @@
+#version 450
+
+// Geometry subpass of the DeferredRenderer without bindless table, every material draws the same fixed color
+layout(location = 2) in vec3 inWorldPosition;
+
+layout(location = 0) out vec4 outAlbedo;
+layout(location = 1) out vec4 outNormal;
+layout(location = 2) out vec4 outMaterial;
+
+void main() {
+    // Flat normal of the triangle, meshes do not need normals of their own
+    vec3 normal = normalize(cross(dFdy(inWorldPosition), dFdx(inWorldPosition)));
+    outAlbedo = vec4(1.0, 0.0, 0.0, 1.0);
+    outNormal = vec4(normal * 0.5 + 0.5, 0.0);
+    outMaterial = vec4(0.5, 32.0 / 256.0, 0.0, 0.0);
+}
@@ -0,0 +1,39 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Geometry subpass of the DeferredRenderer, the material parameters of bindless.frag go into the G-buffer
+
+// Global tables of the BindlessTable, bound once per command buffer
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+// PhongMaterial parameters
+layout(std430, set = 1, binding = 1) readonly buffer Material {
+    vec4 color;
+    uint texture;
+    float specular;
+    float shininess;
+} materials[];
+
+layout(location = 0) in vec2 inTexCoord;
+layout(location = 1) flat in uint inMaterial;
+layout(location = 2) in vec3 inWorldPosition;
+
+layout(location = 0) out vec4 outAlbedo;
+layout(location = 1) out vec4 outNormal;
+layout(location = 2) out vec4 outMaterial;
+
+const uint NO_TEXTURE = 0xffffffffu;
+
+void main() {
+    outAlbedo = materials[nonuniformEXT(inMaterial)].color;
+    uint textureIndex = materials[nonuniformEXT(inMaterial)].texture;
+    if (textureIndex != NO_TEXTURE) {
+        outAlbedo *= texture(textures[nonuniformEXT(textureIndex)], inTexCoord);
+    }
+
+    // Flat normal of the triangle, meshes do not need normals of their own
+    vec3 normal = normalize(cross(dFdy(inWorldPosition), dFdx(inWorldPosition)));
+    outNormal = vec4(normal * 0.5 + 0.5, 0.0);
+    outMaterial = vec4(materials[nonuniformEXT(inMaterial)].specular,
+                       materials[nonuniformEXT(inMaterial)].shininess / 256.0, 0.0, 0.0);
+}
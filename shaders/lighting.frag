@@ -0,0 +1,57 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+// Lighting subpass of the DeferredRenderer, shades every pixel once with all lights. The G-buffer is read at
+// the current pixel only.
+
+#include "lights.glsl"
+
+layout(input_attachment_index = 0, set = 1, binding = 0) uniform subpassInput gAlbedo;
+layout(input_attachment_index = 1, set = 1, binding = 1) uniform subpassInput gNormal;
+layout(input_attachment_index = 2, set = 1, binding = 2) uniform subpassInput gMaterial;
+layout(input_attachment_index = 3, set = 1, binding = 3) uniform subpassInput gDepth;
+
+layout(std430, set = 1, binding = 4) readonly buffer Lights {
+    Light lights[];
+};
+
+// Frame constants from the uniform ring of the frame, see DeferredRenderer::LightingUniforms
+layout(set = 0, binding = 0) uniform Lighting {
+    mat4 inverseViewProjection;
+    vec4 ambient;
+    uint lightCount;
+} lighting;
+
+layout(location = 0) in vec2 inPosition;
+
+layout(location = 0) out vec4 outColor;
+
+vec3 unproject(vec2 position, float depth) {
+    vec4 world = lighting.inverseViewProjection * vec4(position, depth, 1.0);
+    return world.xyz / world.w;
+}
+
+void main() {
+    float depth = subpassLoad(gDepth).r;
+    if (depth >= 1.0) {
+        // Nothing drawn here
+        outColor = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+
+    vec3 albedo = subpassLoad(gAlbedo).rgb;
+    vec3 normal = normalize(subpassLoad(gNormal).xyz * 2.0 - 1.0);
+    vec2 material = subpassLoad(gMaterial).xy;
+
+    vec3 position = unproject(inPosition, depth);
+    // Towards the eye along the ray of this pixel, works for perspective and orthographic projections
+    vec3 viewDirection = normalize(unproject(inPosition, 0.0) - unproject(inPosition, 1.0));
+    // Derivative normals follow the winding on screen, back faces are lit from the front as well
+    normal = faceforward(normal, -viewDirection, normal);
+
+    vec3 color = lighting.ambient.rgb * albedo;
+    for (uint i = 0; i < lighting.lightCount; i++) {
+        color += shadeLight(lights[i], position, normal, viewDirection, albedo, material);
+    }
+    outColor = vec4(color, 1.0);
+}
@@ -0,0 +1,10 @@
+#version 450
+
+// Fullscreen triangle of the lighting subpass, drawn without vertex buffers. See DeferredRenderer.
+layout(location = 0) out vec2 outPosition;
+
+void main() {
+    vec2 position = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2) * 2.0 - 1.0;
+    gl_Position = vec4(position, 0.0, 1.0);
+    outPosition = position;
+}
@@ -0,0 +1,37 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+// Lighting subpass of the DeferredRenderer with clustered lighting, every pixel is shaded with the lights of its
+// cluster only. The G-buffer is read at the current pixel only.
+
+#define LIGHT_SET 2
+#include "clustered_shading.glsl"
+
+layout(input_attachment_index = 0, set = 1, binding = 0) uniform subpassInput gAlbedo;
+layout(input_attachment_index = 1, set = 1, binding = 1) uniform subpassInput gNormal;
+layout(input_attachment_index = 2, set = 1, binding = 2) uniform subpassInput gMaterial;
+layout(input_attachment_index = 3, set = 1, binding = 3) uniform subpassInput gDepth;
+
+layout(location = 0) in vec2 inPosition;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    float depth = subpassLoad(gDepth).r;
+    if (depth >= 1.0) {
+        // Nothing drawn here
+        outColor = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+
+    vec3 albedo = subpassLoad(gAlbedo).rgb;
+    vec3 normal = normalize(subpassLoad(gNormal).xyz * 2.0 - 1.0);
+    vec2 material = subpassLoad(gMaterial).xy;
+
+    vec3 position = unproject(clustering.inverseViewProjection, inPosition, depth);
+    vec3 viewDirection = viewDirectionAt(inPosition);
+    // Derivative normals follow the winding on screen, back faces are lit from the front as well
+    normal = faceforward(normal, -viewDirection, normal);
+
+    outColor = vec4(shadeClustered(position, normal, viewDirection, albedo, material), 1.0);
+}
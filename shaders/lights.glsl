@@ -0,0 +1,36 @@
+// Light and the shading of one light, included by the lighting shaders
+
+// Light (std430)
+struct Light {
+    vec3 position;
+    float radius;
+    vec3 color;
+    float intensity;
+    vec3 direction;
+    // Point lights have -1
+    float spotCosine;
+};
+
+// Blinn-Phong, fading out quadratically towards the radius. material.x is the specular strength, material.y the
+// shininess / 256 (see the G-buffer shaders).
+vec3 shadeLight(Light light, vec3 position, vec3 normal, vec3 viewDirection, vec3 albedo, vec2 material) {
+    vec3 toLight = light.position - position;
+    float distance = length(toLight);
+    if (distance >= light.radius) {
+        return vec3(0.0);
+    }
+    vec3 lightDirection = toLight / max(distance, 1e-4);
+    float attenuation = 1.0 - distance / light.radius;
+    attenuation *= attenuation;
+    if (light.spotCosine > -1.0) {
+        // Soft edge over the outer tenth of the cone
+        float cosine = dot(-lightDirection, light.direction);
+        attenuation *= smoothstep(light.spotCosine, mix(light.spotCosine, 1.0, 0.1), cosine);
+    }
+
+    float diffuse = max(dot(normal, lightDirection), 0.0);
+    vec3 halfway = normalize(lightDirection + viewDirection);
+    float shininess = max(material.y * 256.0, 1.0);
+    float specular = material.x * pow(max(dot(normal, halfway), 0.0), shininess);
+    return (albedo * diffuse + specular) * light.color * light.intensity * attenuation;
+}
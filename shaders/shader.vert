@@ -1,11 +1,15 @@
 #version 450
 
-vec2 positions[3] = vec2[](
-    vec2(0.0, -0.5),
-    vec2(0.5, 0.5),
-    vec2(-0.5, 0.5)
-);
+layout(location = 0) in vec3 inPosition;
+
+// Per instance, see InstanceData
+layout(location = 11) in mat4 inTransform;
+
+// Frame constants from the uniform ring of the frame, see Engine
+layout(set = 0, binding = 0) uniform Frame {
+    mat4 viewProjection;
+} frame;
 
 void main() {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
+    gl_Position = frame.viewProjection * inTransform * vec4(inPosition, 1.0);
 }
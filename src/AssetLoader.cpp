@@ -0,0 +1,52 @@
+#include "AssetLoader.h"
+
+#include <algorithm>
+
+#include "ImageData.h"
+#include "ResourceManager.h"
+#include "VertexData.h"
+
+AssetLoader::AssetLoader(ResourceManager &rResourceManager)
+    : rResourceManager_(rResourceManager),
+      threadPool_(std::clamp(std::thread::hardware_concurrency(), 1u, MAX_WORKER_THREADS)) {}
+
+template <typename T, typename Function>
+AssetHandle<T> AssetLoader::submit(Priority priority, Function &&rrLoad) {
+    AssetHandle<T> handle;
+    handle.spState_ = std::make_shared<AssetState<T>>();
+
+    // Worker only keeps a weak reference, so dropping all handles cancels the load
+    std::weak_ptr<AssetState<T>> wpState = handle.spState_;
+    threadPool_.Submit(priority, [wpState, load = std::forward<Function>(rrLoad)]() {
+        std::shared_ptr<AssetState<T>> spState = wpState.lock();
+        if (spState == nullptr) {
+            return;
+        }
+        if (!spState->cancelled) {
+            try {
+                spState->spAsset = load();
+            } catch (...) {
+                spState->exception = std::current_exception();
+            }
+        }
+        spState->ready.store(true, std::memory_order_release);
+    });
+    return handle;
+}
+
+AssetHandle<std::vector<char>> AssetLoader::ReadBinaryFileAsync(const std::filesystem::path &rFilePath,
+                                                                Priority priority) {
+    return submit<std::vector<char>>(priority, [filePath = rFilePath]() {
+        return std::make_shared<std::vector<char>>(ResourceManager::ReadBinaryFile(filePath));
+    });
+}
+
+AssetHandle<VertexData> AssetLoader::LoadVertexDataAsync(const std::filesystem::path &rFilePath, Priority priority) {
+    return submit<VertexData>(priority,
+                              [this, filePath = rFilePath]() { return rResourceManager_.LoadVertexData(filePath); });
+}
+
+AssetHandle<ImageData> AssetLoader::LoadImageDataAsync(const std::filesystem::path &rFilePath, Priority priority) {
+    return submit<ImageData>(priority,
+                             [filePath = rFilePath]() { return ResourceManager::LoadImageDataFromFile(filePath); });
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "ThreadPool.h"
+
+class ResourceManager;
+struct VertexData;
+struct ImageData;
+
+/**
+ * @brief Shared state of one asynchronous load, written once by a worker and then read by the owning thread.
+ */
+template <typename T>
+struct AssetState {
+    std::atomic<bool> cancelled = false;
+    std::atomic<bool> ready = false;
+    std::shared_ptr<T> spAsset;
+    std::exception_ptr exception;
+};
+
+/**
+ * @brief Handle of an asset loaded in the background. Loads that did not start yet are cancelled when the last
+ * handle is destroyed or Cancel() is called.
+ */
+template <typename T>
+class AssetHandle {
+public:
+    AssetHandle() = default;
+
+    bool IsValid() const { return spState_ != nullptr; }
+    bool IsReady() const { return spState_ != nullptr && spState_->ready.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Returns the asset once loaded, nullptr while loading or if cancelled. Rethrows errors of the load.
+     */
+    std::shared_ptr<T> Get() const {
+        if (!IsReady()) {
+            return nullptr;
+        }
+        if (spState_->exception) {
+            std::rethrow_exception(spState_->exception);
+        }
+        return spState_->spAsset;
+    }
+
+    void Cancel() {
+        if (spState_ != nullptr) {
+            spState_->cancelled = true;
+        }
+    }
+
+    void Reset() { spState_ = nullptr; }
+
+private:
+    friend class AssetLoader;
+
+    std::shared_ptr<AssetState<T>> spState_;
+};
+
+/**
+ * @brief Loads files and decodes assets on a bounded pool of worker threads, so the frame loop never waits for disk.
+ */
+class AssetLoader final {
+public:
+    using Priority = ThreadPool::Priority;
+
+    static constexpr uint32_t MAX_WORKER_THREADS = 4u;
+
+public:
+    explicit AssetLoader(ResourceManager &rResourceManager);
+
+    AssetHandle<std::vector<char>> ReadBinaryFileAsync(const std::filesystem::path &rFilePath,
+                                                       Priority priority = Priority::Normal);
+    AssetHandle<VertexData> LoadVertexDataAsync(const std::filesystem::path &rFilePath,
+                                                Priority priority = Priority::Normal);
+    AssetHandle<ImageData> LoadImageDataAsync(const std::filesystem::path &rFilePath,
+                                              Priority priority = Priority::Normal);
+
+    size_t GetPendingCount() const { return threadPool_.GetPendingJobCount(); }
+
+private:
+    template <typename T, typename Function>
+    AssetHandle<T> submit(Priority priority, Function &&rrLoad);
+
+private:
+    ResourceManager &rResourceManager_;
+    ThreadPool threadPool_;
+};
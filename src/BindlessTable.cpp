@@ -0,0 +1,163 @@
+#include "BindlessTable.h"
+
+#include <array>
+#include <stdexcept>
+#include <string>
+
+#include "DeviceContext.h"
+
+namespace {
+// Slots may be written while the set is bound in pending command buffers, as long as those do not read them
+constexpr VkDescriptorBindingFlags BINDING_FLAGS = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                                                   VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
+                                                   VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+}  // namespace
+
+BindlessTable::BindlessTable(DeviceContext &rDeviceContext, uint32_t maxTextures, uint32_t maxBuffers)
+    : rDeviceContext_(rDeviceContext) {
+    textures_.capacity = maxTextures;
+    buffers_.capacity = maxBuffers;
+    VkDevice device = rDeviceContext_.GetDevice();
+
+    std::vector<VkDescriptorSetLayoutBinding> bindings(2);
+    bindings[TEXTURE_BINDING].binding = TEXTURE_BINDING;
+    bindings[TEXTURE_BINDING].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[TEXTURE_BINDING].descriptorCount = textures_.capacity;
+    bindings[TEXTURE_BINDING].stageFlags = VK_SHADER_STAGE_ALL;
+    bindings[BUFFER_BINDING].binding = BUFFER_BINDING;
+    bindings[BUFFER_BINDING].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[BUFFER_BINDING].descriptorCount = buffers_.capacity;
+    bindings[BUFFER_BINDING].stageFlags = VK_SHADER_STAGE_ALL;
+    spSetLayout_ = std::make_shared<const DescriptorSetLayout>(device, bindings,
+                                                               std::vector<VkDescriptorBindingFlags>(2, BINDING_FLAGS));
+
+    std::array<VkDescriptorPoolSize, 2> poolSizes = {{
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, textures_.capacity},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, buffers_.capacity},
+    }};
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool_) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create bindless descriptor pool!");
+    }
+
+    VkDescriptorSetLayout setLayout = spSetLayout_->GetHandle();
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool_;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &setLayout;
+    if (vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet_) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate bindless descriptor set!");
+    }
+
+    // One sampler for all textures, so a texture is a single index
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+    if (vkCreateSampler(device, &samplerInfo, nullptr, &sampler_) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create bindless sampler!");
+    }
+}
+
+BindlessTable::~BindlessTable() {
+    // The set is freed with its pool
+    vkDestroySampler(rDeviceContext_.GetDevice(), sampler_, nullptr);
+    vkDestroyDescriptorPool(rDeviceContext_.GetDevice(), descriptorPool_, nullptr);
+}
+
+uint32_t BindlessTable::AddTexture(VkImageView imageView) {
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.sampler = sampler_;
+    imageInfo.imageView = imageView;
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkWriteDescriptorSet descriptorWrite{};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = descriptorSet_;
+    descriptorWrite.dstBinding = TEXTURE_BINDING;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrite.pImageInfo = &imageInfo;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    descriptorWrite.dstArrayElement = allocate(textures_, "texture");
+    vkUpdateDescriptorSets(rDeviceContext_.GetDevice(), 1, &descriptorWrite, 0, nullptr);
+    return descriptorWrite.dstArrayElement;
+}
+
+uint32_t BindlessTable::AddBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+    VkDescriptorBufferInfo bufferInfo{buffer, offset, range};
+
+    VkWriteDescriptorSet descriptorWrite{};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = descriptorSet_;
+    descriptorWrite.dstBinding = BUFFER_BINDING;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorWrite.pBufferInfo = &bufferInfo;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    descriptorWrite.dstArrayElement = allocate(buffers_, "buffer");
+    vkUpdateDescriptorSets(rDeviceContext_.GetDevice(), 1, &descriptorWrite, 0, nullptr);
+    return descriptorWrite.dstArrayElement;
+}
+
+void BindlessTable::RemoveTexture(uint32_t index) {
+    // Partially bound, the stale descriptor is never read and simply overwritten on reuse
+    std::lock_guard<std::mutex> lock(mutex_);
+    textures_.free.push_back(index);
+}
+
+void BindlessTable::RemoveBuffer(uint32_t index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffers_.free.push_back(index);
+}
+
+void BindlessTable::Bind(VkCommandBuffer &rCommandBuffer, VkPipelineLayout pipelineLayout) const {
+    vkCmdBindDescriptorSets(rCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, SET, 1, &descriptorSet_,
+                            0, nullptr);
+}
+
+uint32_t BindlessTable::allocate(Slots &rSlots, const char *pName) {
+    if (!rSlots.free.empty()) {
+        uint32_t index = rSlots.free.back();
+        rSlots.free.pop_back();
+        return index;
+    }
+    if (rSlots.count == rSlots.capacity) {
+        throw std::runtime_error(std::string("failed to add bindless ") + pName + ", table is full!");
+    }
+    return rSlots.count++;
+}
+
+BindlessBuffer::BindlessBuffer(DeviceContext &rDeviceContext, VkDeviceSize size) : rDeviceContext_(rDeviceContext) {
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(rDeviceContext_.GetDevice(), &bufferInfo, nullptr, &buffer_) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create bindless buffer!");
+    }
+    allocation_ = rDeviceContext_.GetMemoryAllocator().AllocateBufferMemory(
+        buffer_, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    index_ = rDeviceContext_.GetBindlessTable()->AddBuffer(buffer_, 0, size);
+}
+
+BindlessBuffer::~BindlessBuffer() {
+    rDeviceContext_.GetBindlessTable()->RemoveBuffer(index_);
+    vkDestroyBuffer(rDeviceContext_.GetDevice(), buffer_, nullptr);
+    rDeviceContext_.GetMemoryAllocator().Free(allocation_);
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "MemoryAllocator.h"
+#include "PipelineLayout.h"
+
+class DeviceContext;
+
+/**
+ * @brief Global descriptor tables for bindless drawing. Every texture and storage buffer is written once into large
+ * update-after-bind arrays of a single descriptor set, which is bound once per command buffer. Shaders pick their
+ * resources by index (see shaders/bindless.frag), so draws need no descriptor binds of their own.
+ * Only exists if the device supports descriptor indexing, see DeviceContext::GetBindlessTable.
+ */
+class BindlessTable final {
+public:
+    /// Set 0 holds the frame uniforms (FrameContext::UNIFORM_SET)
+    static constexpr uint32_t SET = 1;
+    static constexpr uint32_t TEXTURE_BINDING = 0;
+    static constexpr uint32_t BUFFER_BINDING = 1;
+    /// Capacity of each array, clamped to the device limits
+    static constexpr uint32_t MAX_TEXTURES = 4096u;
+    static constexpr uint32_t MAX_BUFFERS = 4096u;
+    static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+public:
+    BindlessTable(DeviceContext &rDeviceContext, uint32_t maxTextures, uint32_t maxBuffers);
+    ~BindlessTable();
+
+    BindlessTable(const BindlessTable &) = delete;
+    BindlessTable &operator=(const BindlessTable &) = delete;
+
+    /**
+     * @brief Writes the view (sampled in shader read only layout with the linear sampler of the table) into a free
+     * slot. Thread safe.
+     * @return index in the texture array
+     */
+    uint32_t AddTexture(VkImageView imageView);
+
+    /**
+     * @brief Writes the storage buffer range into a free slot. Thread safe.
+     * @return index in the buffer array
+     */
+    uint32_t AddBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+
+    /**
+     * @brief Frees the slot for reuse. Only call once no frame in flight reads it, e.g. while destroying the resource.
+     */
+    void RemoveTexture(uint32_t index);
+    void RemoveBuffer(uint32_t index);
+
+    const std::shared_ptr<const DescriptorSetLayout> &GetSetLayout() const { return spSetLayout_; }
+
+    /**
+     * @brief Binds the table as SET of the layout, it stays bound across pipelines with compatible layouts.
+     */
+    void Bind(VkCommandBuffer &rCommandBuffer, VkPipelineLayout pipelineLayout) const;
+
+private:
+    struct Slots {
+        uint32_t capacity = 0;
+        uint32_t count = 0;
+        std::vector<uint32_t> free;
+    };
+
+    uint32_t allocate(Slots &rSlots, const char *pName);
+
+private:
+    DeviceContext &rDeviceContext_;
+
+    std::shared_ptr<const DescriptorSetLayout> spSetLayout_;
+    VkDescriptorPool descriptorPool_ = VK_NULL_HANDLE;
+    VkDescriptorSet descriptorSet_ = VK_NULL_HANDLE;
+    VkSampler sampler_ = VK_NULL_HANDLE;
+
+    // Guards the slots and descriptor writes, resources may be created on loader threads
+    std::mutex mutex_;
+    Slots textures_;
+    Slots buffers_;
+};
+
+/**
+ * @brief Host visible storage buffer registered in the bindless table, e.g. the parameters of one material.
+ * Shaders read it through its index, it must outlive the frames that do (see FrameContext::Retain).
+ */
+class BindlessBuffer final {
+public:
+    BindlessBuffer(DeviceContext &rDeviceContext, VkDeviceSize size);
+    ~BindlessBuffer();
+
+    BindlessBuffer(const BindlessBuffer &) = delete;
+    BindlessBuffer &operator=(const BindlessBuffer &) = delete;
+
+    uint32_t GetIndex() const { return index_; }
+    /// Persistently mapped and coherent
+    void *GetData() const { return allocation_.pMapped; }
+
+private:
+    DeviceContext &rDeviceContext_;
+    VkBuffer buffer_ = VK_NULL_HANDLE;
+    MemoryAllocator::Allocation allocation_;
+    uint32_t index_ = BindlessTable::INVALID_INDEX;
+};
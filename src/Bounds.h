@@ -0,0 +1,60 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/**
+ * @brief World space axis aligned box and bounding sphere of an object, both are tested while culling.
+ */
+struct Bounds {
+    glm::vec3 min;
+    glm::vec3 max;
+    glm::vec3 center;
+    float radius;
+
+    /**
+     * @brief Bounds of objects whose extent is not known yet, they are never culled.
+     */
+    static Bounds Infinite() {
+        const float infinity = std::numeric_limits<float>::infinity();
+        return Bounds{glm::vec3(-infinity), glm::vec3(infinity), glm::vec3(0.0f), infinity};
+    }
+
+    bool IsFinite() const { return std::isfinite(radius); }
+
+    /**
+     * @brief Bounds enclosing these bounds after the affine transform, the box stays axis aligned and grows when
+     * rotated. Infinite bounds stay infinite.
+     */
+    Bounds Transformed(const glm::mat4 &rTransform) const {
+        if (!IsFinite()) {
+            return *this;
+        }
+
+        const glm::vec3 boxCenter = (min + max) * 0.5f;
+        const glm::vec3 halfExtent = (max - min) * 0.5f;
+        Bounds bounds = *this;
+        float maxScaleSquared = 0.0f;
+        for (int row = 0; row < 3; row++) {
+            float newBoxCenter = rTransform[3][row];
+            float newHalfExtent = 0.0f;
+            float newSphereCenter = rTransform[3][row];
+            for (int column = 0; column < 3; column++) {
+                newBoxCenter += rTransform[column][row] * boxCenter[column];
+                newHalfExtent += std::abs(rTransform[column][row]) * halfExtent[column];
+                newSphereCenter += rTransform[column][row] * center[column];
+            }
+            bounds.min[row] = newBoxCenter - newHalfExtent;
+            bounds.max[row] = newBoxCenter + newHalfExtent;
+            bounds.center[row] = newSphereCenter;
+
+            const glm::vec4 &rAxis = rTransform[row];
+            maxScaleSquared = std::max(maxScaleSquared, rAxis.x * rAxis.x + rAxis.y * rAxis.y + rAxis.z * rAxis.z);
+        }
+        bounds.radius = radius * std::sqrt(maxScaleSquared);
+        return bounds;
+    }
+};
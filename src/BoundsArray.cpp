@@ -0,0 +1,216 @@
+#include "BoundsArray.h"
+
+#include <array>
+#include <bit>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BOUNDS_ARRAY_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BOUNDS_ARRAY_SSE
+#endif
+
+namespace {
+/**
+ * @brief A frustum plane with the box corner furthest along its normal, the corner is selected per plane by the
+ * signs of the normal, so the inner loops only pick the arrays to load from.
+ */
+struct CullPlane {
+    float x, y, z, w;
+    const float *pBoxX;
+    const float *pBoxY;
+    const float *pBoxZ;
+};
+
+using CullPlanes = std::array<CullPlane, 6>;
+
+CullPlanes makeCullPlanes(const Frustum &rFrustum, const std::vector<float> &rMinX, const std::vector<float> &rMinY,
+                          const std::vector<float> &rMinZ, const std::vector<float> &rMaxX,
+                          const std::vector<float> &rMaxY, const std::vector<float> &rMaxZ) {
+    CullPlanes planes;
+    for (size_t i = 0; i < planes.size(); i++) {
+        const glm::vec4 &rPlane = rFrustum.GetPlanes()[i];
+        planes[i] = CullPlane{rPlane.x,
+                              rPlane.y,
+                              rPlane.z,
+                              rPlane.w,
+                              rPlane.x >= 0.0f ? rMaxX.data() : rMinX.data(),
+                              rPlane.y >= 0.0f ? rMaxY.data() : rMinY.data(),
+                              rPlane.z >= 0.0f ? rMaxZ.data() : rMinZ.data()};
+    }
+    return planes;
+}
+
+/// Appends the indices of the set bits of mask, lowest first
+uint32_t *writeVisible(uint32_t mask, uint32_t base, uint32_t *pVisible) {
+    while (mask != 0) {
+        *pVisible++ = base + static_cast<uint32_t>(std::countr_zero(mask));
+        mask &= mask - 1;
+    }
+    return pVisible;
+}
+}  // namespace
+
+const char *BoundsArray::GetSimdName() {
+#if defined(BOUNDS_ARRAY_AVX2)
+    return "AVX2";
+#elif defined(BOUNDS_ARRAY_SSE)
+    return "SSE";
+#else
+    return "scalar";
+#endif
+}
+
+uint32_t BoundsArray::Add(const Bounds &rBounds) {
+    uint32_t index = static_cast<uint32_t>(GetSize());
+    minX_.push_back(rBounds.min.x);
+    minY_.push_back(rBounds.min.y);
+    minZ_.push_back(rBounds.min.z);
+    maxX_.push_back(rBounds.max.x);
+    maxY_.push_back(rBounds.max.y);
+    maxZ_.push_back(rBounds.max.z);
+    centerX_.push_back(rBounds.center.x);
+    centerY_.push_back(rBounds.center.y);
+    centerZ_.push_back(rBounds.center.z);
+    radius_.push_back(rBounds.radius);
+    return index;
+}
+
+void BoundsArray::Set(uint32_t index, const Bounds &rBounds) {
+    minX_[index] = rBounds.min.x;
+    minY_[index] = rBounds.min.y;
+    minZ_[index] = rBounds.min.z;
+    maxX_[index] = rBounds.max.x;
+    maxY_[index] = rBounds.max.y;
+    maxZ_[index] = rBounds.max.z;
+    centerX_[index] = rBounds.center.x;
+    centerY_[index] = rBounds.center.y;
+    centerZ_[index] = rBounds.center.z;
+    radius_[index] = rBounds.radius;
+}
+
+Bounds BoundsArray::Get(uint32_t index) const {
+    return Bounds{glm::vec3(minX_[index], minY_[index], minZ_[index]),
+                  glm::vec3(maxX_[index], maxY_[index], maxZ_[index]),
+                  glm::vec3(centerX_[index], centerY_[index], centerZ_[index]), radius_[index]};
+}
+
+void BoundsArray::Remove(uint32_t index) {
+    uint32_t last = static_cast<uint32_t>(GetSize()) - 1;
+    if (index != last) {
+        Set(index, Get(last));
+    }
+    for (std::vector<float> *pArray :
+         {&minX_, &minY_, &minZ_, &maxX_, &maxY_, &maxZ_, &centerX_, &centerY_, &centerZ_, &radius_}) {
+        pArray->pop_back();
+    }
+}
+
+void BoundsArray::Clear() {
+    for (std::vector<float> *pArray :
+         {&minX_, &minY_, &minZ_, &maxX_, &maxY_, &maxZ_, &centerX_, &centerY_, &centerZ_, &radius_}) {
+        pArray->clear();
+    }
+}
+
+void BoundsArray::Cull(const Frustum &rFrustum, std::vector<uint32_t> &rVisible) const {
+    const uint32_t size = static_cast<uint32_t>(GetSize());
+    rVisible.resize(size);
+    uint32_t *pVisible = rVisible.data();
+    uint32_t index = 0;
+
+#if defined(BOUNDS_ARRAY_AVX2) || defined(BOUNDS_ARRAY_SSE)
+    const CullPlanes planes = makeCullPlanes(rFrustum, minX_, minY_, minZ_, maxX_, maxY_, maxZ_);
+#endif
+
+#if defined(BOUNDS_ARRAY_AVX2)
+    const __m256 zero = _mm256_setzero_ps();
+    for (; index + 8 <= size; index += 8) {
+        const __m256 centerX = _mm256_loadu_ps(centerX_.data() + index);
+        const __m256 centerY = _mm256_loadu_ps(centerY_.data() + index);
+        const __m256 centerZ = _mm256_loadu_ps(centerZ_.data() + index);
+        const __m256 negativeRadius = _mm256_sub_ps(zero, _mm256_loadu_ps(radius_.data() + index));
+
+        __m256 outside = zero;
+        for (const CullPlane &rPlane : planes) {
+            const __m256 planeX = _mm256_set1_ps(rPlane.x);
+            const __m256 planeY = _mm256_set1_ps(rPlane.y);
+            const __m256 planeZ = _mm256_set1_ps(rPlane.z);
+            const __m256 planeW = _mm256_set1_ps(rPlane.w);
+
+            __m256 sphereDistance = _mm256_add_ps(_mm256_mul_ps(planeX, centerX), planeW);
+            sphereDistance = _mm256_add_ps(_mm256_mul_ps(planeY, centerY), sphereDistance);
+            sphereDistance = _mm256_add_ps(_mm256_mul_ps(planeZ, centerZ), sphereDistance);
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(sphereDistance, negativeRadius, _CMP_LT_OQ));
+
+            __m256 boxDistance = _mm256_add_ps(_mm256_mul_ps(planeX, _mm256_loadu_ps(rPlane.pBoxX + index)), planeW);
+            boxDistance = _mm256_add_ps(_mm256_mul_ps(planeY, _mm256_loadu_ps(rPlane.pBoxY + index)), boxDistance);
+            boxDistance = _mm256_add_ps(_mm256_mul_ps(planeZ, _mm256_loadu_ps(rPlane.pBoxZ + index)), boxDistance);
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(boxDistance, zero, _CMP_LT_OQ));
+        }
+        uint32_t insideMask = ~static_cast<uint32_t>(_mm256_movemask_ps(outside)) & 0xffu;
+        pVisible = writeVisible(insideMask, index, pVisible);
+    }
+#elif defined(BOUNDS_ARRAY_SSE)
+    const __m128 zero = _mm_setzero_ps();
+    for (; index + 4 <= size; index += 4) {
+        const __m128 centerX = _mm_loadu_ps(centerX_.data() + index);
+        const __m128 centerY = _mm_loadu_ps(centerY_.data() + index);
+        const __m128 centerZ = _mm_loadu_ps(centerZ_.data() + index);
+        const __m128 negativeRadius = _mm_sub_ps(zero, _mm_loadu_ps(radius_.data() + index));
+
+        __m128 outside = zero;
+        for (const CullPlane &rPlane : planes) {
+            const __m128 planeX = _mm_set1_ps(rPlane.x);
+            const __m128 planeY = _mm_set1_ps(rPlane.y);
+            const __m128 planeZ = _mm_set1_ps(rPlane.z);
+            const __m128 planeW = _mm_set1_ps(rPlane.w);
+
+            __m128 sphereDistance = _mm_add_ps(_mm_mul_ps(planeX, centerX), planeW);
+            sphereDistance = _mm_add_ps(_mm_mul_ps(planeY, centerY), sphereDistance);
+            sphereDistance = _mm_add_ps(_mm_mul_ps(planeZ, centerZ), sphereDistance);
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(sphereDistance, negativeRadius));
+
+            __m128 boxDistance = _mm_add_ps(_mm_mul_ps(planeX, _mm_loadu_ps(rPlane.pBoxX + index)), planeW);
+            boxDistance = _mm_add_ps(_mm_mul_ps(planeY, _mm_loadu_ps(rPlane.pBoxY + index)), boxDistance);
+            boxDistance = _mm_add_ps(_mm_mul_ps(planeZ, _mm_loadu_ps(rPlane.pBoxZ + index)), boxDistance);
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(boxDistance, zero));
+        }
+        uint32_t insideMask = ~static_cast<uint32_t>(_mm_movemask_ps(outside)) & 0xfu;
+        pVisible = writeVisible(insideMask, index, pVisible);
+    }
+#endif
+
+    pVisible += cullScalar(rFrustum, index, size, pVisible);
+    rVisible.resize(static_cast<size_t>(pVisible - rVisible.data()));
+}
+
+void BoundsArray::CullScalar(const Frustum &rFrustum, std::vector<uint32_t> &rVisible) const {
+    const uint32_t size = static_cast<uint32_t>(GetSize());
+    rVisible.resize(size);
+    rVisible.resize(cullScalar(rFrustum, 0, size, rVisible.data()));
+}
+
+uint32_t BoundsArray::cullScalar(const Frustum &rFrustum, uint32_t begin, uint32_t end, uint32_t *pVisible) const {
+    const CullPlanes planes = makeCullPlanes(rFrustum, minX_, minY_, minZ_, maxX_, maxY_, maxZ_);
+    uint32_t count = 0;
+    for (uint32_t index = begin; index < end; index++) {
+        bool outside = false;
+        for (const CullPlane &rPlane : planes) {
+            // Same order of operations as the vector code, so both agree on bounds touching a plane
+            float sphereDistance = rPlane.x * centerX_[index] + rPlane.w;
+            sphereDistance = rPlane.y * centerY_[index] + sphereDistance;
+            sphereDistance = rPlane.z * centerZ_[index] + sphereDistance;
+            float boxDistance = rPlane.x * rPlane.pBoxX[index] + rPlane.w;
+            boxDistance = rPlane.y * rPlane.pBoxY[index] + boxDistance;
+            boxDistance = rPlane.z * rPlane.pBoxZ[index] + boxDistance;
+            // Comparisons with NaN (infinite bounds on a plane through an axis) are false, so those stay visible
+            outside |= sphereDistance < -radius_[index] || boxDistance < 0.0f;
+        }
+        if (!outside) {
+            pVisible[count++] = index;
+        }
+    }
+    return count;
+}
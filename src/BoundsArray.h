@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Bounds.h"
+#include "Frustum.h"
+
+/**
+ * @brief Bounds of many objects stored as structure of arrays, so culling tests 4 (SSE) or 8 (AVX2) objects with
+ * each instruction. Indices are dense, removing swaps the last element into the hole.
+ */
+class BoundsArray final {
+public:
+    /// Name of the culling implementation compiled in, "AVX2", "SSE" or "scalar"
+    static const char *GetSimdName();
+
+    uint32_t Add(const Bounds &rBounds);
+    void Set(uint32_t index, const Bounds &rBounds);
+    Bounds Get(uint32_t index) const;
+
+    /**
+     * @brief Removes the bounds at index by moving the last bounds there.
+     */
+    void Remove(uint32_t index);
+
+    void Clear();
+    size_t GetSize() const { return radius_.size(); }
+
+    /**
+     * @brief Writes the indices of all bounds intersecting the frustum in ascending order.
+     * Both the box and the sphere have to intersect, bounds outside one plane are culled (conservative at corners).
+     */
+    void Cull(const Frustum &rFrustum, std::vector<uint32_t> &rVisible) const;
+
+    /**
+     * @brief Same result as Cull without SIMD, also used for the elements left over after the last full vector.
+     */
+    void CullScalar(const Frustum &rFrustum, std::vector<uint32_t> &rVisible) const;
+
+private:
+    uint32_t cullScalar(const Frustum &rFrustum, uint32_t begin, uint32_t end, uint32_t *pVisible) const;
+
+private:
+    std::vector<float> minX_, minY_, minZ_;
+    std::vector<float> maxX_, maxY_, maxZ_;
+    std::vector<float> centerX_, centerY_, centerZ_;
+    std::vector<float> radius_;
+};
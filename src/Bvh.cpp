@@ -0,0 +1,502 @@
+#include "Bvh.h"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace {
+constexpr uint32_t SAH_BINS = 16;
+// Rebuild once this many links and updates happened (plus a quarter of the leaf count)
+constexpr size_t MIN_CHANGES_FOR_REBUILD = 64;
+// Deeper than this the build splits at the median, so degenerate inputs cannot split off one leaf at a time
+constexpr uint32_t MAX_SAH_DEPTH = 64;
+// Bit i set while a subtree can still be outside frustum plane i
+constexpr uint32_t ALL_PLANES = 0x3fu;
+
+Bvh::Aabb unite(const Bvh::Aabb &rA, const Bvh::Aabb &rB) {
+    return Bvh::Aabb{glm::min(rA.min, rB.min), glm::max(rA.max, rB.max)};
+}
+
+bool equal(const Bvh::Aabb &rA, const Bvh::Aabb &rB) {
+    return rA.min.x == rB.min.x && rA.min.y == rB.min.y && rA.min.z == rB.min.z && rA.max.x == rB.max.x &&
+           rA.max.y == rB.max.y && rA.max.z == rB.max.z;
+}
+
+/// Half the surface area, the factor cancels in all cost comparisons
+float area(const Bvh::Aabb &rBox) {
+    glm::vec3 extent = rBox.max - rBox.min;
+    return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+}
+
+glm::vec3 centroid(const Bvh::Aabb &rBox) { return (rBox.min + rBox.max) * 0.5f; }
+
+Bvh::Aabb emptyBox() {
+    const float infinity = std::numeric_limits<float>::infinity();
+    return Bvh::Aabb{glm::vec3(infinity), glm::vec3(-infinity)};
+}
+
+/**
+ * @brief Tests the box against the planes set in rPlaneMask, clears the bits of planes the box is fully inside.
+ * @return true if the box is fully outside one of the planes
+ */
+bool isOutside(const std::array<glm::vec4, 6> &rPlanes, const Bvh::Aabb &rBox, uint32_t &rPlaneMask) {
+    for (uint32_t i = 0; i < rPlanes.size(); i++) {
+        if ((rPlaneMask & (1u << i)) == 0) {
+            continue;
+        }
+        const glm::vec4 &rPlane = rPlanes[i];
+        // Corners furthest along and against the normal
+        glm::vec3 positive(rPlane.x >= 0.0f ? rBox.max.x : rBox.min.x, rPlane.y >= 0.0f ? rBox.max.y : rBox.min.y,
+                           rPlane.z >= 0.0f ? rBox.max.z : rBox.min.z);
+        glm::vec3 negative(rPlane.x >= 0.0f ? rBox.min.x : rBox.max.x, rPlane.y >= 0.0f ? rBox.min.y : rBox.max.y,
+                           rPlane.z >= 0.0f ? rBox.min.z : rBox.max.z);
+        if (rPlane.x * positive.x + rPlane.y * positive.y + rPlane.z * positive.z + rPlane.w < 0.0f) {
+            return true;
+        }
+        if (rPlane.x * negative.x + rPlane.y * negative.y + rPlane.z * negative.z + rPlane.w >= 0.0f) {
+            rPlaneMask &= ~(1u << i);
+        }
+    }
+    return false;
+}
+
+bool intersectsSphere(const Bvh::Aabb &rBox, const glm::vec3 &rCenter, float radiusSquared) {
+    glm::vec3 offset = glm::max(rBox.min - rCenter, glm::vec3(0.0f)) + glm::max(rCenter - rBox.max, glm::vec3(0.0f));
+    return offset.x * offset.x + offset.y * offset.y + offset.z * offset.z <= radiusSquared;
+}
+
+/**
+ * @brief Entry distance of the ray into the box, infinity if it misses or enters beyond maxDistance.
+ */
+float intersectRay(const Bvh::Aabb &rBox, const glm::vec3 &rOrigin, const glm::vec3 &rInverseDirection,
+                   float maxDistance) {
+    float entry = 0.0f;
+    float exit = maxDistance;
+    for (int axis = 0; axis < 3; axis++) {
+        float near = (rBox.min[axis] - rOrigin[axis]) * rInverseDirection[axis];
+        float far = (rBox.max[axis] - rOrigin[axis]) * rInverseDirection[axis];
+        if (near > far) {
+            std::swap(near, far);
+        }
+        entry = std::max(entry, near);
+        exit = std::min(exit, far);
+    }
+    return entry <= exit ? entry : std::numeric_limits<float>::infinity();
+}
+}  // namespace
+
+uint32_t Bvh::Insert(const Aabb &rBox, uint32_t userData) {
+    const uint32_t leaf = allocateNode();
+    nodes_[leaf].box = rBox;
+    nodes_[leaf].userData = userData;
+    nodes_[leaf].parent = UNLINKED;
+    nodes_[leaf].right = static_cast<uint32_t>(unlinked_.size());
+    unlinked_.push_back(leaf);
+    leafCount_++;
+    return leaf;
+}
+
+void Bvh::Remove(uint32_t leaf) {
+    const uint32_t parent = nodes_[leaf].parent;
+    freeNode(leaf);
+    leafCount_--;
+
+    if (parent == UNLINKED) {
+        const uint32_t position = nodes_[leaf].right;
+        unlinked_[position] = unlinked_.back();
+        nodes_[unlinked_[position]].right = position;
+        unlinked_.pop_back();
+        return;
+    }
+    if (parent == INVALID_NODE) {
+        root_ = INVALID_NODE;
+        return;
+    }
+
+    // The sibling takes the place of the parent
+    const uint32_t grandParent = nodes_[parent].parent;
+    const uint32_t sibling = nodes_[parent].left == leaf ? nodes_[parent].right : nodes_[parent].left;
+    nodes_[sibling].parent = grandParent;
+    if (grandParent == INVALID_NODE) {
+        root_ = sibling;
+    } else {
+        (nodes_[grandParent].left == parent ? nodes_[grandParent].left : nodes_[grandParent].right) = sibling;
+        refit(grandParent);
+    }
+    freeNode(parent);
+}
+
+void Bvh::Update(uint32_t leaf, const Aabb &rBox) {
+    nodes_[leaf].box = rBox;
+    if (nodes_[leaf].parent != UNLINKED) {
+        refit(nodes_[leaf].parent);
+        changes_++;
+    }
+}
+
+void Bvh::Optimize() {
+    if (changes_ + unlinked_.size() > MIN_CHANGES_FOR_REBUILD + leafCount_ / 4) {
+        Rebuild();
+        return;
+    }
+    for (uint32_t leaf : unlinked_) {
+        nodes_[leaf].right = INVALID_NODE;
+        link(leaf);
+    }
+    changes_ += unlinked_.size();
+    unlinked_.clear();
+}
+
+void Bvh::Rebuild() {
+    // Keep the leaves (their ids are handed out), inner nodes are built again
+    std::vector<BuildItem> items;
+    items.reserve(leafCount_);
+    auto addItem = [&](uint32_t leaf) {
+        const Aabb &rBox = nodes_[leaf].box;
+        items.push_back(BuildItem{rBox, centroid(rBox), leaf});
+    };
+
+    std::vector<uint32_t> stack;
+    if (root_ != INVALID_NODE) {
+        stack.push_back(root_);
+    }
+    while (!stack.empty()) {
+        uint32_t node = stack.back();
+        stack.pop_back();
+        if (nodes_[node].IsLeaf()) {
+            addItem(node);
+        } else {
+            stack.push_back(nodes_[node].left);
+            stack.push_back(nodes_[node].right);
+            freeNode(node);
+        }
+    }
+    for (uint32_t leaf : unlinked_) {
+        nodes_[leaf].right = INVALID_NODE;
+        addItem(leaf);
+    }
+    unlinked_.clear();
+    changes_ = 0;
+
+    root_ = items.empty() ? INVALID_NODE : build(items);
+}
+
+void Bvh::Clear() {
+    nodes_.clear();
+    freeNodes_.clear();
+    unlinked_.clear();
+    root_ = INVALID_NODE;
+    leafCount_ = 0;
+    changes_ = 0;
+}
+
+void Bvh::QueryFrustum(const Frustum &rFrustum, std::vector<uint32_t> &rUserData) const {
+    const std::array<glm::vec4, 6> &rPlanes = rFrustum.GetPlanes();
+    for (uint32_t leaf : unlinked_) {
+        uint32_t planeMask = ALL_PLANES;
+        if (!isOutside(rPlanes, nodes_[leaf].box, planeMask)) {
+            rUserData.push_back(nodes_[leaf].userData);
+        }
+    }
+    if (root_ == INVALID_NODE) {
+        return;
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> stack{{root_, ALL_PLANES}};
+    while (!stack.empty()) {
+        auto [node, planeMask] = stack.back();
+        stack.pop_back();
+
+        if (isOutside(rPlanes, nodes_[node].box, planeMask)) {
+            continue;
+        }
+        if (planeMask == 0 || nodes_[node].IsLeaf()) {
+            // Fully inside, no need to test the subtree
+            collectLeaves(node, rUserData);
+        } else {
+            stack.emplace_back(nodes_[node].right, planeMask);
+            stack.emplace_back(nodes_[node].left, planeMask);
+        }
+    }
+}
+
+void Bvh::QuerySphere(const glm::vec3 &rCenter, float radius, std::vector<uint32_t> &rUserData) const {
+    const float radiusSquared = radius * radius;
+    for (uint32_t leaf : unlinked_) {
+        if (intersectsSphere(nodes_[leaf].box, rCenter, radiusSquared)) {
+            rUserData.push_back(nodes_[leaf].userData);
+        }
+    }
+    if (root_ == INVALID_NODE) {
+        return;
+    }
+
+    std::vector<uint32_t> stack{root_};
+    while (!stack.empty()) {
+        const Node &rNode = nodes_[stack.back()];
+        stack.pop_back();
+
+        if (!intersectsSphere(rNode.box, rCenter, radiusSquared)) {
+            continue;
+        }
+        if (rNode.IsLeaf()) {
+            rUserData.push_back(rNode.userData);
+        } else {
+            stack.push_back(rNode.right);
+            stack.push_back(rNode.left);
+        }
+    }
+}
+
+bool Bvh::Raycast(const glm::vec3 &rOrigin, const glm::vec3 &rDirection, float maxDistance, uint32_t &rUserData,
+                  float &rDistance) const {
+    const glm::vec3 inverseDirection(1.0f / rDirection.x, 1.0f / rDirection.y, 1.0f / rDirection.z);
+    const float infinity = std::numeric_limits<float>::infinity();
+    float closest = maxDistance;
+    bool hit = false;
+
+    for (uint32_t leaf : unlinked_) {
+        float entry = intersectRay(nodes_[leaf].box, rOrigin, inverseDirection, closest);
+        if (entry != infinity) {
+            closest = entry;
+            rUserData = nodes_[leaf].userData;
+            hit = true;
+        }
+    }
+
+    // Nodes with their entry distance, the nearer child is visited first so farther subtrees are mostly pruned
+    std::vector<std::pair<uint32_t, float>> stack;
+    if (root_ != INVALID_NODE) {
+        float rootEntry = intersectRay(nodes_[root_].box, rOrigin, inverseDirection, closest);
+        if (rootEntry != infinity) {
+            stack.emplace_back(root_, rootEntry);
+        }
+    }
+    while (!stack.empty()) {
+        auto [node, entry] = stack.back();
+        stack.pop_back();
+        if (entry > closest) {
+            continue;
+        }
+
+        const Node &rNode = nodes_[node];
+        if (rNode.IsLeaf()) {
+            closest = entry;
+            rUserData = rNode.userData;
+            hit = true;
+            continue;
+        }
+
+        float leftEntry = intersectRay(nodes_[rNode.left].box, rOrigin, inverseDirection, closest);
+        float rightEntry = intersectRay(nodes_[rNode.right].box, rOrigin, inverseDirection, closest);
+        std::pair<uint32_t, float> nearChild{rNode.left, leftEntry};
+        std::pair<uint32_t, float> farChild{rNode.right, rightEntry};
+        if (rightEntry < leftEntry) {
+            std::swap(nearChild, farChild);
+        }
+        if (farChild.second != infinity) {
+            stack.push_back(farChild);
+        }
+        if (nearChild.second != infinity) {
+            stack.push_back(nearChild);
+        }
+    }
+
+    if (hit) {
+        rDistance = closest;
+    }
+    return hit;
+}
+
+uint32_t Bvh::allocateNode() {
+    uint32_t node;
+    if (!freeNodes_.empty()) {
+        node = freeNodes_.back();
+        freeNodes_.pop_back();
+    } else {
+        node = static_cast<uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+    }
+    nodes_[node] = Node{};
+    return node;
+}
+
+void Bvh::freeNode(uint32_t node) { freeNodes_.push_back(node); }
+
+void Bvh::link(uint32_t leaf) {
+    if (root_ == INVALID_NODE) {
+        nodes_[leaf].parent = INVALID_NODE;
+        root_ = leaf;
+        return;
+    }
+
+    const Aabb box = nodes_[leaf].box;
+    const uint32_t sibling = findBestSibling(box);
+    const uint32_t oldParent = nodes_[sibling].parent;
+    const uint32_t newParent = allocateNode();
+    nodes_[newParent].parent = oldParent;
+    nodes_[newParent].left = sibling;
+    nodes_[newParent].right = leaf;
+    nodes_[newParent].box = unite(box, nodes_[sibling].box);
+    nodes_[sibling].parent = newParent;
+    nodes_[leaf].parent = newParent;
+
+    if (oldParent == INVALID_NODE) {
+        root_ = newParent;
+    } else {
+        (nodes_[oldParent].left == sibling ? nodes_[oldParent].left : nodes_[oldParent].right) = newParent;
+        refit(oldParent);
+    }
+}
+
+uint32_t Bvh::findBestSibling(const Aabb &rBox) const {
+    // Greedy descent, a child is entered while pairing with it is cheaper than pairing with the whole subtree.
+    // Growing the ancestors costs the same for both children and is carried along as inherited cost.
+    uint32_t node = root_;
+    while (!nodes_[node].IsLeaf()) {
+        const Node &rNode = nodes_[node];
+        const float combinedArea = area(unite(rNode.box, rBox));
+        const float cost = 2.0f * combinedArea;
+        const float inheritedCost = 2.0f * (combinedArea - area(rNode.box));
+
+        auto childCost = [&](uint32_t child) {
+            const Aabb &rChildBox = nodes_[child].box;
+            float newArea = area(unite(rChildBox, rBox));
+            return nodes_[child].IsLeaf() ? newArea + inheritedCost : newArea - area(rChildBox) + inheritedCost;
+        };
+        const float leftCost = childCost(rNode.left);
+        const float rightCost = childCost(rNode.right);
+
+        if (cost < leftCost && cost < rightCost) {
+            break;
+        }
+        node = leftCost < rightCost ? rNode.left : rNode.right;
+    }
+    return node;
+}
+
+void Bvh::refit(uint32_t node) {
+    while (node != INVALID_NODE) {
+        Aabb box = unite(nodes_[nodes_[node].left].box, nodes_[nodes_[node].right].box);
+        if (equal(box, nodes_[node].box)) {
+            // Ancestors are unchanged as well
+            return;
+        }
+        nodes_[node].box = box;
+        node = nodes_[node].parent;
+    }
+}
+
+uint32_t Bvh::build(std::vector<BuildItem> &rItems) {
+    // Items are partitioned in place, each task covers a contiguous range and creates one node
+    struct Task {
+        size_t begin;
+        size_t end;
+        uint32_t parent;
+        bool isLeft;
+        uint32_t depth;
+    };
+
+    uint32_t root = INVALID_NODE;
+    std::vector<Task> tasks{{0, rItems.size(), INVALID_NODE, true, 0}};
+    std::vector<uint32_t> innerNodes;
+    innerNodes.reserve(rItems.size());
+    while (!tasks.empty()) {
+        const Task task = tasks.back();
+        tasks.pop_back();
+        BuildItem *pBegin = rItems.data() + task.begin;
+        BuildItem *pEnd = rItems.data() + task.end;
+
+        uint32_t node;
+        if (task.end - task.begin == 1) {
+            node = pBegin->leaf;
+        } else {
+            Aabb centroidBox = emptyBox();
+            for (BuildItem *pItem = pBegin; pItem != pEnd; pItem++) {
+                centroidBox = unite(centroidBox, Aabb{pItem->center, pItem->center});
+            }
+            glm::vec3 extent = centroidBox.max - centroidBox.min;
+            int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+            BuildItem *pMiddle = pBegin + (pEnd - pBegin) / 2;
+            if (extent[axis] > 0.0f && task.depth < MAX_SAH_DEPTH) {
+                const float binScale = static_cast<float>(SAH_BINS) / extent[axis];
+                const float binOrigin = centroidBox.min[axis];
+                auto binOf = [&](const BuildItem &rItem) {
+                    return std::min(static_cast<uint32_t>((rItem.center[axis] - binOrigin) * binScale), SAH_BINS - 1);
+                };
+
+                std::array<Aabb, SAH_BINS> binBoxes;
+                std::array<size_t, SAH_BINS> binCounts{};
+                binBoxes.fill(emptyBox());
+                for (BuildItem *pItem = pBegin; pItem != pEnd; pItem++) {
+                    uint32_t bin = binOf(*pItem);
+                    binBoxes[bin] = unite(binBoxes[bin], pItem->box);
+                    binCounts[bin]++;
+                }
+
+                // Cost of splitting before bin i is the item count times the area on each side
+                std::array<float, SAH_BINS> leftCosts;
+                Aabb leftBox = emptyBox();
+                size_t leftCount = 0;
+                for (uint32_t i = 1; i < SAH_BINS; i++) {
+                    leftBox = unite(leftBox, binBoxes[i - 1]);
+                    leftCount += binCounts[i - 1];
+                    leftCosts[i] = leftCount > 0 ? area(leftBox) * static_cast<float>(leftCount) : 0.0f;
+                }
+                uint32_t bestSplit = 0;
+                float bestCost = std::numeric_limits<float>::infinity();
+                Aabb rightBox = emptyBox();
+                size_t rightCount = 0;
+                for (uint32_t i = SAH_BINS - 1; i > 0; i--) {
+                    rightBox = unite(rightBox, binBoxes[i]);
+                    rightCount += binCounts[i];
+                    float cost = leftCosts[i] + area(rightBox) * static_cast<float>(rightCount);
+                    if (rightCount > 0 && rightCount < task.end - task.begin && cost < bestCost) {
+                        bestCost = cost;
+                        bestSplit = i;
+                    }
+                }
+
+                pMiddle = std::partition(pBegin, pEnd, [&](const BuildItem &rItem) { return binOf(rItem) < bestSplit; });
+            } else {
+                std::nth_element(pBegin, pMiddle, pEnd, [axis](const BuildItem &rA, const BuildItem &rB) {
+                    return rA.center[axis] < rB.center[axis];
+                });
+            }
+
+            node = allocateNode();
+            innerNodes.push_back(node);
+            const size_t middle = task.begin + static_cast<size_t>(pMiddle - pBegin);
+            tasks.push_back(Task{middle, task.end, node, false, task.depth + 1});
+            tasks.push_back(Task{task.begin, middle, node, true, task.depth + 1});
+        }
+
+        nodes_[node].parent = task.parent;
+        if (task.parent == INVALID_NODE) {
+            root = node;
+        } else {
+            (task.isLeft ? nodes_[task.parent].left : nodes_[task.parent].right) = node;
+        }
+    }
+
+    // Children are created after their parents, so boxes are computed in reverse
+    for (auto it = innerNodes.rbegin(); it != innerNodes.rend(); ++it) {
+        nodes_[*it].box = unite(nodes_[nodes_[*it].left].box, nodes_[nodes_[*it].right].box);
+    }
+    return root;
+}
+
+void Bvh::collectLeaves(uint32_t node, std::vector<uint32_t> &rUserData) const {
+    std::vector<uint32_t> stack{node};
+    while (!stack.empty()) {
+        const Node &rNode = nodes_[stack.back()];
+        stack.pop_back();
+        if (rNode.IsLeaf()) {
+            rUserData.push_back(rNode.userData);
+        } else {
+            stack.push_back(rNode.right);
+            stack.push_back(rNode.left);
+        }
+    }
+}
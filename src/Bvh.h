@@ -0,0 +1,114 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "Frustum.h"
+
+/**
+ * @brief Dynamic bounding volume hierarchy over axis aligned boxes, each leaf holds one box and a user value.
+ * New leaves are collected and linked by Optimize where they increase the surface area of the tree least, or the
+ * whole tree is built again with the surface area heuristic if many leaves were added or moved since the last build.
+ * Moved boxes refit their ancestors. Leaf ids stay valid until the leaf is removed, also across rebuilds.
+ */
+class Bvh final {
+public:
+    static constexpr uint32_t INVALID_NODE = std::numeric_limits<uint32_t>::max();
+
+    struct Aabb {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+public:
+    /**
+     * @brief Adds a leaf in constant time, it is linked into the tree by the next Optimize. Until then queries test
+     * it on its own.
+     */
+    uint32_t Insert(const Aabb &rBox, uint32_t userData);
+    void Remove(uint32_t leaf);
+
+    /**
+     * @brief Moves the leaf box and refits its ancestors, the structure of the tree does not change.
+     */
+    void Update(uint32_t leaf, const Aabb &rBox);
+
+    /**
+     * @brief Links the leaves inserted since the last call. Rebuilds instead once inserts and updates since the last
+     * rebuild exceed a quarter of the leaves, as a rebuild is cheaper than linking many leaves one by one.
+     */
+    void Optimize();
+
+    /**
+     * @brief Builds the tree over all leaves top down, splits are chosen with the binned surface area heuristic.
+     */
+    void Rebuild();
+
+    void Clear();
+
+    uint32_t GetUserData(uint32_t leaf) const { return nodes_[leaf].userData; }
+    void SetUserData(uint32_t leaf, uint32_t userData) { nodes_[leaf].userData = userData; }
+    size_t GetLeafCount() const { return leafCount_; }
+
+    /**
+     * @brief Appends the user values of all leaves whose box intersects the frustum. Subtrees fully inside the
+     * frustum are taken without further tests.
+     */
+    void QueryFrustum(const Frustum &rFrustum, std::vector<uint32_t> &rUserData) const;
+
+    /**
+     * @brief Appends the user values of all leaves whose box intersects the sphere.
+     */
+    void QuerySphere(const glm::vec3 &rCenter, float radius, std::vector<uint32_t> &rUserData) const;
+
+    /**
+     * @brief Finds the leaf box hit first by the ray within maxDistance, direction does not need to be normalized
+     * (distances are in multiples of it).
+     * @return false if no box is hit
+     */
+    bool Raycast(const glm::vec3 &rOrigin, const glm::vec3 &rDirection, float maxDistance, uint32_t &rUserData,
+                 float &rDistance) const;
+
+private:
+    struct Node {
+        Aabb box;
+        uint32_t parent = INVALID_NODE;
+        // Both INVALID_NODE for leaves, except that leaves waiting to be linked keep their position in unlinked_
+        // in right
+        uint32_t left = INVALID_NODE;
+        uint32_t right = INVALID_NODE;
+        uint32_t userData = 0;
+
+        bool IsLeaf() const { return left == INVALID_NODE; }
+    };
+
+    struct BuildItem {
+        Aabb box;
+        glm::vec3 center;
+        uint32_t leaf;
+    };
+
+    // Parent of leaves waiting in unlinked_
+    static constexpr uint32_t UNLINKED = INVALID_NODE - 1;
+
+    uint32_t allocateNode();
+    void freeNode(uint32_t node);
+
+    void link(uint32_t leaf);
+    uint32_t findBestSibling(const Aabb &rBox) const;
+    void refit(uint32_t node);
+    uint32_t build(std::vector<BuildItem> &rItems);
+    void collectLeaves(uint32_t node, std::vector<uint32_t> &rUserData) const;
+
+private:
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> freeNodes_;
+    std::vector<uint32_t> unlinked_;
+    uint32_t root_ = INVALID_NODE;
+    size_t leafCount_ = 0;
+    // Links and updates since the last rebuild, both make the tree worse than a fresh build
+    size_t changes_ = 0;
+};
@@ -0,0 +1,121 @@
+#include "CommandRecorder.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "GraphicsPipeline.h"
+#include "RenderContext.h"
+#include "RenderQueue.h"
+
+namespace {
+uint32_t getWorkerThreadCount() {
+    // The recording thread takes a chunk itself
+    uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 2u);
+    return hardwareThreads - 1;
+}
+}  // namespace
+
+CommandRecorder::CommandRecorder() : maxChunks_(getWorkerThreadCount() + 1), threadPool_(getWorkerThreadCount()) {}
+
+void CommandRecorder::RecordRenderPass(const RenderContext &rContext, RenderQueue &rQueue,
+                                       const VkRenderPassBeginInfo &rBeginInfo,
+                                       const std::function<void()> &rRecordNextSubpass) {
+    const size_t drawCount = rQueue.GetSize();
+    const uint32_t numChunks = static_cast<uint32_t>(
+        std::clamp<size_t>(drawCount / MIN_DRAWS_PER_CHUNK, 1, static_cast<size_t>(maxChunks_)));
+
+    if (numChunks == 1) {
+        vkCmdBeginRenderPass(rContext.commandBuffer, &rBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+        // Viewport is dynamic, so a resize does not invalidate any pipeline
+        GraphicsPipeline::SetViewport(rContext.commandBuffer, rContext.renderTarget.GetExtent2D());
+        rQueue.Submit(rContext.commandBuffer, 0, drawCount);
+        if (rRecordNextSubpass) {
+            vkCmdNextSubpass(rContext.commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+            rRecordNextSubpass();
+        }
+        vkCmdEndRenderPass(rContext.commandBuffer);
+        return;
+    }
+
+    // Every chunk has its own pool, pools are reset in bulk when the frame comes around again
+    std::vector<VkCommandBuffer> commandBuffers = rContext.frameContext.AcquireSecondaryCommandBuffers(numChunks);
+
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = rBeginInfo.renderPass;
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer = rBeginInfo.framebuffer;
+
+    // Chunk boundaries only depend on the draw count, chunk i always holds the same draws.
+    // Every chunk starts without bound state, so a split costs at most one extra bind of each kind.
+    auto chunkBegin = [drawCount, numChunks](uint32_t chunk) { return drawCount * chunk / numChunks; };
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    uint32_t remainingChunks = numChunks - 1;
+    std::vector<std::exception_ptr> exceptions(numChunks);
+
+    for (uint32_t chunk = 0; chunk + 1 < numChunks; chunk++) {
+        threadPool_.Submit(ThreadPool::Priority::High, [&, chunk]() {
+            try {
+                recordChunk(rContext, rQueue, commandBuffers[chunk], inheritanceInfo, chunkBegin(chunk),
+                            chunkBegin(chunk + 1));
+            } catch (...) {
+                exceptions[chunk] = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--remainingChunks == 0) {
+                condition.notify_one();
+            }
+        });
+    }
+
+    // Last chunk on this thread instead of waiting idle
+    try {
+        recordChunk(rContext, rQueue, commandBuffers.back(), inheritanceInfo, chunkBegin(numChunks - 1), drawCount);
+    } catch (...) {
+        exceptions.back() = std::current_exception();
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&remainingChunks]() { return remainingChunks == 0; });
+    }
+    for (std::exception_ptr &rException : exceptions) {
+        if (rException) {
+            std::rethrow_exception(rException);
+        }
+    }
+
+    vkCmdBeginRenderPass(rContext.commandBuffer, &rBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    vkCmdExecuteCommands(rContext.commandBuffer, numChunks, commandBuffers.data());
+    if (rRecordNextSubpass) {
+        vkCmdNextSubpass(rContext.commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+        rRecordNextSubpass();
+    }
+    vkCmdEndRenderPass(rContext.commandBuffer);
+}
+
+void CommandRecorder::recordChunk(const RenderContext &rContext, RenderQueue &rQueue, VkCommandBuffer commandBuffer,
+                                  const VkCommandBufferInheritanceInfo &rInheritanceInfo, size_t begin, size_t end) {
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    beginInfo.pInheritanceInfo = &rInheritanceInfo;
+
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin recording command buffer!");
+    }
+
+    // Dynamic state is not inherited from the primary command buffer
+    GraphicsPipeline::SetViewport(commandBuffer, rContext.renderTarget.GetExtent2D());
+
+    rQueue.Submit(commandBuffer, begin, end);
+
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record command buffer!");
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "ThreadPool.h"
+
+class RenderQueue;
+struct RenderContext;
+
+/**
+ * @brief Records the draws of a render pass on several threads. The sorted render queue is split into contiguous
+ * chunks, every chunk is recorded into its own secondary command buffer and the primary command buffer executes them
+ * in chunk order, so the result does not depend on thread timing.
+ */
+class CommandRecorder final {
+public:
+    /// Smaller queues are recorded inline into the primary command buffer, threads would only add overhead
+    static constexpr size_t MIN_DRAWS_PER_CHUNK = 256u;
+
+public:
+    CommandRecorder();
+
+    CommandRecorder(const CommandRecorder &) = delete;
+    CommandRecorder &operator=(const CommandRecorder &) = delete;
+
+    /**
+     * @brief Begins the render pass in rContext.commandBuffer, records all draws of the sorted queue and ends it.
+     * Secondary command buffers come from rContext.frameContext. The queue goes into the first subpass, with
+     * rRecordNextSubpass the render pass moves on to the second one and the callback records it inline.
+     */
+    void RecordRenderPass(const RenderContext &rContext, RenderQueue &rQueue, const VkRenderPassBeginInfo &rBeginInfo,
+                          const std::function<void()> &rRecordNextSubpass = nullptr);
+
+private:
+    void recordChunk(const RenderContext &rContext, RenderQueue &rQueue, VkCommandBuffer commandBuffer,
+                     const VkCommandBufferInheritanceInfo &rInheritanceInfo, size_t begin, size_t end);
+
+private:
+    uint32_t maxChunks_;
+    ThreadPool threadPool_;
+};
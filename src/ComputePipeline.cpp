@@ -0,0 +1,25 @@
+#include "ComputePipeline.h"
+
+#include "DeviceContext.h"
+
+ComputePipeline::ComputePipeline(DeviceContext &rDeviceContext, std::shared_ptr<const ShaderModule> spShaderModule,
+                                 std::shared_ptr<const PipelineLayout> spPipelineLayout)
+    : rDeviceContext_(rDeviceContext),
+      spShaderModule_(std::move(spShaderModule)),
+      spPipelineLayout_(std::move(spPipelineLayout)) {
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = spShaderModule_->GetHandle();
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = spPipelineLayout_->GetHandle();
+
+    pipeline_ = rDeviceContext_.GetPipelineCache().CreateComputePipeline(pipelineInfo);
+}
+
+ComputePipeline::~ComputePipeline() { vkDestroyPipeline(rDeviceContext_.GetDevice(), pipeline_, nullptr); }
+
+void ComputePipeline::Bind(VkCommandBuffer &rCommandBuffer) {
+    vkCmdBindPipeline(rCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_);
+}
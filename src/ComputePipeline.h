@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include "PipelineLayout.h"
+#include "ShaderModule.h"
+
+class DeviceContext;
+
+/**
+ * @brief Immutable compute pipeline of one shader module, created through the shared pipeline cache.
+ */
+class ComputePipeline final {
+public:
+    ComputePipeline(DeviceContext &rDeviceContext, std::shared_ptr<const ShaderModule> spShaderModule,
+                    std::shared_ptr<const PipelineLayout> spPipelineLayout);
+    ~ComputePipeline();
+
+    ComputePipeline(const ComputePipeline &) = delete;
+    ComputePipeline &operator=(const ComputePipeline &) = delete;
+
+    const ShaderModule &GetShaderModule() const { return *spShaderModule_; }
+    const PipelineLayout &GetLayout() const { return *spPipelineLayout_; }
+
+    void Bind(VkCommandBuffer &rCommandBuffer);
+
+private:
+    DeviceContext &rDeviceContext_;
+    std::shared_ptr<const ShaderModule> spShaderModule_;
+    std::shared_ptr<const PipelineLayout> spPipelineLayout_;
+    VkPipeline pipeline_ = VK_NULL_HANDLE;
+};
@@ -0,0 +1,342 @@
+#include "DeferredRenderer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "DeviceContext.h"
+#include "GraphicsPipeline.h"
+#include "LightCuller.h"
+#include "RenderContext.h"
+#include "ShaderLibrary.h"
+
+namespace {
+const char *LIGHTING_VERTEX_SHADER_FILE = "shaders/lighting.vert.spv";
+const char *LIGHTING_FRAGMENT_SHADER_FILE = "shaders/lighting.frag.spv";
+const char *CLUSTERED_LIGHTING_FRAGMENT_SHADER_FILE = "shaders/lighting_clustered.frag.spv";
+
+// Attachments of one frame are only read by the lighting subpass, no need to keep them anywhere but on chip
+const VkImageUsageFlags GBUFFER_USAGE =
+    VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+VkAttachmentDescription describeAttachment(VkFormat format, VkImageLayout finalLayout) {
+    VkAttachmentDescription attachment{};
+    attachment.format = format;
+    attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachment.finalLayout = finalLayout;
+    return attachment;
+}
+}  // namespace
+
+DeferredRenderer::DeferredRenderer(DeviceContext &rDeviceContext) : rDeviceContext_(rDeviceContext) {
+    depthFormat_ = findDepthFormat();
+
+    std::vector<VkDescriptorSetLayoutBinding> bindings(5);
+    for (uint32_t binding = 0; binding < bindings.size(); binding++) {
+        bindings[binding].binding = binding;
+        bindings[binding].descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+        bindings[binding].descriptorCount = 1;
+        bindings[binding].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+    // After albedo, normal, material and depth
+    bindings.back().descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    spLightingSetLayout_ = rDeviceContext_.GetPipelineRegistry().GetDescriptorSetLayout(bindings);
+}
+
+DeferredRenderer::~DeferredRenderer() { destroyAttachments(); }
+
+VkRenderPass DeferredRenderer::CreateRenderPass(VkFormat outputFormat, VkImageLayout finalLayout) const {
+    std::array<VkAttachmentDescription, ATTACHMENT_COUNT> attachments;
+    attachments[OUTPUT_ATTACHMENT] = describeAttachment(outputFormat, finalLayout);
+    attachments[OUTPUT_ATTACHMENT].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachments[ALBEDO_ATTACHMENT] = describeAttachment(ALBEDO_FORMAT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    attachments[NORMAL_ATTACHMENT] = describeAttachment(NORMAL_FORMAT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    attachments[MATERIAL_ATTACHMENT] = describeAttachment(MATERIAL_FORMAT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    attachments[DEPTH_ATTACHMENT] = describeAttachment(depthFormat_, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+
+    std::array<VkAttachmentReference, GBUFFER_COLOR_COUNT> gBufferRefs;
+    std::array<VkAttachmentReference, GBUFFER_COLOR_COUNT + 1> inputRefs;
+    for (uint32_t i = 0; i < GBUFFER_COLOR_COUNT; i++) {
+        gBufferRefs[i] = {ALBEDO_ATTACHMENT + i, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+        inputRefs[i] = {ALBEDO_ATTACHMENT + i, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    }
+    inputRefs.back() = {DEPTH_ATTACHMENT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL};
+    VkAttachmentReference depthRef{DEPTH_ATTACHMENT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+    VkAttachmentReference outputRef{OUTPUT_ATTACHMENT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+
+    std::array<VkSubpassDescription, 2> subpasses{};
+    subpasses[GEOMETRY_SUBPASS].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpasses[GEOMETRY_SUBPASS].colorAttachmentCount = static_cast<uint32_t>(gBufferRefs.size());
+    subpasses[GEOMETRY_SUBPASS].pColorAttachments = gBufferRefs.data();
+    subpasses[GEOMETRY_SUBPASS].pDepthStencilAttachment = &depthRef;
+    subpasses[LIGHTING_SUBPASS].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpasses[LIGHTING_SUBPASS].inputAttachmentCount = static_cast<uint32_t>(inputRefs.size());
+    subpasses[LIGHTING_SUBPASS].pInputAttachments = inputRefs.data();
+    subpasses[LIGHTING_SUBPASS].colorAttachmentCount = 1;
+    subpasses[LIGHTING_SUBPASS].pColorAttachments = &outputRef;
+
+    std::array<VkSubpassDependency, 2> dependencies{};
+    // The G-buffer is shared by all frames, the previous frame has to be done with it. Also waits for the image
+    // like the forward render pass.
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = GEOMETRY_SUBPASS;
+    dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                                   VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    dependencies[0].srcAccessMask =
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                                   VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    // Lighting reads the G-buffer at the same pixel only, so tiles do not wait for each other
+    dependencies[1].srcSubpass = GEOMETRY_SUBPASS;
+    dependencies[1].dstSubpass = LIGHTING_SUBPASS;
+    dependencies[1].srcStageMask =
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependencies[1].srcAccessMask =
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    dependencies[1].dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+    dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+    VkRenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    renderPassInfo.pAttachments = attachments.data();
+    renderPassInfo.subpassCount = static_cast<uint32_t>(subpasses.size());
+    renderPassInfo.pSubpasses = subpasses.data();
+    renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+    renderPassInfo.pDependencies = dependencies.data();
+
+    VkRenderPass renderPass;
+    if (vkCreateRenderPass(rDeviceContext_.GetDevice(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create deferred render pass!");
+    }
+    return renderPass;
+}
+
+void DeferredRenderer::CreateAttachments(VkExtent2D extent) {
+    destroyAttachments();
+    const VkImageUsageFlags colorUsage = GBUFFER_USAGE | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    attachments_[ALBEDO_ATTACHMENT - ALBEDO_ATTACHMENT] =
+        createAttachment(ALBEDO_FORMAT, colorUsage, VK_IMAGE_ASPECT_COLOR_BIT, extent);
+    attachments_[NORMAL_ATTACHMENT - ALBEDO_ATTACHMENT] =
+        createAttachment(NORMAL_FORMAT, colorUsage, VK_IMAGE_ASPECT_COLOR_BIT, extent);
+    attachments_[MATERIAL_ATTACHMENT - ALBEDO_ATTACHMENT] =
+        createAttachment(MATERIAL_FORMAT, colorUsage, VK_IMAGE_ASPECT_COLOR_BIT, extent);
+    attachments_[DEPTH_ATTACHMENT - ALBEDO_ATTACHMENT] = createAttachment(
+        depthFormat_, GBUFFER_USAGE | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_IMAGE_ASPECT_DEPTH_BIT, extent);
+}
+
+std::array<VkImageView, DeferredRenderer::ATTACHMENT_COUNT> DeferredRenderer::GetFramebufferAttachments(
+    VkImageView outputView) const {
+    std::array<VkImageView, ATTACHMENT_COUNT> views;
+    views[OUTPUT_ATTACHMENT] = outputView;
+    for (uint32_t i = 0; i < attachments_.size(); i++) {
+        views[ALBEDO_ATTACHMENT + i] = attachments_[i].imageView;
+    }
+    return views;
+}
+
+std::array<VkClearValue, DeferredRenderer::ATTACHMENT_COUNT> DeferredRenderer::GetClearValues() const {
+    std::array<VkClearValue, ATTACHMENT_COUNT> clearValues{};
+    clearValues[OUTPUT_ATTACHMENT].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
+    // Far plane, lighting skips pixels without geometry
+    clearValues[DEPTH_ATTACHMENT].depthStencil = {1.0f, 0};
+    return clearValues;
+}
+
+void DeferredRenderer::RecordLighting(const RenderContext &rContext, const std::vector<Light> &rLights) {
+    if (!updatePipeline(rContext)) {
+        return;
+    }
+    FrameContext &rFrameContext = rContext.frameContext;
+    const bool clustered = rContext.lightSet != VK_NULL_HANDLE;
+
+    // Clustered lighting reads lights and constants from the light set, set 0 only keeps the layout compatible
+    FrameContext::UniformRange uniformRange = rContext.frameUniforms;
+    VkDescriptorBufferInfo bufferInfo{};
+    if (!clustered) {
+        LightingUniforms uniforms{};
+        uniforms.inverseViewProjection = glm::inverse(rContext.viewProjection);
+        uniforms.ambient = glm::vec4(glm::vec3(AMBIENT_LIGHT), 0.0f);
+        uniforms.lightCount = static_cast<uint32_t>(rLights.size());
+        uniformRange = rFrameContext.AllocateUniformData(sizeof(uniforms));
+        std::memcpy(uniformRange.pData, &uniforms, sizeof(uniforms));
+
+        // Empty ranges are not allowed, without lights one unused element is bound
+        const VkDeviceSize lightsSize = std::max<size_t>(rLights.size(), 1) * sizeof(Light);
+        FrameContext::BufferRange lightRange = rFrameContext.AllocateStorageData(lightsSize);
+        if (!rLights.empty()) {
+            std::memcpy(lightRange.pData, rLights.data(), rLights.size() * sizeof(Light));
+        }
+        bufferInfo = {lightRange.buffer, lightRange.offset, lightsSize};
+    }
+
+    VkDescriptorSet descriptorSet = rFrameContext.AllocateDescriptorSet(spLightingSetLayout_->GetHandle());
+    std::array<VkDescriptorImageInfo, ATTACHMENT_COUNT - 1> imageInfos;
+    for (uint32_t i = 0; i < imageInfos.size(); i++) {
+        imageInfos[i] = {VK_NULL_HANDLE, attachments_[i].imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    }
+    imageInfos.back().imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+    // The lights binding stays empty while lighting clustered, the shader does not read it
+    std::array<VkWriteDescriptorSet, ATTACHMENT_COUNT> descriptorWrites{};
+    for (uint32_t binding = 0; binding < descriptorWrites.size(); binding++) {
+        descriptorWrites[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[binding].dstSet = descriptorSet;
+        descriptorWrites[binding].dstBinding = binding;
+        descriptorWrites[binding].descriptorCount = 1;
+        if (binding < imageInfos.size()) {
+            descriptorWrites[binding].descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            descriptorWrites[binding].pImageInfo = &imageInfos[binding];
+        } else {
+            descriptorWrites[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            descriptorWrites[binding].pBufferInfo = &bufferInfo;
+        }
+    }
+    const uint32_t writeCount = clustered ? static_cast<uint32_t>(imageInfos.size()) : ATTACHMENT_COUNT;
+    vkUpdateDescriptorSets(rContext.deviceContext.GetDevice(), writeCount, descriptorWrites.data(), 0, nullptr);
+
+    // The geometry subpass may have been recorded into secondary command buffers, their dynamic state is gone
+    VkCommandBuffer &rCommandBuffer = rContext.commandBuffer;
+    GraphicsPipeline::SetViewport(rCommandBuffer, rContext.renderTarget.GetExtent2D());
+    VkPipelineLayout pipelineLayout = spPipeline_->GetLayout().GetHandle();
+    spPipeline_->Bind(rCommandBuffer);
+    vkCmdBindDescriptorSets(rCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout,
+                            FrameContext::UNIFORM_SET, 1, &uniformRange.descriptorSet, 1, &uniformRange.offset);
+    vkCmdBindDescriptorSets(rCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, LIGHTING_SET, 1,
+                            &descriptorSet, 0, nullptr);
+    if (clustered) {
+        vkCmdBindDescriptorSets(rCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, CLUSTERED_LIGHT_SET,
+                                1, &rContext.lightSet, 0, nullptr);
+    }
+    // Fullscreen triangle, generated from the vertex index
+    vkCmdDraw(rCommandBuffer, 3, 1, 0, 0);
+}
+
+VkFormat DeferredRenderer::findDepthFormat() const {
+    // Depth only formats, so one view serves as depth and as input attachment. D16 is supported everywhere.
+    for (VkFormat format : {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM}) {
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(rDeviceContext_.GetPhysicalDevice(), format, &properties);
+        if ((properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) != 0) {
+            return format;
+        }
+    }
+    throw std::runtime_error("failed to find a depth format!");
+}
+
+DeferredRenderer::Attachment DeferredRenderer::createAttachment(VkFormat format, VkImageUsageFlags usage,
+                                                                VkImageAspectFlags aspect, VkExtent2D extent) {
+    Attachment attachment;
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = format;
+    imageInfo.extent = {extent.width, extent.height, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = usage;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (vkCreateImage(rDeviceContext_.GetDevice(), &imageInfo, nullptr, &attachment.image) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create G-buffer image!");
+    }
+
+    // Lazily allocated memory is only committed if the attachment ever leaves tile memory
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(rDeviceContext_.GetDevice(), attachment.image, &requirements);
+    MemoryAllocator &rAllocator = rDeviceContext_.GetMemoryAllocator();
+    const VkPhysicalDeviceMemoryProperties &rMemoryProperties = rAllocator.GetMemoryProperties();
+    VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    for (uint32_t i = 0; i < rMemoryProperties.memoryTypeCount; i++) {
+        if ((requirements.memoryTypeBits & (1u << i)) != 0 &&
+            (rMemoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0) {
+            properties |= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+            break;
+        }
+    }
+    attachment.allocation = rAllocator.AllocateImageMemory(attachment.image, properties);
+
+    VkImageViewCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    createInfo.image = attachment.image;
+    createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    createInfo.format = format;
+    createInfo.subresourceRange.aspectMask = aspect;
+    createInfo.subresourceRange.baseMipLevel = 0;
+    createInfo.subresourceRange.levelCount = 1;
+    createInfo.subresourceRange.baseArrayLayer = 0;
+    createInfo.subresourceRange.layerCount = 1;
+    if (vkCreateImageView(rDeviceContext_.GetDevice(), &createInfo, nullptr, &attachment.imageView) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create G-buffer image view!");
+    }
+    return attachment;
+}
+
+void DeferredRenderer::destroyAttachments() {
+    for (Attachment &rAttachment : attachments_) {
+        if (rAttachment.image == VK_NULL_HANDLE) {
+            continue;
+        }
+        vkDestroyImageView(rDeviceContext_.GetDevice(), rAttachment.imageView, nullptr);
+        vkDestroyImage(rDeviceContext_.GetDevice(), rAttachment.image, nullptr);
+        rDeviceContext_.GetMemoryAllocator().Free(rAttachment.allocation);
+        rAttachment = Attachment{};
+    }
+}
+
+bool DeferredRenderer::updatePipeline(const RenderContext &rContext) {
+    ShaderLibrary &rShaderLibrary = rContext.deviceContext.GetShaderLibrary();
+    const bool clustered = rContext.lightSet != VK_NULL_HANDLE;
+    bool shadersChanged = false;
+    if (spVertexShader_ == nullptr || shaderGeneration_ != rShaderLibrary.GetGeneration() || clustered_ != clustered) {
+        std::shared_ptr<const ShaderModule> spVertexShader = rShaderLibrary.GetShaderModule(LIGHTING_VERTEX_SHADER_FILE);
+        std::shared_ptr<const ShaderModule> spFragmentShader = rShaderLibrary.GetShaderModule(
+            clustered ? CLUSTERED_LIGHTING_FRAGMENT_SHADER_FILE : LIGHTING_FRAGMENT_SHADER_FILE);
+        if (spVertexShader == nullptr || spFragmentShader == nullptr) {
+            return false;
+        }
+        shadersChanged = spVertexShader != spVertexShader_ || spFragmentShader != spFragmentShader_;
+        spVertexShader_ = std::move(spVertexShader);
+        spFragmentShader_ = std::move(spFragmentShader);
+        shaderGeneration_ = rShaderLibrary.GetGeneration();
+        clustered_ = clustered;
+    }
+
+    if (spPipeline_ == nullptr || shadersChanged || renderPass_ != rContext.renderPass ||
+        imageFormat_ != rContext.imageFormat) {
+        GraphicsPipeline::State state;
+        state.shaderStages = {{VK_SHADER_STAGE_VERTEX_BIT, spVertexShader_},
+                              {VK_SHADER_STAGE_FRAGMENT_BIT, spFragmentShader_}};
+        state.descriptorSetLayoutBindings = FrameContext::GetUniformBindings();
+        state.extraSetLayouts = {spLightingSetLayout_};
+        if (clustered_) {
+            state.extraSetLayouts.push_back(
+                rContext.deviceContext.GetPipelineRegistry().GetDescriptorSetLayout(LightCuller::GetSetLayoutBindings()));
+        }
+        state.renderPass = rContext.renderPass;
+        state.colorFormat = rContext.imageFormat;
+        state.subpass = LIGHTING_SUBPASS;
+        state.cullMode = VK_CULL_MODE_NONE;
+
+        if (spPipeline_ != nullptr) {
+            // Frames still in flight may use the previous pipeline
+            rContext.frameContext.Retain(spPipeline_);
+        }
+        spPipeline_ = rContext.deviceContext.GetPipelineRegistry().GetGraphicsPipeline(state);
+        renderPass_ = rContext.renderPass;
+        imageFormat_ = rContext.imageFormat;
+    }
+    return true;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "MemoryAllocator.h"
+#include "PipelineLayout.h"
+#include "Light.h"
+
+class DeviceContext;
+class GraphicsPipeline;
+class ShaderModule;
+struct RenderContext;
+
+/**
+ * @brief Deferred shading in one render pass of two subpasses. The geometry subpass writes albedo, normal, material
+ * and depth of the closest surface into the G-buffer, the lighting subpass reads them back as input attachments (the
+ * same pixel only) and shades every pixel once with a fullscreen triangle. Lighting costs pixels times lights,
+ * however many objects there are.
+ * The G-buffer is transient and lazily allocated where supported, tile-based GPUs keep it in tile memory and never
+ * write it out. One G-buffer serves every framebuffer, the render pass orders frames using it.
+ */
+class DeferredRenderer final {
+public:
+    /// Framebuffer attachments, the output (swapchain or headless image) comes first
+    static constexpr uint32_t OUTPUT_ATTACHMENT = 0;
+    static constexpr uint32_t ALBEDO_ATTACHMENT = 1;
+    static constexpr uint32_t NORMAL_ATTACHMENT = 2;
+    static constexpr uint32_t MATERIAL_ATTACHMENT = 3;
+    static constexpr uint32_t DEPTH_ATTACHMENT = 4;
+    static constexpr uint32_t ATTACHMENT_COUNT = 5;
+    /// Color outputs of the geometry subpass (shaders/gbuffer.frag), in attachment order starting at albedo
+    static constexpr uint32_t GBUFFER_COLOR_COUNT = 3;
+
+    static constexpr uint32_t GEOMETRY_SUBPASS = 0;
+    static constexpr uint32_t LIGHTING_SUBPASS = 1;
+    /// Set of the input attachments and lights in shaders/lighting.frag, set 0 holds the lighting uniforms
+    static constexpr uint32_t LIGHTING_SET = 1;
+    /// Set of the LightCuller's light set in shaders/lighting_clustered.frag
+    static constexpr uint32_t CLUSTERED_LIGHT_SET = 2;
+
+    static constexpr VkFormat ALBEDO_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+    /// Normals are stored as n * 0.5 + 0.5
+    static constexpr VkFormat NORMAL_FORMAT = VK_FORMAT_A2B10G10R10_UNORM_PACK32;
+    /// Specular strength and shininess / 256
+    static constexpr VkFormat MATERIAL_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+
+public:
+    explicit DeferredRenderer(DeviceContext &rDeviceContext);
+    ~DeferredRenderer();
+
+    DeferredRenderer(const DeferredRenderer &) = delete;
+    DeferredRenderer &operator=(const DeferredRenderer &) = delete;
+
+    /**
+     * @brief Creates the render pass, the output ends up in finalLayout like the one of the forward render pass.
+     */
+    VkRenderPass CreateRenderPass(VkFormat outputFormat, VkImageLayout finalLayout) const;
+
+    /**
+     * @brief (Re)creates the G-buffer for the extent. Only call while no frame in flight uses it, e.g. while the
+     * framebuffers are recreated.
+     */
+    void CreateAttachments(VkExtent2D extent);
+
+    /// Views for a framebuffer of the render pass, indexed by the attachment constants
+    std::array<VkImageView, ATTACHMENT_COUNT> GetFramebufferAttachments(VkImageView outputView) const;
+    std::array<VkClearValue, ATTACHMENT_COUNT> GetClearValues() const;
+
+    /**
+     * @brief Records the lighting subpass into rContext.commandBuffer, which is already in it. Nothing is drawn until
+     * the lighting shaders are loaded. With rContext.lightSet every pixel is only lit by the lights of its cluster,
+     * rLights are not used then.
+     */
+    void RecordLighting(const RenderContext &rContext, const std::vector<Light> &rLights);
+
+private:
+    // Lighting block of shaders/lighting.frag (std140)
+    struct LightingUniforms {
+        glm::mat4 inverseViewProjection;
+        glm::vec4 ambient;
+        uint32_t lightCount;
+        uint32_t padding[3];
+    };
+
+    struct Attachment {
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView imageView = VK_NULL_HANDLE;
+        MemoryAllocator::Allocation allocation;
+    };
+
+    VkFormat findDepthFormat() const;
+    Attachment createAttachment(VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect,
+                                VkExtent2D extent);
+    void destroyAttachments();
+    bool updatePipeline(const RenderContext &rContext);
+
+private:
+    DeviceContext &rDeviceContext_;
+    VkFormat depthFormat_ = VK_FORMAT_UNDEFINED;
+
+    // Indexed by attachment - ALBEDO_ATTACHMENT
+    std::array<Attachment, ATTACHMENT_COUNT - 1> attachments_;
+
+    std::shared_ptr<const DescriptorSetLayout> spLightingSetLayout_;
+    std::shared_ptr<GraphicsPipeline> spPipeline_;
+    std::shared_ptr<const ShaderModule> spVertexShader_;
+    std::shared_ptr<const ShaderModule> spFragmentShader_;
+    // Shader library generation and lighting mode the modules were looked up for
+    uint64_t shaderGeneration_ = 0;
+    bool clustered_ = false;
+    // Pipeline was created for these
+    VkRenderPass renderPass_ = VK_NULL_HANDLE;
+    VkFormat imageFormat_ = VK_FORMAT_UNDEFINED;
+};
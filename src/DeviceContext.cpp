@@ -1,5 +1,7 @@
 #include "DeviceContext.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <set>
 #include <stdexcept>
@@ -13,6 +15,11 @@ const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation
 
 const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 
+// Enabled if available, reports pipeline cache hits
+const char *const pipelineCreationFeedbackExtension = VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME;
+
+const char *const pipelineCacheFile = "cache/pipeline_cache.bin";
+
 #ifdef NDEBUG
 const bool enableValidationLayers = false;
 #else
@@ -83,6 +90,17 @@ void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &create
     createInfo.pfnUserCallback = debugCallback;
 }
 
+// Descriptor indexing is core in 1.2, older loaders only know 1.0 and reject higher versions
+uint32_t getInstanceApiVersion() {
+    auto pEnumerateInstanceVersion = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(
+        vkGetInstanceProcAddr(VK_NULL_HANDLE, "vkEnumerateInstanceVersion"));
+    uint32_t version = VK_API_VERSION_1_0;
+    if (pEnumerateInstanceVersion != nullptr && pEnumerateInstanceVersion(&version) != VK_SUCCESS) {
+        version = VK_API_VERSION_1_0;
+    }
+    return std::min(version, static_cast<uint32_t>(VK_API_VERSION_1_2));
+}
+
 VkInstance createInstance(const std::vector<const char *> &requiredExtensions) {
     if (enableValidationLayers && !checkValidationLayerSupport()) {
         throw std::runtime_error("validation layers requested, but not available!");
@@ -94,7 +112,7 @@ VkInstance createInstance(const std::vector<const char *> &requiredExtensions) {
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName = "Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    appInfo.apiVersion = getInstanceApiVersion();
 
     VkInstanceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -143,14 +161,14 @@ VkDebugUtilsMessengerEXT setupDebugMessenger(VkInstance instance) {
     return debugMessenger;
 }
 
-bool checkDeviceExtensionSupport(VkPhysicalDevice physicalDevice) {
+bool checkDeviceExtensionSupport(VkPhysicalDevice physicalDevice, const std::vector<const char *> &rExtensions) {
     uint32_t extensionCount;
     vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
 
     std::vector<VkExtensionProperties> availableExtensions(extensionCount);
     vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
 
-    std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
+    std::set<std::string> requiredExtensions(rExtensions.begin(), rExtensions.end());
 
     for (const auto &extension : availableExtensions) {
         requiredExtensions.erase(extension.extensionName);
@@ -159,18 +177,27 @@ bool checkDeviceExtensionSupport(VkPhysicalDevice physicalDevice) {
     return requiredExtensions.empty();
 }
 
+std::vector<const char *> getDeviceExtensions(bool headless) {
+    if (headless) {
+        // Rendering into offscreen images only, no swapchain needed
+        return {};
+    }
+    return deviceExtensions;
+}
+
 bool isDeviceSuitable(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface) {
+    bool headless = (surface == VK_NULL_HANDLE);
     DeviceContext::QueueFamilyIndices indices = DeviceContext::FindQueueFamilies(physicalDevice, surface);
 
-    bool extensionsSupported = checkDeviceExtensionSupport(physicalDevice);
+    bool extensionsSupported = checkDeviceExtensionSupport(physicalDevice, getDeviceExtensions(headless));
 
-    bool swapchainAdequate = false;
-    if (extensionsSupported) {
+    bool swapchainAdequate = headless;
+    if (extensionsSupported && !headless) {
         // only query if extensions are supported
         swapchainAdequate = Swapchain::QuerySwapChainSupport(physicalDevice, surface).IsAdequate();
     }
 
-    return indices.isComplete() && extensionsSupported;
+    return indices.isComplete(headless) && extensionsSupported && swapchainAdequate;
 }
 
 VkPhysicalDevice pickPhysicalDevice(VkInstance instance, VkSurfaceKHR surface) {
@@ -192,9 +219,71 @@ VkPhysicalDevice pickPhysicalDevice(VkInstance instance, VkSurfaceKHR surface) {
     throw std::runtime_error("failed to find a suitable GPU!");
 }
 
-VkDevice createLogicalDevice(VkPhysicalDevice physicalDevice, const DeviceContext::QueueFamilyIndices &rIndices) {
+/**
+ * @brief Enables in rFeatures what the bindless table needs, false if the instance or device lacks Vulkan 1.2 or any
+ * of the descriptor indexing features.
+ */
+bool queryBindlessSupport(VkPhysicalDevice physicalDevice, VkPhysicalDeviceVulkan12Features &rFeatures) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    if (getInstanceApiVersion() < VK_API_VERSION_1_2 || properties.apiVersion < VK_API_VERSION_1_2) {
+        return false;
+    }
+
+    VkPhysicalDeviceVulkan12Features supported{};
+    supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    VkPhysicalDeviceFeatures2 features2{};
+    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features2.pNext = &supported;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+    if (!supported.runtimeDescriptorArray || !supported.descriptorBindingPartiallyBound ||
+        !supported.descriptorBindingUpdateUnusedWhilePending || !supported.descriptorBindingSampledImageUpdateAfterBind ||
+        !supported.descriptorBindingStorageBufferUpdateAfterBind ||
+        !supported.shaderSampledImageArrayNonUniformIndexing || !supported.shaderStorageBufferArrayNonUniformIndexing) {
+        return false;
+    }
+
+    rFeatures = VkPhysicalDeviceVulkan12Features{};
+    rFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    rFeatures.runtimeDescriptorArray = VK_TRUE;
+    rFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+    rFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    rFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    rFeatures.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+    rFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    rFeatures.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+    return true;
+}
+
+std::unique_ptr<BindlessTable> createBindlessTable(DeviceContext &rDeviceContext) {
+    VkPhysicalDeviceVulkan12Properties limits{};
+    limits.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+    VkPhysicalDeviceProperties2 properties2{};
+    properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties2.pNext = &limits;
+    vkGetPhysicalDeviceProperties2(rDeviceContext.GetPhysicalDevice(), &properties2);
+
+    // Both arrays are visible to all stages, so the per stage limits apply to each of them
+    uint32_t maxTextures =
+        std::min({BindlessTable::MAX_TEXTURES, limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                  limits.maxDescriptorSetUpdateAfterBindSampledImages});
+    uint32_t maxBuffers =
+        std::min({BindlessTable::MAX_BUFFERS, limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+                  limits.maxDescriptorSetUpdateAfterBindStorageBuffers});
+    if (maxTextures + maxBuffers > limits.maxPerStageUpdateAfterBindResources) {
+        maxTextures = std::min(maxTextures, limits.maxPerStageUpdateAfterBindResources / 2);
+        maxBuffers = std::min(maxBuffers, limits.maxPerStageUpdateAfterBindResources / 2);
+    }
+    return std::make_unique<BindlessTable>(rDeviceContext, maxTextures, maxBuffers);
+}
+
+VkDevice createLogicalDevice(VkPhysicalDevice physicalDevice, const DeviceContext::QueueFamilyIndices &rIndices,
+                             const std::vector<const char *> &rExtensions, const void *pFeatures) {
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-    std::set<uint32_t> uniqueQueueFamilies = {rIndices.graphicsFamily.value(), rIndices.presentFamily.value()};
+    std::set<uint32_t> uniqueQueueFamilies = {rIndices.graphicsFamily.value()};
+    if (rIndices.presentFamily.has_value()) {
+        uniqueQueueFamilies.insert(rIndices.presentFamily.value());
+    }
 
     float queuePriority = 1.0f;
     for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -210,13 +299,15 @@ VkDevice createLogicalDevice(VkPhysicalDevice physicalDevice, const DeviceContex
 
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    // Features of newer versions, chained
+    createInfo.pNext = pFeatures;
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
     createInfo.pEnabledFeatures = &deviceFeatures;
 
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(rExtensions.size());
+    createInfo.ppEnabledExtensionNames = rExtensions.data();
 
     if (enableValidationLayers) {
         createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
@@ -234,12 +325,25 @@ VkDevice createLogicalDevice(VkPhysicalDevice physicalDevice, const DeviceContex
 
 }  // namespace
 
-DeviceContext::DeviceContext(const std::vector<const char *> &requiredExtensions) {
+DeviceContext::DeviceContext(const std::vector<const char *> &requiredExtensions, bool bindless)
+    : resourceManager_(*this), bindlessRequested_(bindless) {
     instance_ = createInstance(requiredExtensions);
     debugMessenger_ = setupDebugMessenger(instance_);
 }
 
 DeviceContext::~DeviceContext() {
+    // Only weak references, pipelines still in use keep working until their owners release them
+    spPipelineRegistry_.reset();
+    spShaderLibrary_.reset();
+    spBindlessTable_.reset();
+
+    // Saves the cache, device has to be alive for that
+    spPipelineCache_.reset();
+
+    // All device memory has to be released before the device
+    spUploadManager_.reset();
+    spMemoryAllocator_.reset();
+
     if (device_ != VK_NULL_HANDLE) {
         vkDestroyDevice(device_, nullptr);
     }
@@ -250,21 +354,48 @@ DeviceContext::~DeviceContext() {
     vkDestroyInstance(instance_, nullptr);
 }
 
-void DeviceContext::CreateDevice(VkSurfaceKHR &rSurface) {
+void DeviceContext::CreateDevice(VkSurfaceKHR surface) {
     if (device_ != VK_NULL_HANDLE) {
         // Device was already created
         return;
     }
 
-    physicalDevice_ = pickPhysicalDevice(instance_, rSurface);
-    queueFamilyIndices_ = FindQueueFamilies(physicalDevice_, rSurface);
+    headless_ = (surface == VK_NULL_HANDLE);
+    physicalDevice_ = pickPhysicalDevice(instance_, surface);
+    queueFamilyIndices_ = FindQueueFamilies(physicalDevice_, surface);
 
-    device_ = createLogicalDevice(physicalDevice_, queueFamilyIndices_);
+    std::vector<const char *> extensions = getDeviceExtensions(headless_);
+    bool creationFeedbackSupported =
+        checkDeviceExtensionSupport(physicalDevice_, {pipelineCreationFeedbackExtension});
+    if (creationFeedbackSupported) {
+        extensions.push_back(pipelineCreationFeedbackExtension);
+    }
+
+    VkPhysicalDeviceVulkan12Features bindlessFeatures{};
+    bool bindless = bindlessRequested_ && queryBindlessSupport(physicalDevice_, bindlessFeatures);
+    if (bindlessRequested_ && !bindless) {
+        std::cerr << "Descriptor indexing is not supported, bindless drawing is disabled" << std::endl;
+    }
+    device_ = createLogicalDevice(physicalDevice_, queueFamilyIndices_, extensions,
+                                  bindless ? &bindlessFeatures : nullptr);
 
     vkGetDeviceQueue(device_, queueFamilyIndices_.graphicsFamily.value(), 0, &graphicsQueue_);
-    vkGetDeviceQueue(device_, queueFamilyIndices_.presentFamily.value(), 0, &presentQueue_);
+    if (queueFamilyIndices_.presentFamily.has_value()) {
+        vkGetDeviceQueue(device_, queueFamilyIndices_.presentFamily.value(), 0, &presentQueue_);
+    }
+
+    spMemoryAllocator_ = std::make_unique<MemoryAllocator>(device_, physicalDevice_);
+    spUploadManager_ = std::make_unique<UploadManager>(*this);
+    spPipelineCache_ =
+        std::make_unique<PipelineCache>(device_, physicalDevice_, pipelineCacheFile, creationFeedbackSupported);
+    spPipelineRegistry_ = std::make_unique<PipelineRegistry>(*this);
+    spShaderLibrary_ = std::make_unique<ShaderLibrary>(*this);
+    if (bindless) {
+        spBindlessTable_ = createBindlessTable(*this);
+    }
 }
 
+
 void DeviceContext::Submit(VkSubmitInfo &&submitInfo, const VkFence &buffersReadyFence)
 {
 	if(buffersReadyFence != VK_NULL_HANDLE)
@@ -299,11 +430,15 @@ DeviceContext::QueueFamilyIndices DeviceContext::FindQueueFamilies(VkPhysicalDev
 	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
 	vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
+	bool headless = (surface == VK_NULL_HANDLE);
 	int i = 0;
 	for(const auto &queueFamily : queueFamilies)
 	{
 		VkBool32 presentSupport = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+		if(!headless)
+		{
+			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+		}
 
 		if(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
 		{
@@ -313,7 +448,7 @@ DeviceContext::QueueFamilyIndices DeviceContext::FindQueueFamilies(VkPhysicalDev
 		{
 			indices.presentFamily = i;
 		}
-		if(indices.isComplete())
+		if(indices.isComplete(headless))
 		{
 			break;
 		}
@@ -2,8 +2,15 @@
 #include <vulkan/vulkan.h>
 
 #include <functional>
+#include <memory>
 #include <optional>
+#include "BindlessTable.h"
+#include "MemoryAllocator.h"
+#include "PipelineCache.h"
+#include "PipelineRegistry.h"
 #include "ResourceManager.h"
+#include "ShaderLibrary.h"
+#include "UploadManager.h"
 
 class Window;
 
@@ -13,25 +20,44 @@ public:
         std::optional<uint32_t> graphicsFamily;
         std::optional<uint32_t> presentFamily;
 
-        bool isComplete() { return graphicsFamily.has_value() && presentFamily.has_value(); }
+        bool isComplete(bool headless = false) {
+            return graphicsFamily.has_value() && (headless || presentFamily.has_value());
+        }
     };
 
 public:
-    DeviceContext(const std::vector<const char *> &requiredExtensions);
+    /**
+     * @brief With bindless the device is created with descriptor indexing if it supports it, see GetBindlessTable.
+     */
+    DeviceContext(const std::vector<const char *> &requiredExtensions, bool bindless = false);
     ~DeviceContext();
     
-    void CreateDevice(VkSurfaceKHR &rSurface);
+    /**
+     * @brief Picks a physical device and creates the logical device.
+     * Without a surface (headless) no presentation support or swapchain extension is required.
+     */
+    void CreateDevice(VkSurfaceKHR surface);
 
 	void Submit(VkSubmitInfo &&submitInfo, const VkFence &buffersReadyFence);
 
 	VkResult Present(const VkPresentInfoKHR &presentInfo);
 
     void WaitIdle();
+
+    bool IsHeadless() const { return headless_; }
     
     VkInstance &GetInstance() { return instance_; }
     VkPhysicalDevice &GetPhysicalDevice() { return physicalDevice_; }
     VkDevice &GetDevice() { return device_; }
     const QueueFamilyIndices &GetQueueFamilyIndices() const { return queueFamilyIndices_; }
+    MemoryAllocator &GetMemoryAllocator() { return *spMemoryAllocator_; }
+    UploadManager &GetUploadManager() { return *spUploadManager_; }
+    PipelineCache &GetPipelineCache() { return *spPipelineCache_; }
+    PipelineRegistry &GetPipelineRegistry() { return *spPipelineRegistry_; }
+    ShaderLibrary &GetShaderLibrary() { return *spShaderLibrary_; }
+    ResourceManager &GetResourceManager() { return resourceManager_; }
+    /// nullptr unless bindless drawing was requested and the device supports it
+    BindlessTable *GetBindlessTable() { return spBindlessTable_.get(); }
 
 public:
 	static QueueFamilyIndices FindQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface);
@@ -45,4 +71,12 @@ private:
 	VkQueue graphicsQueue_ = VK_NULL_HANDLE;
 	VkQueue presentQueue_ = VK_NULL_HANDLE;
     QueueFamilyIndices queueFamilyIndices_;
+    bool headless_ = false;
+    bool bindlessRequested_ = false;
+    std::unique_ptr<MemoryAllocator> spMemoryAllocator_;
+    std::unique_ptr<UploadManager> spUploadManager_;
+    std::unique_ptr<PipelineCache> spPipelineCache_;
+    std::unique_ptr<PipelineRegistry> spPipelineRegistry_;
+    std::unique_ptr<ShaderLibrary> spShaderLibrary_;
+    std::unique_ptr<BindlessTable> spBindlessTable_;
 };
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+
+/**
+ * @brief How the Scene hands transforms to the shaders. Instanced draws read them from the instance buffer, the
+ * per-draw modes draw every object on its own: with push constants, or with a uniform slice bound at its own dynamic
+ * offset (see FrameContext::AllocateUniformData).
+ */
+enum class DrawMode : uint8_t { Instanced = 0, PushConstants = 1, Uniforms = 2 };
+
+/**
+ * @brief Frame block of the vertex shaders, written once per frame into the uniform ring (std140).
+ */
+struct FrameUniforms {
+    glm::mat4 viewProjection;
+};
+
+/**
+ * @brief Per-draw constants of shaders/push_constants.vert. 80 bytes, well below the 128 bytes every device supports.
+ */
+struct DrawConstants {
+    static constexpr VkShaderStageFlags STAGES = VK_SHADER_STAGE_VERTEX_BIT;
+
+    glm::mat4 transform;
+    /// Dense index of the object in the Scene
+    uint32_t objectIndex = 0;
+    /// Material::GetBindlessIndex
+    uint32_t materialIndex = 0;
+    uint32_t padding[2] = {};
+
+    static VkPushConstantRange GetPushConstantRange() { return VkPushConstantRange{STAGES, 0, sizeof(DrawConstants)}; }
+};
+
+/**
+ * @brief Draw block of shaders/draw_uniforms.vert, the frame constants followed by those of one draw (std140).
+ */
+struct DrawUniforms {
+    FrameUniforms frame;
+    DrawConstants draw;
+};
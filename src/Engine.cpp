@@ -1,49 +1,81 @@
-#include <chrono>
+#include <cstring>
 #include "DeviceContext.h"
 #include "Engine.h"
+#include "HeadlessTarget.h"
 #include "RenderContext.h"
 #include "ResourceManager.h"
 #include "Scene.h"
+#include "Swapchain.h"
 #include "Window.h"
 
 Engine::Engine(Scene &rScene, DeviceContext &rContext, Window &rWindow)
-    : rScene_(rScene), rDeviceContext_(rContext), rWindow_(rWindow), swapchain_(rContext, rWindow) {
-    commandPool_ = createCommandPool(swapchain_.GetSurface());
+    : rScene_(rScene),
+      rDeviceContext_(rContext),
+      spRenderTarget_(std::make_unique<Swapchain>(rContext, rWindow)) {
+    createFrameContexts();
+}
+
+Engine::Engine(Scene &rScene, DeviceContext &rContext, VkExtent2D extent)
+    : rScene_(rScene),
+      rDeviceContext_(rContext),
+      spRenderTarget_(std::make_unique<HeadlessTarget>(rContext, extent)) {
+    createFrameContexts();
 }
 
 Engine::~Engine() {
     rDeviceContext_.WaitIdle();
-    destroyCommandPool();
+    for (std::unique_ptr<FrameContext> &rspFrameContext : frameContexts_) {
+        rspFrameContext.reset();
+    }
     destroyFramebuffers();
     destroyRenderPass(renderPass_);
+    spDeferredRenderer_.reset();
+    spLightCuller_.reset();
+}
+
+void Engine::SetDeferredShading(bool enabled) {
+    if (renderPass_ != VK_NULL_HANDLE) {
+        throw std::runtime_error("failed to change deferred shading, the render pass exists already!");
+    }
+    if (!enabled) {
+        spDeferredRenderer_.reset();
+    } else if (spDeferredRenderer_ == nullptr) {
+        spDeferredRenderer_ = std::make_unique<DeferredRenderer>(rDeviceContext_);
+    }
+}
+
+void Engine::SetClusteredLighting(bool enabled) {
+    if (renderPass_ != VK_NULL_HANDLE) {
+        throw std::runtime_error("failed to change clustered lighting, frames are rendered already!");
+    }
+    if (!enabled) {
+        spLightCuller_.reset();
+    } else if (spLightCuller_ == nullptr) {
+        spLightCuller_ = std::make_unique<LightCuller>(rDeviceContext_);
+    }
 }
 
 void Engine::Render() {
     // First update swapchain
-    bool outOfDate = swapchain_.Update();
+    bool outOfDate = spRenderTarget_->Update();
 
     if (outOfDate) {
-        // Recreate command buffers only if number of swap chain images changed (and on initial render)
-        if(commandBuffers_.size() != swapchain_.GetNumberOfImages()) {
-            commandBuffers_ = createCommandBuffers(swapchain_.GetNumberOfImages(), commandPool_);
-        }
-
         // Frame buffers are always destroyed when swapchain is out of date (change of images)
         destroyFramebuffers();
 
-        if (imageFormat_ != swapchain_.GetImageFormat()) {
+        if (imageFormat_ != spRenderTarget_->GetImageFormat()) {
             // Only destroy render pass if image format no longer matches    
             destroyRenderPass(renderPass_);
         }
 
         if (renderPass_ == VK_NULL_HANDLE) {
             // Recreate render pass
-            renderPass_ = createRenderPass(swapchain_.GetImageFormat());
-            imageFormat_ = swapchain_.GetImageFormat();
+            renderPass_ = createRenderPass(spRenderTarget_->GetImageFormat());
+            imageFormat_ = spRenderTarget_->GetImageFormat();
         }
 
         // Recreate frame buffers
-        swapchainFramebuffers_ = createFramebuffers(swapchain_, renderPass_);
+        swapchainFramebuffers_ = createFramebuffers(*spRenderTarget_, renderPass_);
 
         // Record all command buffers, bind pipeline etc.
 
@@ -66,61 +98,74 @@ void Engine::Render() {
         // https://docs.unity3d.com/Manual/shader-predefined-pass-tags-built-in.html
     }
 
-    swapchain_.WaitForNextFrame();
-    Swapchain::AvailableImageInfo availableInfo = swapchain_.AcquireImage();
+    spRenderTarget_->WaitForNextFrame();
+    RenderTarget::AvailableImageInfo availableInfo = spRenderTarget_->AcquireImage();
     if(!availableInfo.IsValid())
     {
         outOfDate = true;
         return;
     }
 
-    // At this point we know which commandBuffer we can use to record
+    // The fence of this frame slot signaled, everything the slot allocated last time can be recycled
+    frameContexts_[availableInfo.frameIndex]->Begin();
 
     update(availableInfo, outOfDate);
     submit(availableInfo);
-    if(!swapchain_.Present(availableInfo))
+    if(!spRenderTarget_->Present(availableInfo))
     {
         outOfDate = true;
         return;
     }
 }
 
-void Engine::update(const Swapchain::AvailableImageInfo &availableInfo, bool outOfDate)
+void Engine::update(const RenderTarget::AvailableImageInfo &availableInfo, bool outOfDate)
 {
-	static auto startTime = std::chrono::high_resolution_clock::now();
-
     // Get command buffer for current frame
-    VkCommandBuffer &rCmdBuffer = commandBuffers_[availableInfo.imageIndex];
-
-	// auto currentTime = std::chrono::high_resolution_clock::now();
-	// float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
-    // UniformBufferObject ubo{};
-	// ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-	// ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-	// ubo.proj = glm::perspective(glm::radians(45.0f), m_rSwapchain.GetExtent2D().width / (float)m_rSwapchain.GetExtent2D().height, 0.1f, 10.0f);
-	// ubo.proj[1][1] *= -1;
-	// void *data;
-	// vkMapMemory(m_rDeviceContext.GetDevice(), m_uniformBuffersMemory[availableInfo.imageIndex], 0, sizeof(ubo), 0, &data);
-	// memcpy(data, &ubo, sizeof(ubo));
-	// vkUnmapMemory(m_rDeviceContext.GetDevice(), m_uniformBuffersMemory[availableInfo.imageIndex]);
+    FrameContext &rFrameContext = *frameContexts_[availableInfo.frameIndex];
+    VkCommandBuffer &rCmdBuffer = rFrameContext.GetCommandBuffer();
+
+    // Constants of the frame go into the uniform ring of the frame, draws bind them with a dynamic offset
+    FrameContext::UniformRange frameUniforms = rFrameContext.AllocateUniformData(sizeof(FrameUniforms));
+    FrameUniforms uniforms{viewProjection_};
+    std::memcpy(frameUniforms.pData, &uniforms, sizeof(uniforms));
 
     RenderContext context{
         .deviceContext = rDeviceContext_,
-        .swapchain = swapchain_,
+        .renderTarget = *spRenderTarget_,
         .renderPass = renderPass_,
         .imageFormat = imageFormat_,
         .commandBuffer = rCmdBuffer,
+        .frameContext = rFrameContext,
+        .frameIndex = availableInfo.frameIndex,
         .imageIndex = availableInfo.imageIndex,
-        .outOfDate = outOfDate
+        .outOfDate = outOfDate,
+        .frameUniforms = frameUniforms,
+        .viewProjection = viewProjection_,
+        .drawMode = drawMode_,
+        .deferred = spDeferredRenderer_ != nullptr
     };
 
+    // Changed shader files replace their modules, materials using them pick up new pipelines in their update
+    rDeviceContext_.GetShaderLibrary().Update();
+
+    // Objects outside the view are skipped by draw (or culled on the GPU while drawing)
+    rScene_.Cull(Frustum(viewProjection_));
+
+    // Lights go up before the materials update, they pick lit pipelines once the light set exists
+    if (spLightCuller_ != nullptr) {
+        context.lightSet = spLightCuller_->Update(context, rScene_.GetLights());
+    }
+
     // Update pipelines
     rScene_.Update(context);
 
+    // Submit all uploads queued during update at once, before the frame using them
+    rDeviceContext_.GetUploadManager().Flush();
+
     // Start recording
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = 0;                  // Optional
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
     beginInfo.pInheritanceInfo = nullptr; // Optional
 
     if(vkBeginCommandBuffer(rCmdBuffer, &beginInfo) != VK_SUCCESS)
@@ -134,18 +179,29 @@ void Engine::update(const Swapchain::AvailableImageInfo &availableInfo, bool out
     renderPassInfo.renderPass = renderPass_;
     renderPassInfo.framebuffer = swapchainFramebuffers_[availableInfo.imageIndex];
     renderPassInfo.renderArea.offset = {0, 0};
-    renderPassInfo.renderArea.extent = swapchain_.GetExtent2D();
+    renderPassInfo.renderArea.extent = spRenderTarget_->GetExtent2D();
 
     VkClearValue clearColor = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
     renderPassInfo.clearValueCount = 1;
     renderPassInfo.pClearValues = &clearColor;
 
-    vkCmdBeginRenderPass(rCmdBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-    rScene_.Draw(context);
-
-    // End renderpass
-    vkCmdEndRenderPass(rCmdBuffer);
+    // Draws sorted by state, large queues are recorded on several threads into secondary command buffers.
+    // GPU culling and light culling record their compute passes here, before the render pass.
+    if (context.lightSet != VK_NULL_HANDLE) {
+        spLightCuller_->Record(context);
+    }
+    rScene_.Draw(context, renderQueue_);
+    if (spDeferredRenderer_ != nullptr) {
+        // Draws fill the G-buffer, the lighting subpass follows inline
+        std::array<VkClearValue, DeferredRenderer::ATTACHMENT_COUNT> clearValues = spDeferredRenderer_->GetClearValues();
+        renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+        renderPassInfo.pClearValues = clearValues.data();
+        commandRecorder_.RecordRenderPass(context, renderQueue_, renderPassInfo, [this, &context]() {
+            spDeferredRenderer_->RecordLighting(context, rScene_.GetLights());
+        });
+    } else {
+        commandRecorder_.RecordRenderPass(context, renderQueue_, renderPassInfo);
+    }
 
     // End recording
     if(vkEndCommandBuffer(rCmdBuffer) != VK_SUCCESS)
@@ -154,70 +210,39 @@ void Engine::update(const Swapchain::AvailableImageInfo &availableInfo, bool out
     }
 }
 
-void Engine::submit(const Swapchain::AvailableImageInfo &availableInfo)
+void Engine::submit(const RenderTarget::AvailableImageInfo &availableInfo)
 {
 	VkSubmitInfo submitInfo{};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
+	// Headless targets have no acquire / present semaphores
 	VkSemaphore waitSemaphores[] = {availableInfo.imageAvailableSemaphore};
 	VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-	submitInfo.waitSemaphoreCount = 1;
+	submitInfo.waitSemaphoreCount = (availableInfo.imageAvailableSemaphore != VK_NULL_HANDLE) ? 1 : 0;
 	submitInfo.pWaitSemaphores = waitSemaphores;
 	submitInfo.pWaitDstStageMask = waitStages;
 
 	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &commandBuffers_[availableInfo.imageIndex];
+	submitInfo.pCommandBuffers = &frameContexts_[availableInfo.frameIndex]->GetCommandBuffer();
 
 	VkSemaphore signalSemaphores[] = {availableInfo.renderFinishedSemaphore};
-	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.signalSemaphoreCount = (availableInfo.renderFinishedSemaphore != VK_NULL_HANDLE) ? 1 : 0;
 	submitInfo.pSignalSemaphores = signalSemaphores;
 
 	rDeviceContext_.Submit(std::move(submitInfo), availableInfo.inFlightFence);
 }
 
-VkCommandPool Engine::createCommandPool(VkSurfaceKHR surface) {
-    VkCommandPoolCreateInfo poolInfo{};
-    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    poolInfo.queueFamilyIndex = rDeviceContext_.GetQueueFamilyIndices().graphicsFamily.value();
-    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-
-    VkCommandPool commandPool;
-    if (vkCreateCommandPool(rDeviceContext_.GetDevice(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create command pool!");
+void Engine::createFrameContexts() {
+    for (std::unique_ptr<FrameContext> &rspFrameContext : frameContexts_) {
+        rspFrameContext = std::make_unique<FrameContext>(rDeviceContext_);
     }
-
-    return commandPool;
-}
-
-void Engine::destroyCommandPool() {
-    // Buffers will be automatically freed on destruction of pool
-    commandBuffers_.clear();
-
-	if(commandPool_ != VK_NULL_HANDLE)
-	{
-		vkDestroyCommandPool(rDeviceContext_.GetDevice(), commandPool_, nullptr);
-		commandPool_ = VK_NULL_HANDLE;
-	}
 }
 
-std::vector<VkCommandBuffer> Engine::createCommandBuffers(uint32_t numImages, VkCommandPool &rPool) {
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = rPool;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = numImages;
-
-    std::vector<VkCommandBuffer> commandBuffers;
-    commandBuffers.resize(numImages);
-
-    // Command buffers will be automatically freed
-    if (vkAllocateCommandBuffers(rDeviceContext_.GetDevice(), &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate command buffers!");
+VkRenderPass Engine::createRenderPass(const VkFormat &swapchainImageFormat) {
+    if (spDeferredRenderer_ != nullptr) {
+        return spDeferredRenderer_->CreateRenderPass(swapchainImageFormat, spRenderTarget_->GetFinalLayout());
     }
-    return commandBuffers;
-}
 
-VkRenderPass Engine::createRenderPass(const VkFormat &swapchainImageFormat) {
     VkAttachmentDescription colorAttachment{};
     colorAttachment.format = swapchainImageFormat;
     colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
@@ -226,7 +251,7 @@ VkRenderPass Engine::createRenderPass(const VkFormat &swapchainImageFormat) {
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    colorAttachment.finalLayout = spRenderTarget_->GetFinalLayout();
 
     VkAttachmentReference colorAttachmentRef{};
     colorAttachmentRef.attachment = 0;
@@ -268,20 +293,29 @@ void Engine::destroyRenderPass(VkRenderPass &rRenderPass) {
     }
 }
 
-std::vector<VkFramebuffer> Engine::createFramebuffers(Swapchain &rSwapchain, VkRenderPass &rRenderPass) {
+std::vector<VkFramebuffer> Engine::createFramebuffers(RenderTarget &rRenderTarget, VkRenderPass &rRenderPass) {
     std::vector<VkFramebuffer> framebuffers;
-    framebuffers.resize(rSwapchain.GetImageViews().size());
+    framebuffers.resize(rRenderTarget.GetImageViews().size());
+    if (spDeferredRenderer_ != nullptr) {
+        // The G-buffer follows the extent, the device is idle while the framebuffers are recreated
+        spDeferredRenderer_->CreateAttachments(rRenderTarget.GetExtent2D());
+    }
 
-    for (size_t i = 0; i < rSwapchain.GetImageViews().size(); i++) {
-        VkImageView attachments[] = {rSwapchain.GetImageViews()[i]};
+    for (size_t i = 0; i < rRenderTarget.GetImageViews().size(); i++) {
+        std::array<VkImageView, DeferredRenderer::ATTACHMENT_COUNT> attachments{rRenderTarget.GetImageViews()[i]};
+        uint32_t attachmentCount = 1;
+        if (spDeferredRenderer_ != nullptr) {
+            attachments = spDeferredRenderer_->GetFramebufferAttachments(rRenderTarget.GetImageViews()[i]);
+            attachmentCount = DeferredRenderer::ATTACHMENT_COUNT;
+        }
 
         VkFramebufferCreateInfo framebufferInfo{};
         framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
         framebufferInfo.renderPass = rRenderPass;
-        framebufferInfo.attachmentCount = 1;
-        framebufferInfo.pAttachments = attachments;
-        framebufferInfo.width = rSwapchain.GetExtent2D().width;
-        framebufferInfo.height = rSwapchain.GetExtent2D().height;
+        framebufferInfo.attachmentCount = attachmentCount;
+        framebufferInfo.pAttachments = attachments.data();
+        framebufferInfo.width = rRenderTarget.GetExtent2D().width;
+        framebufferInfo.height = rRenderTarget.GetExtent2D().height;
         framebufferInfo.layers = 1;
 
         if (vkCreateFramebuffer(rDeviceContext_.GetDevice(), &framebufferInfo, nullptr, &framebuffers[i]) !=
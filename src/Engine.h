@@ -1,10 +1,19 @@
 #pragma once
 
+#include <array>
 #include <memory>
 #include <vector>
 
+#include <glm/glm.hpp>
+
+#include "CommandRecorder.h"
+#include "DeferredRenderer.h"
+#include "DrawConstants.h"
+#include "FrameContext.h"
 #include "GraphicsPipeline.h"
-#include "Swapchain.h"
+#include "LightCuller.h"
+#include "RenderQueue.h"
+#include "RenderTarget.h"
 
 class DeviceContext;
 class Scene;
@@ -13,30 +22,65 @@ class Window;
 class Engine {
 public:
     Engine(Scene &rScene, DeviceContext &rContext, Window &rWindow);
+
+    /**
+     * @brief Creates a headless engine rendering into offscreen images of the given extent.
+     */
+    Engine(Scene &rScene, DeviceContext &rContext, VkExtent2D extent);
     ~Engine();
 
     void Render();
 
+    /**
+     * @brief Camera used to cull and draw the scene. Identity by default, the shaders output positions as they are.
+     */
+    void SetViewProjection(const glm::mat4 &rViewProjection) { viewProjection_ = rViewProjection; }
+
+    /**
+     * @brief Instanced by default, the per-draw modes exist to compare their cost. Takes effect with the next frame.
+     */
+    void SetDrawMode(DrawMode drawMode) { drawMode_ = drawMode; }
+
+    /**
+     * @brief Draws the scene into a G-buffer and lights it with the lights of the scene in a second subpass, see
+     * DeferredRenderer. Forward by default, only call before the first frame.
+     */
+    void SetDeferredShading(bool enabled);
+
+    /**
+     * @brief Assigns the lights of the scene to clusters of the view in a compute pass every frame, forward and
+     * deferred shading then only shade with the lights of a pixel's cluster, see LightCuller. Off by default, only
+     * call before the first frame.
+     */
+    void SetClusteredLighting(bool enabled);
+
+    const RenderQueue &GetRenderQueue() const { return renderQueue_; }
+
 private:
-    void update(const Swapchain::AvailableImageInfo &availableInfo, bool outOfDate);
-    void submit(const Swapchain::AvailableImageInfo &availableInfo);
+    void update(const RenderTarget::AvailableImageInfo &availableInfo, bool outOfDate);
+    void submit(const RenderTarget::AvailableImageInfo &availableInfo);
 
-    VkCommandPool createCommandPool(VkSurfaceKHR surface);
-    void destroyCommandPool();
-    std::vector<VkCommandBuffer> createCommandBuffers(uint32_t numImages, VkCommandPool &rPool);
+    void createFrameContexts();
     VkRenderPass createRenderPass(const VkFormat &swapchainImageFormat);
     void destroyRenderPass(VkRenderPass &rRenderPass);
-    std::vector<VkFramebuffer> createFramebuffers(Swapchain &rSwapchain, VkRenderPass &rRenderPass);
+    std::vector<VkFramebuffer> createFramebuffers(RenderTarget &rRenderTarget, VkRenderPass &rRenderPass);
     void destroyFramebuffers();
 
 private:
     Scene &rScene_;
     DeviceContext &rDeviceContext_;
-    Window &rWindow_;
-    Swapchain swapchain_;
+    std::unique_ptr<RenderTarget> spRenderTarget_;
+    RenderQueue renderQueue_;
+    CommandRecorder commandRecorder_;
     VkRenderPass renderPass_ = VK_NULL_HANDLE;
     VkFormat imageFormat_ = VK_FORMAT_UNDEFINED;
-    VkCommandPool commandPool_ = VK_NULL_HANDLE;
-    std::vector<VkCommandBuffer> commandBuffers_;
+    glm::mat4 viewProjection_ = glm::mat4(1.0f);
+    DrawMode drawMode_ = DrawMode::Instanced;
+    // Set while shading deferred, owns the G-buffer shared by all framebuffers
+    std::unique_ptr<DeferredRenderer> spDeferredRenderer_;
+    // Set while lighting clustered
+    std::unique_ptr<LightCuller> spLightCuller_;
+    // Ring of frames in flight, indexed by AvailableImageInfo::frameIndex
+    std::array<std::unique_ptr<FrameContext>, RenderTarget::MAX_FRAMES_IN_FLIGHT> frameContexts_;
     std::vector<VkFramebuffer> swapchainFramebuffers_;
 };
@@ -0,0 +1,257 @@
+#include "FrameContext.h"
+
+#include <algorithm>
+#include <array>
+#include <initializer_list>
+#include <stdexcept>
+
+#include "DeviceContext.h"
+
+FrameContext::FrameContext(DeviceContext &rDeviceContext) : rDeviceContext_(rDeviceContext) {
+    commandPool_ = createCommandPool();
+    commandBuffer_ = allocateCommandBuffer(commandPool_, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    descriptorPools_.push_back(createDescriptorPool());
+
+    instances_.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    instances_.minSize = MIN_INSTANCE_BUFFER_SIZE;
+    uniforms_.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    uniforms_.minSize = MIN_UNIFORM_BUFFER_SIZE;
+    storage_.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    storage_.minSize = MIN_STORAGE_BUFFER_SIZE;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(rDeviceContext_.GetPhysicalDevice(), &properties);
+    uniformAlignment_ = properties.limits.minUniformBufferOffsetAlignment;
+    storageAlignment_ = properties.limits.minStorageBufferOffsetAlignment;
+    spUniformSetLayout_ = rDeviceContext_.GetPipelineRegistry().GetDescriptorSetLayout(GetUniformBindings());
+}
+
+FrameContext::~FrameContext() {
+    // Command buffers and descriptor sets are freed with their pools
+    for (VkDescriptorPool descriptorPool : descriptorPools_) {
+        vkDestroyDescriptorPool(rDeviceContext_.GetDevice(), descriptorPool, nullptr);
+    }
+    for (SecondaryCommands &rSecondaryCommands : secondaryCommands_) {
+        vkDestroyCommandPool(rDeviceContext_.GetDevice(), rSecondaryCommands.commandPool, nullptr);
+    }
+    vkDestroyCommandPool(rDeviceContext_.GetDevice(), commandPool_, nullptr);
+
+    for (auto &[buffer, rAllocation] : retiredBuffers_) {
+        destroyBuffer(buffer, rAllocation);
+    }
+    for (LinearBuffer *pBuffer : {&instances_, &uniforms_, &storage_}) {
+        if (pBuffer->buffer != VK_NULL_HANDLE) {
+            destroyBuffer(pBuffer->buffer, pBuffer->allocation);
+        }
+    }
+}
+
+void FrameContext::Begin() {
+    // Buffers stay allocated, only their memory is recycled
+    vkResetCommandPool(rDeviceContext_.GetDevice(), commandPool_, 0);
+    for (SecondaryCommands &rSecondaryCommands : secondaryCommands_) {
+        vkResetCommandPool(rDeviceContext_.GetDevice(), rSecondaryCommands.commandPool, 0);
+    }
+
+    for (size_t i = 0; i <= currentDescriptorPool_ && i < descriptorPools_.size(); i++) {
+        vkResetDescriptorPool(rDeviceContext_.GetDevice(), descriptorPools_[i], 0);
+    }
+    currentDescriptorPool_ = 0;
+    uniformDescriptorSet_ = VK_NULL_HANDLE;
+
+    for (auto &[buffer, rAllocation] : retiredBuffers_) {
+        destroyBuffer(buffer, rAllocation);
+    }
+    retiredBuffers_.clear();
+    instances_.head = 0;
+    uniforms_.head = 0;
+    storage_.head = 0;
+
+    retained_.clear();
+}
+
+std::vector<VkCommandBuffer> FrameContext::AcquireSecondaryCommandBuffers(uint32_t count) {
+    while (secondaryCommands_.size() < count) {
+        SecondaryCommands &rSecondaryCommands = secondaryCommands_.emplace_back();
+        rSecondaryCommands.commandPool = createCommandPool();
+        rSecondaryCommands.commandBuffer =
+            allocateCommandBuffer(rSecondaryCommands.commandPool, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+    }
+
+    std::vector<VkCommandBuffer> commandBuffers;
+    commandBuffers.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        commandBuffers.push_back(secondaryCommands_[i].commandBuffer);
+    }
+    return commandBuffers;
+}
+
+VkDescriptorSet FrameContext::AllocateDescriptorSet(VkDescriptorSetLayout layout) {
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+
+    while (true) {
+        allocInfo.descriptorPool = descriptorPools_[currentDescriptorPool_];
+        VkDescriptorSet descriptorSet;
+        VkResult result = vkAllocateDescriptorSets(rDeviceContext_.GetDevice(), &allocInfo, &descriptorSet);
+        if (result == VK_SUCCESS) {
+            return descriptorSet;
+        }
+        if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) {
+            throw std::runtime_error("failed to allocate descriptor set!");
+        }
+
+        // Pool is full, continue in the next one. Pools are kept, so later frames do not run out again.
+        currentDescriptorPool_++;
+        if (currentDescriptorPool_ == descriptorPools_.size()) {
+            descriptorPools_.push_back(createDescriptorPool());
+        }
+    }
+}
+
+FrameContext::BufferRange FrameContext::AllocateInstanceData(VkDeviceSize size) {
+    // Vertex attribute formats need at most 16 byte alignment
+    const VkDeviceSize offset = allocateLinear(instances_, size, size, 16);
+
+    BufferRange range;
+    range.buffer = instances_.buffer;
+    range.offset = offset;
+    range.pData = static_cast<unsigned char *>(instances_.allocation.pMapped) + offset;
+    return range;
+}
+
+FrameContext::BufferRange FrameContext::AllocateStorageData(VkDeviceSize size) {
+    const VkDeviceSize offset = allocateLinear(storage_, size, size, storageAlignment_);
+
+    BufferRange range;
+    range.buffer = storage_.buffer;
+    range.offset = offset;
+    range.pData = static_cast<unsigned char *>(storage_.allocation.pMapped) + offset;
+    return range;
+}
+
+FrameContext::UniformRange FrameContext::AllocateUniformData(VkDeviceSize size) {
+    if (size > MAX_UNIFORM_SLICE_SIZE) {
+        throw std::runtime_error("failed to allocate uniform data, slice is too large!");
+    }
+
+    // The descriptor covers MAX_UNIFORM_SLICE_SIZE bytes from every offset, they have to be inside the buffer
+    VkBuffer previousBuffer = uniforms_.buffer;
+    const VkDeviceSize offset = allocateLinear(uniforms_, size, MAX_UNIFORM_SLICE_SIZE, uniformAlignment_);
+    if (uniformDescriptorSet_ == VK_NULL_HANDLE || uniforms_.buffer != previousBuffer) {
+        uniformDescriptorSet_ = AllocateDescriptorSet(spUniformSetLayout_->GetHandle());
+
+        VkDescriptorBufferInfo bufferInfo{uniforms_.buffer, 0, MAX_UNIFORM_SLICE_SIZE};
+        VkWriteDescriptorSet descriptorWrite{};
+        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite.dstSet = uniformDescriptorSet_;
+        descriptorWrite.dstBinding = 0;
+        descriptorWrite.descriptorCount = 1;
+        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        descriptorWrite.pBufferInfo = &bufferInfo;
+        vkUpdateDescriptorSets(rDeviceContext_.GetDevice(), 1, &descriptorWrite, 0, nullptr);
+    }
+
+    UniformRange range;
+    range.descriptorSet = uniformDescriptorSet_;
+    range.offset = static_cast<uint32_t>(offset);
+    range.pData = static_cast<unsigned char *>(uniforms_.allocation.pMapped) + offset;
+    return range;
+}
+
+std::vector<VkDescriptorSetLayoutBinding> FrameContext::GetUniformBindings() {
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    return {binding};
+}
+
+VkCommandPool FrameContext::createCommandPool() {
+    // Transient, buffers are rerecorded every time the frame comes around and only reset with the whole pool
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = rDeviceContext_.GetQueueFamilyIndices().graphicsFamily.value();
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+    VkCommandPool commandPool;
+    if (vkCreateCommandPool(rDeviceContext_.GetDevice(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create command pool!");
+    }
+    return commandPool;
+}
+
+VkCommandBuffer FrameContext::allocateCommandBuffer(VkCommandPool commandPool, VkCommandBufferLevel level) {
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = commandPool;
+    allocInfo.level = level;
+    allocInfo.commandBufferCount = 1;
+
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(rDeviceContext_.GetDevice(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate command buffers!");
+    }
+    return commandBuffer;
+}
+
+VkDescriptorPool FrameContext::createDescriptorPool() {
+    std::array<VkDescriptorPoolSize, 6> poolSizes = {{
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, DESCRIPTORS_PER_POOL},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, DESCRIPTORS_PER_POOL},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, DESCRIPTORS_PER_POOL},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, DESCRIPTORS_PER_POOL},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, DESCRIPTORS_PER_POOL},
+        {VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, DESCRIPTORS_PER_POOL},
+    }};
+
+    // No VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT, sets are only released by resetting the pool
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = DESCRIPTORS_PER_POOL;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+
+    VkDescriptorPool descriptorPool;
+    if (vkCreateDescriptorPool(rDeviceContext_.GetDevice(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor pool!");
+    }
+    return descriptorPool;
+}
+
+VkDeviceSize FrameContext::allocateLinear(LinearBuffer &rBuffer, VkDeviceSize size, VkDeviceSize reach,
+                                          VkDeviceSize alignment) {
+    VkDeviceSize offset = (rBuffer.head + alignment - 1) & ~(alignment - 1);
+    if (rBuffer.buffer != VK_NULL_HANDLE && offset + std::max(size, reach) <= rBuffer.size) {
+        rBuffer.head = offset + size;
+        return offset;
+    }
+
+    if (rBuffer.buffer != VK_NULL_HANDLE) {
+        retiredBuffers_.emplace_back(rBuffer.buffer, rBuffer.allocation);
+    }
+    // Grows geometrically, so a frame rarely needs more than one buffer
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = std::max({rBuffer.minSize, 2 * rBuffer.size, size, reach});
+    bufferInfo.usage = rBuffer.usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(rDeviceContext_.GetDevice(), &bufferInfo, nullptr, &rBuffer.buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create per-frame buffer!");
+    }
+    // Coherent, so writes need no flush before the submission
+    rBuffer.allocation = rDeviceContext_.GetMemoryAllocator().AllocateBufferMemory(
+        rBuffer.buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    rBuffer.size = bufferInfo.size;
+    rBuffer.head = size;
+    return 0;
+}
+
+void FrameContext::destroyBuffer(VkBuffer buffer, MemoryAllocator::Allocation &rAllocation) {
+    vkDestroyBuffer(rDeviceContext_.GetDevice(), buffer, nullptr);
+    rDeviceContext_.GetMemoryAllocator().Free(rAllocation);
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "MemoryAllocator.h"
+#include "PipelineLayout.h"
+
+class DeviceContext;
+
+/**
+ * @brief Resources of one frame in flight. The engine keeps RenderTarget::MAX_FRAMES_IN_FLIGHT of them in a ring.
+ * Everything allocated from a frame lives until the frame slot comes around again, then it is released in bulk:
+ * one vkResetCommandPool per pool, one vkResetDescriptorPool per descriptor pool.
+ */
+class FrameContext final {
+public:
+    /// Descriptors of each type per descriptor pool, further pools are added when a frame needs more
+    static constexpr uint32_t DESCRIPTORS_PER_POOL = 256u;
+    /// Initial size of the instance buffer, it doubles whenever a frame needs more
+    static constexpr VkDeviceSize MIN_INSTANCE_BUFFER_SIZE = 1024ull * 1024;
+    /// Initial size of the uniform buffer, it doubles whenever a frame needs more
+    static constexpr VkDeviceSize MIN_UNIFORM_BUFFER_SIZE = 256ull * 1024;
+    /// Initial size of the storage buffer, it doubles whenever a frame needs more
+    static constexpr VkDeviceSize MIN_STORAGE_BUFFER_SIZE = 256ull * 1024;
+    /// Largest uniform slice, the range of the dynamic descriptor (the minimum maxUniformBufferRange of all devices)
+    static constexpr VkDeviceSize MAX_UNIFORM_SLICE_SIZE = 16384;
+    /// Set the uniform slices are bound to in pipeline layouts, its bindings are GetUniformBindings()
+    static constexpr uint32_t UNIFORM_SET = 0;
+
+    /**
+     * @brief Host visible range of a per-frame buffer, pData points to offset in the mapped buffer.
+     */
+    struct BufferRange {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        void *pData = nullptr;
+    };
+
+    /**
+     * @brief Host visible slice of the uniform buffer, bound as descriptorSet with offset as its dynamic offset.
+     */
+    struct UniformRange {
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        uint32_t offset = 0;
+        void *pData = nullptr;
+    };
+
+public:
+    explicit FrameContext(DeviceContext &rDeviceContext);
+    ~FrameContext();
+
+    FrameContext(const FrameContext &) = delete;
+    FrameContext &operator=(const FrameContext &) = delete;
+
+    /**
+     * @brief Resets all pools and releases retained objects. Only call once the fence of the previous submission of
+     * this frame signaled.
+     */
+    void Begin();
+
+    VkCommandBuffer &GetCommandBuffer() { return commandBuffer_; }
+
+    /**
+     * @brief Secondary command buffers, one per chunk, each from its own pool so chunks can be recorded concurrently.
+     * Called on the recording thread before the chunks are handed out.
+     */
+    std::vector<VkCommandBuffer> AcquireSecondaryCommandBuffers(uint32_t count);
+
+    /**
+     * @brief Allocates a descriptor set valid for this frame only. Not thread safe.
+     */
+    VkDescriptorSet AllocateDescriptorSet(VkDescriptorSetLayout layout);
+
+    /**
+     * @brief Allocates per-instance vertex data valid for this frame only, written by the CPU and read by the draws
+     * of this frame without a copy. Not thread safe.
+     */
+    BufferRange AllocateInstanceData(VkDeviceSize size);
+
+    /**
+     * @brief Allocates storage buffer data valid for this frame only, aligned to minStorageBufferOffsetAlignment.
+     * Not thread safe.
+     */
+    BufferRange AllocateStorageData(VkDeviceSize size);
+
+    /**
+     * @brief Allocates a uniform slice (at most MAX_UNIFORM_SLICE_SIZE) valid for this frame only, aligned to
+     * minUniformBufferOffsetAlignment. Slices share one descriptor set per buffer and only differ in their dynamic
+     * offset, so per-draw constants cost a copy and no descriptor writes. Not thread safe.
+     */
+    UniformRange AllocateUniformData(VkDeviceSize size);
+
+    /// One dynamic uniform buffer at binding 0, visible to vertex and fragment shaders
+    static std::vector<VkDescriptorSetLayoutBinding> GetUniformBindings();
+
+    /**
+     * @brief Keeps an object alive until the GPU finished this frame, e.g. a pipeline that was just replaced.
+     */
+    void Retain(std::shared_ptr<const void> spObject) { retained_.push_back(std::move(spObject)); }
+
+private:
+    struct SecondaryCommands {
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    };
+
+    /**
+     * @brief Persistently mapped buffer, allocated from front to back and reset every time the frame begins.
+     */
+    struct LinearBuffer {
+        VkBufferUsageFlags usage = 0;
+        VkDeviceSize minSize = 0;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        MemoryAllocator::Allocation allocation;
+        VkDeviceSize size = 0;
+        VkDeviceSize head = 0;
+    };
+
+    VkCommandPool createCommandPool();
+    VkCommandBuffer allocateCommandBuffer(VkCommandPool commandPool, VkCommandBufferLevel level);
+    VkDescriptorPool createDescriptorPool();
+    /**
+     * @brief Offset of size bytes, of which reach bytes have to be inside the buffer. Replaces the buffer by a larger
+     * one if they do not fit (a power of two alignment).
+     */
+    VkDeviceSize allocateLinear(LinearBuffer &rBuffer, VkDeviceSize size, VkDeviceSize reach, VkDeviceSize alignment);
+    void destroyBuffer(VkBuffer buffer, MemoryAllocator::Allocation &rAllocation);
+
+private:
+    DeviceContext &rDeviceContext_;
+
+    VkCommandPool commandPool_ = VK_NULL_HANDLE;
+    VkCommandBuffer commandBuffer_ = VK_NULL_HANDLE;
+    std::vector<SecondaryCommands> secondaryCommands_;
+
+    std::vector<VkDescriptorPool> descriptorPools_;
+    size_t currentDescriptorPool_ = 0;
+
+    LinearBuffer instances_;
+    LinearBuffer uniforms_;
+    VkDeviceSize uniformAlignment_ = 0;
+    LinearBuffer storage_;
+    VkDeviceSize storageAlignment_ = 0;
+    std::shared_ptr<const DescriptorSetLayout> spUniformSetLayout_;
+    // Describes the current uniform buffer, allocated again once the pools were reset or the buffer replaced
+    VkDescriptorSet uniformDescriptorSet_ = VK_NULL_HANDLE;
+    // Outgrown buffers, draws recorded earlier in the frame still read them
+    std::vector<std::pair<VkBuffer, MemoryAllocator::Allocation>> retiredBuffers_;
+
+    std::vector<std::shared_ptr<const void>> retained_;
+};
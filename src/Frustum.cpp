@@ -0,0 +1,30 @@
+#include "Frustum.h"
+
+#include <cmath>
+
+namespace {
+glm::vec4 row(const glm::mat4 &rMatrix, int index) {
+    // glm matrices are column major
+    return glm::vec4(rMatrix[0][index], rMatrix[1][index], rMatrix[2][index], rMatrix[3][index]);
+}
+
+glm::vec4 normalizePlane(const glm::vec4 &rPlane) {
+    float length = std::sqrt(rPlane.x * rPlane.x + rPlane.y * rPlane.y + rPlane.z * rPlane.z);
+    return rPlane / length;
+}
+}  // namespace
+
+Frustum::Frustum(const glm::mat4 &rViewProjection) {
+    const glm::vec4 x = row(rViewProjection, 0);
+    const glm::vec4 y = row(rViewProjection, 1);
+    const glm::vec4 z = row(rViewProjection, 2);
+    const glm::vec4 w = row(rViewProjection, 3);
+
+    // -w <= x <= w, -w <= y <= w and 0 <= z <= w in clip space
+    planes_[0] = normalizePlane(w + x);
+    planes_[1] = normalizePlane(w - x);
+    planes_[2] = normalizePlane(w + y);
+    planes_[3] = normalizePlane(w - y);
+    planes_[4] = normalizePlane(z);
+    planes_[5] = normalizePlane(w - z);
+}
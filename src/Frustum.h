@@ -0,0 +1,24 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <array>
+
+/**
+ * @brief The six planes of a view frustum pointing inwards, a point p is inside if dot(plane.xyz, p) + plane.w >= 0
+ * for every plane.
+ */
+class Frustum final {
+public:
+    /**
+     * @brief Extracts the planes from a view projection matrix with Vulkan clip space (depth in [0, 1]).
+     * The identity matrix gives the clip space volume itself.
+     */
+    explicit Frustum(const glm::mat4 &rViewProjection);
+
+    /// Planes are normalized, so plane distances of sphere centers can be compared with radii
+    const std::array<glm::vec4, 6> &GetPlanes() const { return planes_; }
+
+private:
+    std::array<glm::vec4, 6> planes_;
+};
@@ -0,0 +1,339 @@
+#include "GpuCuller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include "ComputePipeline.h"
+#include "DeviceContext.h"
+#include "InstanceData.h"
+#include "MeshBuffer.h"
+#include "RenderContext.h"
+#include "RenderQueue.h"
+#include "materials/Material.h"
+
+namespace {
+const char *CULL_SHADER_FILE = "shaders/cull.comp.spv";
+
+uint64_t batchKey(const Material *pMaterial, const MeshBuffer *pMeshBuffer) {
+    // Ids are unique, so both fit into one exact key
+    return static_cast<uint64_t>(pMaterial->GetId()) << 32 | pMeshBuffer->GetId();
+}
+
+glm::vec4 sphereOf(const Bounds &rBounds) {
+    // An infinite radius passes every plane test in the shader
+    return glm::vec4(rBounds.center.x, rBounds.center.y, rBounds.center.z, rBounds.radius);
+}
+}  // namespace
+
+GpuCuller::~GpuCuller() {
+    if (pDeviceContext_ == nullptr) {
+        return;
+    }
+    for (FrameResources &rFrame : frames_) {
+        destroyBuffer(rFrame.objects);
+        destroyBuffer(rFrame.batches);
+        destroyBuffer(rFrame.instances);
+    }
+}
+
+void GpuCuller::Add(const glm::mat4 &rTransform, const Bounds &rBounds) {
+    ObjectData &rObject = objects_.emplace_back();
+    rObject.transform = rTransform;
+    rObject.sphere = sphereOf(rBounds);
+    dirtyFrames_.push_back(0);
+    markDirty(static_cast<uint32_t>(objects_.size()) - 1);
+}
+
+void GpuCuller::Remove(uint32_t index) {
+    removeFromBatch(index);
+
+    // Dirty list entries of the last index are skipped once it is out of range
+    const uint32_t last = static_cast<uint32_t>(objects_.size()) - 1;
+    if (index != last) {
+        objects_[index] = objects_[last];
+        markDirty(index);
+    }
+    objects_.pop_back();
+    dirtyFrames_.pop_back();
+}
+
+void GpuCuller::SetTransform(uint32_t index, const glm::mat4 &rTransform) {
+    objects_[index].transform = rTransform;
+    markDirty(index);
+}
+
+void GpuCuller::SetBounds(uint32_t index, const Bounds &rBounds) {
+    accumulateCenter(index, true);
+    objects_[index].sphere = sphereOf(rBounds);
+    accumulateCenter(index, false);
+    markDirty(index);
+}
+
+void GpuCuller::SetDrawItem(uint32_t index, Material *pMaterial, const MeshBuffer *pMeshBuffer) {
+    uint32_t batch = INVALID_BATCH;
+    if (pMaterial != nullptr && pMeshBuffer != nullptr) {
+        auto [it, inserted] = batchLookup_.try_emplace(batchKey(pMaterial, pMeshBuffer), 0u);
+        if (inserted) {
+            if (!freeBatches_.empty()) {
+                it->second = freeBatches_.back();
+                freeBatches_.pop_back();
+            } else {
+                it->second = static_cast<uint32_t>(batches_.size());
+                batches_.emplace_back();
+            }
+            batches_[it->second] = Batch{pMaterial, pMeshBuffer, 0};
+        }
+        batch = it->second;
+    }
+    if (batch == objects_[index].batch) {
+        return;
+    }
+
+    removeFromBatch(index);
+    if (batch != INVALID_BATCH) {
+        batches_[batch].objectCount++;
+    }
+    objects_[index].batch = batch;
+    accumulateCenter(index, false);
+    markDirty(index);
+}
+
+bool GpuCuller::Record(const RenderContext &rContext, const Frustum &rFrustum, RenderQueue &rQueue) {
+    if (!updatePipeline(rContext)) {
+        return false;
+    }
+    pDeviceContext_ = &rContext.deviceContext;
+
+    FrameResources &rFrame = frames_[rContext.frameIndex];
+    const uint8_t frameBit = static_cast<uint8_t>(1u << rContext.frameIndex);
+    const uint32_t objectCount = static_cast<uint32_t>(objects_.size());
+    const VkMemoryPropertyFlags hostVisible =
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    // Only changed objects are copied, unless the buffer had to grow
+    ObjectData *pObjects = nullptr;
+    if (reserve(rFrame.objects, std::max(objectCount, 1u) * sizeof(ObjectData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                hostVisible)) {
+        pObjects = static_cast<ObjectData *>(rFrame.objects.allocation.pMapped);
+        std::memcpy(pObjects, objects_.data(), objectCount * sizeof(ObjectData));
+        for (uint8_t &rDirtyFrames : dirtyFrames_) {
+            rDirtyFrames &= static_cast<uint8_t>(~frameBit);
+        }
+    } else {
+        pObjects = static_cast<ObjectData *>(rFrame.objects.allocation.pMapped);
+        for (uint32_t index : rFrame.dirtyObjects) {
+            if (index < objectCount && (dirtyFrames_[index] & frameBit) != 0) {
+                pObjects[index] = objects_[index];
+                dirtyFrames_[index] &= static_cast<uint8_t>(~frameBit);
+            }
+        }
+    }
+    rFrame.dirtyObjects.clear();
+
+    // Batches are written every frame with zero instances, the culling pass counts them up
+    reserve(rFrame.batches, std::max<size_t>(batches_.size(), 1) * sizeof(BatchData),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, hostVisible);
+    std::vector<uint32_t> instanceBases(batches_.size());
+    BatchData *pBatches = static_cast<BatchData *>(rFrame.batches.allocation.pMapped);
+    uint32_t instanceCount = 0;
+    for (size_t i = 0; i < batches_.size(); i++) {
+        const Batch &rBatch = batches_[i];
+        BatchData batchData{};
+        if (rBatch.objectCount > 0) {
+            // Non-indexed draws read the first four words as VkDrawIndirectCommand with the vertex count first
+            batchData.indexCount = rBatch.pMeshBuffer->IsIndexed() ? rBatch.pMeshBuffer->GetIndexCount()
+                                                                   : rBatch.pMeshBuffer->GetVertexCount();
+            batchData.instanceBase = instanceCount;
+            batchData.materialIndex = rBatch.pMaterial->GetBindlessIndex();
+            instanceCount += rBatch.objectCount;
+        }
+        pBatches[i] = batchData;
+        instanceBases[i] = batchData.instanceBase;
+    }
+    if (instanceCount == 0) {
+        return true;
+    }
+
+    // Written by the GPU only, sized for the case that every object is visible
+    reserve(rFrame.instances, instanceCount * sizeof(InstanceData),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    VkDescriptorSet descriptorSet =
+        rContext.frameContext.AllocateDescriptorSet(spPipeline_->GetLayout().GetSetLayouts()[0]->GetHandle());
+    std::array<VkDescriptorBufferInfo, 3> bufferInfos = {{
+        {rFrame.objects.buffer, 0, VK_WHOLE_SIZE},
+        {rFrame.batches.buffer, 0, VK_WHOLE_SIZE},
+        {rFrame.instances.buffer, 0, VK_WHOLE_SIZE},
+    }};
+    std::array<VkWriteDescriptorSet, 3> descriptorWrites{};
+    for (uint32_t binding = 0; binding < descriptorWrites.size(); binding++) {
+        descriptorWrites[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[binding].dstSet = descriptorSet;
+        descriptorWrites[binding].dstBinding = binding;
+        descriptorWrites[binding].descriptorCount = 1;
+        descriptorWrites[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[binding].pBufferInfo = &bufferInfos[binding];
+    }
+    vkUpdateDescriptorSets(rContext.deviceContext.GetDevice(), static_cast<uint32_t>(descriptorWrites.size()),
+                           descriptorWrites.data(), 0, nullptr);
+
+    PushConstants pushConstants;
+    pushConstants.planes = rFrustum.GetPlanes();
+    pushConstants.objectCount = objectCount;
+
+    VkPipelineLayout pipelineLayout = spPipeline_->GetLayout().GetHandle();
+    spPipeline_->Bind(rContext.commandBuffer);
+    vkCmdBindDescriptorSets(rContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1,
+                            &descriptorSet, 0, nullptr);
+    vkCmdPushConstants(rContext.commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants),
+                       &pushConstants);
+    vkCmdDispatch(rContext.commandBuffer, (objectCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+    // Draws read the instance counts as indirect parameters and the transforms as vertex input
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+    vkCmdPipelineBarrier(rContext.commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0,
+                         nullptr, 0, nullptr);
+
+    for (size_t i = 0; i < batches_.size(); i++) {
+        const Batch &rBatch = batches_[i];
+        if (rBatch.objectCount == 0 || !rBatch.pMaterial->IsReady()) {
+            continue;
+        }
+
+        // The instance range of the batch is bound at its offset, so the commands need no first instance
+        // (drawIndirectFirstInstance is an optional feature)
+        DrawPacket packet{&rBatch.pMaterial->GetPipeline(), rBatch.pMaterial, rBatch.pMeshBuffer,
+                          rFrame.instances.buffer, instanceBases[i] * sizeof(InstanceData), 0, 0};
+        packet.indirectBuffer = rFrame.batches.buffer;
+        packet.indirectOffset = i * sizeof(BatchData);
+        packet.uniformSet = rContext.frameUniforms.descriptorSet;
+        packet.uniformOffset = rContext.frameUniforms.offset;
+        const float depth =
+            rBatch.finiteCount > 0
+                ? RenderQueue::ViewDepth(rContext.viewProjection,
+                                         rBatch.centerSum / static_cast<float>(rBatch.finiteCount))
+                : 0.0f;
+        uint64_t sortKey = RenderQueue::MakeSortKey(RenderQueue::Pass::Opaque, packet.pPipeline->GetId(),
+                                                    rBatch.pMaterial->GetId(), rBatch.pMeshBuffer->GetId(), depth);
+        rQueue.Push(sortKey, packet);
+    }
+    return true;
+}
+
+void GpuCuller::markDirty(uint32_t index) {
+    for (uint32_t frame = 0; frame < frames_.size(); frame++) {
+        if ((dirtyFrames_[index] & (1u << frame)) == 0) {
+            frames_[frame].dirtyObjects.push_back(index);
+        }
+    }
+    dirtyFrames_[index] = static_cast<uint8_t>((1u << frames_.size()) - 1);
+}
+
+void GpuCuller::removeFromBatch(uint32_t index) {
+    const uint32_t batch = objects_[index].batch;
+    if (batch == INVALID_BATCH) {
+        return;
+    }
+
+    accumulateCenter(index, true);
+    Batch &rBatch = batches_[batch];
+    if (--rBatch.objectCount == 0) {
+        batchLookup_.erase(batchKey(rBatch.pMaterial, rBatch.pMeshBuffer));
+        rBatch = Batch{};
+        freeBatches_.push_back(batch);
+    }
+    objects_[index].batch = INVALID_BATCH;
+}
+
+void GpuCuller::accumulateCenter(uint32_t index, bool remove) {
+    const ObjectData &rObject = objects_[index];
+    if (rObject.batch == INVALID_BATCH || !std::isfinite(rObject.sphere.w)) {
+        return;
+    }
+
+    Batch &rBatch = batches_[rObject.batch];
+    const glm::vec3 center(rObject.sphere);
+    if (remove) {
+        rBatch.centerSum -= center;
+        rBatch.finiteCount--;
+    } else {
+        rBatch.centerSum += center;
+        rBatch.finiteCount++;
+    }
+}
+
+bool GpuCuller::updatePipeline(const RenderContext &rContext) {
+    ShaderLibrary &rShaderLibrary = rContext.deviceContext.GetShaderLibrary();
+    if (spPipeline_ != nullptr && shaderGeneration_ == rShaderLibrary.GetGeneration()) {
+        return true;
+    }
+    std::shared_ptr<const ShaderModule> spShader = rShaderLibrary.GetShaderModule(CULL_SHADER_FILE);
+    if (spShader == nullptr) {
+        return false;
+    }
+    shaderGeneration_ = rShaderLibrary.GetGeneration();
+    if (spPipeline_ != nullptr && &spPipeline_->GetShaderModule() == spShader.get()) {
+        return true;
+    }
+
+    std::vector<VkDescriptorSetLayoutBinding> bindings(3);
+    for (uint32_t binding = 0; binding < bindings.size(); binding++) {
+        bindings[binding].binding = binding;
+        bindings[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[binding].descriptorCount = 1;
+        bindings[binding].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    VkPushConstantRange pushConstantRange{VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants)};
+
+    PipelineRegistry &rRegistry = rContext.deviceContext.GetPipelineRegistry();
+    std::shared_ptr<const PipelineLayout> spPipelineLayout =
+        rRegistry.GetPipelineLayout({rRegistry.GetDescriptorSetLayout(bindings)}, {pushConstantRange});
+
+    if (spPipeline_ != nullptr) {
+        // Frames still in flight may use the previous pipeline
+        rContext.frameContext.Retain(spPipeline_);
+    }
+    spPipeline_ = std::make_shared<ComputePipeline>(rContext.deviceContext, std::move(spShader),
+                                                    std::move(spPipelineLayout));
+    return true;
+}
+
+bool GpuCuller::reserve(Buffer &rBuffer, VkDeviceSize size, VkBufferUsageFlags usage,
+                        VkMemoryPropertyFlags properties) {
+    if (rBuffer.buffer != VK_NULL_HANDLE && rBuffer.size >= size) {
+        return false;
+    }
+
+    // Grows geometrically, so a growing scene rarely recreates buffers
+    size = std::max(size, 2 * rBuffer.size);
+    // The previous frame of this slot finished, nothing reads the old buffer anymore
+    destroyBuffer(rBuffer);
+
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(pDeviceContext_->GetDevice(), &bufferInfo, nullptr, &rBuffer.buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create culling buffer!");
+    }
+    rBuffer.allocation = pDeviceContext_->GetMemoryAllocator().AllocateBufferMemory(rBuffer.buffer, properties);
+    rBuffer.size = size;
+    return true;
+}
+
+void GpuCuller::destroyBuffer(Buffer &rBuffer) {
+    if (rBuffer.buffer == VK_NULL_HANDLE) {
+        return;
+    }
+    vkDestroyBuffer(pDeviceContext_->GetDevice(), rBuffer.buffer, nullptr);
+    pDeviceContext_->GetMemoryAllocator().Free(rBuffer.allocation);
+    rBuffer = Buffer{};
+}
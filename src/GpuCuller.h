@@ -0,0 +1,142 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "Bounds.h"
+#include "Frustum.h"
+#include "MemoryAllocator.h"
+#include "RenderTarget.h"
+
+class ComputePipeline;
+class DeviceContext;
+class Material;
+class MeshBuffer;
+struct RenderContext;
+class RenderQueue;
+
+/**
+ * @brief GPU driven drawing: keeps a GPU copy of the transforms and bounding spheres of all objects, a compute pass
+ * culls them against the frustum and fills one indirect draw command and the instance transforms per batch (objects
+ * sharing material and mesh buffer). The CPU only copies changed objects and pushes one draw per batch, so its cost
+ * does not grow with the number of objects.
+ * Objects are addressed by dense index, removing moves the last object into the hole like the Scene arrays.
+ */
+class GpuCuller final {
+public:
+    static constexpr uint32_t INVALID_BATCH = std::numeric_limits<uint32_t>::max();
+    /// local_size_x of shaders/cull.comp
+    static constexpr uint32_t WORKGROUP_SIZE = 64u;
+
+public:
+    GpuCuller() = default;
+    ~GpuCuller();
+
+    GpuCuller(const GpuCuller &) = delete;
+    GpuCuller &operator=(const GpuCuller &) = delete;
+
+    void Add(const glm::mat4 &rTransform, const Bounds &rBounds);
+    void Remove(uint32_t index);
+
+    void SetTransform(uint32_t index, const glm::mat4 &rTransform);
+    void SetBounds(uint32_t index, const Bounds &rBounds);
+
+    /**
+     * @brief Puts the object into the batch of material and mesh buffer, it is not drawn while either is nullptr.
+     */
+    void SetDrawItem(uint32_t index, Material *pMaterial, const MeshBuffer *pMeshBuffer);
+
+    /**
+     * @brief Records the culling dispatch into rContext.commandBuffer (before the render pass begins) and pushes
+     * one indirect draw per batch into the queue.
+     * @return false while the culling shader is not loaded, nothing is recorded then
+     */
+    bool Record(const RenderContext &rContext, const Frustum &rFrustum, RenderQueue &rQueue);
+
+    size_t GetBatchCount() const { return batchLookup_.size(); }
+
+private:
+    // Object in shaders/cull.comp (std430)
+    struct ObjectData {
+        glm::mat4 transform;
+        glm::vec4 sphere;
+        uint32_t batch = INVALID_BATCH;
+        uint32_t padding[3] = {};
+    };
+
+    // Batch in shaders/cull.comp, VkDrawIndexedIndirectCommand (or VkDrawIndirectCommand), the first instance of the
+    // batch in the instance buffer and the bindless index of its material
+    struct BatchData {
+        uint32_t indexCount;
+        uint32_t instanceCount;
+        uint32_t firstIndex;
+        int32_t vertexOffset;
+        uint32_t firstInstance;
+        uint32_t instanceBase;
+        uint32_t materialIndex;
+    };
+
+    struct PushConstants {
+        std::array<glm::vec4, 6> planes;
+        uint32_t objectCount;
+    };
+
+    struct Batch {
+        Material *pMaterial = nullptr;
+        const MeshBuffer *pMeshBuffer = nullptr;
+        uint32_t objectCount = 0;
+        // Sum of the sphere centers of the objects with finite bounds, their mean gives the sort depth
+        glm::vec3 centerSum = glm::vec3(0.0f);
+        uint32_t finiteCount = 0;
+    };
+
+    struct Buffer {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        MemoryAllocator::Allocation allocation;
+        VkDeviceSize size = 0;
+    };
+
+    /**
+     * @brief Buffers of one frame in flight, so the CPU never writes data an earlier frame still reads.
+     */
+    struct FrameResources {
+        Buffer objects;
+        Buffer batches;
+        Buffer instances;
+        // Objects whose copy in this frame is outdated, may hold duplicates and removed indices
+        std::vector<uint32_t> dirtyObjects;
+    };
+
+    void markDirty(uint32_t index);
+    void removeFromBatch(uint32_t index);
+    /// Adds the center of the object to the sum of its batch, or subtracts it if remove is set
+    void accumulateCenter(uint32_t index, bool remove);
+    bool updatePipeline(const RenderContext &rContext);
+
+    /// Recreates the buffer if it is smaller than size, returns true if it did (the content is lost)
+    bool reserve(Buffer &rBuffer, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
+    void destroyBuffer(Buffer &rBuffer);
+
+private:
+    std::vector<ObjectData> objects_;
+    // Bit per frame in flight, set while the object is in that frame's dirty list
+    std::vector<uint8_t> dirtyFrames_;
+
+    std::vector<Batch> batches_;
+    std::vector<uint32_t> freeBatches_;
+    // Material and mesh buffer id to batch
+    std::unordered_map<uint64_t, uint32_t> batchLookup_;
+
+    // Set by the first Record, buffers only exist from then on
+    DeviceContext *pDeviceContext_ = nullptr;
+    std::shared_ptr<ComputePipeline> spPipeline_;
+    // Shader library generation the shader was looked up at
+    uint64_t shaderGeneration_ = 0;
+    std::array<FrameResources, RenderTarget::MAX_FRAMES_IN_FLIGHT> frames_;
+};
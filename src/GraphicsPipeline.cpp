@@ -1,235 +1,217 @@
 #include "GraphicsPipeline.h"
 
 #include <array>
-#include <cassert>
-#include <glm/glm.hpp>
+#include <cstring>
 #include <stdexcept>
 
 #include "DeviceContext.h"
-#include "Swapchain.h"
+#include "Hash.h"
 
-GraphicsPipeline::GraphicsPipeline(DeviceContext &rDeviceContext, Swapchain &rSwapchain, VkRenderPass renderPass,
-                                   VkFormat imageFormat)
-    : deviceContext_(rDeviceContext), renderPass_(renderPass), extent_(rSwapchain.GetExtent2D()) {}
-
-GraphicsPipeline::~GraphicsPipeline() {
-    vkDestroyPipeline(deviceContext_.GetDevice(), pipeline_, nullptr);
-    vkDestroyPipelineLayout(deviceContext_.GetDevice(), pipelineLayout_, nullptr);
-    vkDestroyDescriptorSetLayout(deviceContext_.GetDevice(), descriptorSetLayout_, nullptr);
-    destroyShaderModules();
+namespace {
+// Vulkan description structs used in the state are made of 32 bit members and pointers, they have no padding
+template <typename T>
+bool equalBytes(const std::vector<T> &rA, const std::vector<T> &rB) {
+    return rA.size() == rB.size() && (rA.empty() || std::memcmp(rA.data(), rB.data(), rA.size() * sizeof(T)) == 0);
 }
+}  // namespace
 
-VkShaderModule GraphicsPipeline::createShaderModule(const std::vector<char> &rCode) {
-    VkShaderModuleCreateInfo createInfo{};
-    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = rCode.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t *>(rCode.data());
-    VkShaderModule shaderModule;
-    if (vkCreateShaderModule(deviceContext_.GetDevice(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create shader module!");
+uint64_t GraphicsPipeline::State::ComputeHash() const {
+    uint64_t hash = Hash::Mix(shaderStages.size());
+    for (const ShaderStage &rStage : shaderStages) {
+        hash = Hash::Combine(hash, rStage.Flags);
+        hash = Hash::Combine(hash, rStage.Module->GetHash());
+    }
+    hash = Hash::Combine(hash, Hash::Bytes(inputBindingDescriptions));
+    hash = Hash::Combine(hash, Hash::Bytes(inputAttributeDescriptions));
+    hash = Hash::Combine(hash, Hash::Bytes(descriptorSetLayoutBindings));
+    for (const std::shared_ptr<const DescriptorSetLayout> &rSetLayout : extraSetLayouts) {
+        hash = Hash::Combine(hash, reinterpret_cast<uint64_t>(rSetLayout.get()));
     }
-    return shaderModule;
+    hash = Hash::Combine(hash, Hash::Bytes(pushConstantRanges));
+    hash = Hash::Combine(hash, reinterpret_cast<uint64_t>(renderPass));
+    hash = Hash::Combine(hash, colorFormat);
+    hash = Hash::Combine(hash, subpass);
+    hash = Hash::Combine(hash, colorAttachmentCount);
+    hash = Hash::Combine(hash, topology);
+    hash = Hash::Combine(hash, polygonMode);
+    hash = Hash::Combine(hash, cullMode);
+    hash = Hash::Combine(hash, frontFace);
+    hash = Hash::Combine(hash, blendEnable);
+    hash = Hash::Combine(hash, depthTestEnable);
+    return Hash::Combine(hash, depthWriteEnable);
 }
 
-void GraphicsPipeline::SetShaderModules(std::vector<ShaderModule> &&rrModules) {
-    shaderModules_ = std::move(rrModules);
-    shaderModulesDirty_ = true;
+bool GraphicsPipeline::State::operator==(const State &rOther) const {
+    if (shaderStages.size() != rOther.shaderStages.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < shaderStages.size(); i++) {
+        if (shaderStages[i].Flags != rOther.shaderStages[i].Flags ||
+            shaderStages[i].Module != rOther.shaderStages[i].Module) {
+            return false;
+        }
+    }
+    return equalBytes(inputBindingDescriptions, rOther.inputBindingDescriptions) &&
+           equalBytes(inputAttributeDescriptions, rOther.inputAttributeDescriptions) &&
+           equalBytes(descriptorSetLayoutBindings, rOther.descriptorSetLayoutBindings) &&
+           extraSetLayouts == rOther.extraSetLayouts &&
+           equalBytes(pushConstantRanges, rOther.pushConstantRanges) && renderPass == rOther.renderPass &&
+           colorFormat == rOther.colorFormat && subpass == rOther.subpass &&
+           colorAttachmentCount == rOther.colorAttachmentCount && topology == rOther.topology &&
+           polygonMode == rOther.polygonMode && cullMode == rOther.cullMode && frontFace == rOther.frontFace &&
+           blendEnable == rOther.blendEnable && depthTestEnable == rOther.depthTestEnable &&
+           depthWriteEnable == rOther.depthWriteEnable;
 }
 
-void GraphicsPipeline::SetDescriptorSetBinding(std::vector<VkDescriptorSetLayoutBinding> &&rrBindings) {
-    descriptorSetLayoutBindings_ = std::move(rrBindings);
-    descriptorSetLayoutBindingDirty_ = true;
-}
+GraphicsPipeline::GraphicsPipeline(DeviceContext &rDeviceContext, const State &rState,
+                                   std::shared_ptr<const PipelineLayout> spPipelineLayout)
+    : deviceContext_(rDeviceContext),
+      id_(nextId_++),
+      state_(rState),
+      spPipelineLayout_(std::move(spPipelineLayout)) {
+    // Modules are owned and shared by the ShaderLibrary
+    std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+    for (const ShaderStage &rStage : state_.shaderStages) {
+        VkPipelineShaderStageCreateInfo shaderStageInfo{};
+        shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStageInfo.stage = rStage.Flags;
+        shaderStageInfo.module = rStage.Module->GetHandle();
+        shaderStageInfo.pName = "main";
+        shaderStages.push_back(shaderStageInfo);
+    }
 
-void GraphicsPipeline::SetVertexBindings(
-    std::vector<VkVertexInputBindingDescription> &&rrInputBindingDescriptions,
-    std::vector<VkVertexInputAttributeDescription> &&rrInputAttributeDescriptions) {
-    inputBindingDescriptions_ = std::move(rrInputBindingDescriptions);
-    inputAttributeDescriptions_ = std::move(rrInputAttributeDescriptions);
-    inputBindingsDirty_ = true;
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(state_.inputBindingDescriptions.size());
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(state_.inputAttributeDescriptions.size());
+    vertexInputInfo.pVertexBindingDescriptions = state_.inputBindingDescriptions.data();
+    vertexInputInfo.pVertexAttributeDescriptions = state_.inputAttributeDescriptions.data();
+
+    // Setup geometry type
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = state_.topology;
+    inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+    // Where to draw and which pixels should be drawn, both are set per command buffer (see SetViewport)
+    VkPipelineViewportStateCreateInfo viewportState{};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.pViewports = nullptr;
+    viewportState.scissorCount = 1;
+    viewportState.pScissors = nullptr;
+
+    // Resizing only changes the dynamic state, the pipeline stays valid
+    std::array<VkDynamicState, 2> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    VkPipelineDynamicStateCreateInfo dynamicState{};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+    dynamicState.pDynamicStates = dynamicStates.data();
+
+    // Rasterizer takes geometry from vertex shader and turns it into fragments for fragment shader
+    VkPipelineRasterizationStateCreateInfo rasterizer{};
+    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.depthClampEnable = VK_FALSE;
+    rasterizer.rasterizerDiscardEnable = VK_FALSE;
+    rasterizer.polygonMode = state_.polygonMode;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = state_.cullMode;
+    rasterizer.frontFace = state_.frontFace;
+    rasterizer.depthBiasEnable = VK_FALSE;
+    rasterizer.depthBiasConstantFactor = 0.0f;  // Optional
+    rasterizer.depthBiasClamp = 0.0f;           // Optional
+    rasterizer.depthBiasSlopeFactor = 0.0f;     // Optional
+
+    // Multisampling
+    VkPipelineMultisampleStateCreateInfo multisampling{};
+    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.sampleShadingEnable = VK_FALSE;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisampling.minSampleShading = 1.0f;           // Optional
+    multisampling.pSampleMask = nullptr;             // Optional
+    multisampling.alphaToCoverageEnable = VK_FALSE;  // Optional
+    multisampling.alphaToOneEnable = VK_FALSE;       // Optional
+
+    // Color blending
+    VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+    colorBlendAttachment.colorWriteMask =
+        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    colorBlendAttachment.blendEnable = state_.blendEnable ? VK_TRUE : VK_FALSE;
+    colorBlendAttachment.srcColorBlendFactor =
+        state_.blendEnable ? VK_BLEND_FACTOR_SRC_ALPHA : VK_BLEND_FACTOR_ONE;  // Optional
+    colorBlendAttachment.dstColorBlendFactor =
+        state_.blendEnable ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ZERO;  // Optional
+    colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;              // Optional
+    colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;   // Optional
+    colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;  // Optional
+    colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;              // Optional
+
+    // E.g. the G-buffer of deferred shading, every attachment is written alike
+    std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments(state_.colorAttachmentCount,
+                                                                           colorBlendAttachment);
+
+    VkPipelineColorBlendStateCreateInfo colorBlending{};
+    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.logicOpEnable = VK_FALSE;
+    colorBlending.logicOp = VK_LOGIC_OP_COPY;  // Optional
+    colorBlending.attachmentCount = static_cast<uint32_t>(colorBlendAttachments.size());
+    colorBlending.pAttachments = colorBlendAttachments.data();
+    colorBlending.blendConstants[0] = 0.0f;  // Optional
+    colorBlending.blendConstants[1] = 0.0f;  // Optional
+    colorBlending.blendConstants[2] = 0.0f;  // Optional
+    colorBlending.blendConstants[3] = 0.0f;  // Optional
+
+    // Only read for subpasses with a depth attachment
+    VkPipelineDepthStencilStateCreateInfo depthStencil{};
+    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable = state_.depthTestEnable ? VK_TRUE : VK_FALSE;
+    depthStencil.depthWriteEnable = state_.depthWriteEnable ? VK_TRUE : VK_FALSE;
+    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+    depthStencil.depthBoundsTestEnable = VK_FALSE;
+    depthStencil.stencilTestEnable = VK_FALSE;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+    pipelineInfo.pStages = shaderStages.data();
+    pipelineInfo.pVertexInputState = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pDepthStencilState = &depthStencil;
+    pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = spPipelineLayout_->GetHandle();
+    pipelineInfo.renderPass = state_.renderPass;
+    pipelineInfo.subpass = state_.subpass;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;  // Optional
+    pipelineInfo.basePipelineIndex = -1;               // Optional
+
+    // Shared cache, so recreating (e.g. after a shader reload) and later runs skip compilation
+    pipeline_ = deviceContext_.GetPipelineCache().CreateGraphicsPipeline(pipelineInfo);
 }
 
-void GraphicsPipeline::Update() {
-    if (shaderModulesDirty_ || descriptorSetLayoutBindingDirty_ || inputBindingsDirty_) {
-        if (shaderModulesDirty_) {
-            // Go through current shader modules and create
-            destroyShaderModules();
-            createShaderModules();
-            shaderModulesDirty_ = false;
-        }
-
-        /*
-        // Create descriptor set layout
-        VkDescriptorSetLayoutBinding uboLayoutBinding{};
-        uboLayoutBinding.binding = 0;
-        uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        uboLayoutBinding.descriptorCount = 1;
-        uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-        uboLayoutBinding.pImmutableSamplers = nullptr;  // Optional
-        */
-
-        VkDescriptorSetLayoutCreateInfo layoutInfo{};
-        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        layoutInfo.bindingCount = static_cast<uint32_t>(descriptorSetLayoutBindings_.size());
-        layoutInfo.pBindings = descriptorSetLayoutBindings_.data();
-
-        // Needs to be destroyed
-        if (vkCreateDescriptorSetLayout(deviceContext_.GetDevice(), &layoutInfo, nullptr, &descriptorSetLayout_) !=
-            VK_SUCCESS) {
-            throw std::runtime_error("failed to create descriptor set layout!");
-        }
-
-        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipelineLayoutInfo.setLayoutCount = 1;                   // Optional
-        pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout_;  // Optional
-        pipelineLayoutInfo.pushConstantRangeCount = 0;           // Optional
-        pipelineLayoutInfo.pPushConstantRanges = nullptr;        // Optional
-
-        if (vkCreatePipelineLayout(deviceContext_.GetDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout_) !=
-            VK_SUCCESS) {
-            throw std::runtime_error("failed to create pipeline layout!");
-        }
-
-        VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-        vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(inputBindingDescriptions_.size());
-        vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(inputAttributeDescriptions_.size());
-        vertexInputInfo.pVertexBindingDescriptions = inputBindingDescriptions_.data();
-        vertexInputInfo.pVertexAttributeDescriptions = inputAttributeDescriptions_.data();
-
-        // Setup geometry type
-        VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-        inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-        inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-        inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-        // Where to draw
-        VkViewport viewport{};
-        viewport.x = 0.0f;
-        viewport.y = 0.0f;
-        viewport.width = static_cast<float>(extent_.width);
-        viewport.height = static_cast<float>(extent_.height);
-        viewport.minDepth = 0.0f;
-        viewport.maxDepth = 1.0f;
-
-        // Which pixels should be drawn (anything outside gets discarded)
-        VkRect2D scissor{};
-        scissor.offset = {0, 0};
-        scissor.extent = extent_;
-
-        // Compile both into viewport state
-        VkPipelineViewportStateCreateInfo viewportState{};
-        viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-        viewportState.viewportCount = 1;
-        viewportState.pViewports = &viewport;
-        viewportState.scissorCount = 1;
-        viewportState.pScissors = &scissor;
-
-        // Rasterizer takes geometry from vertex shader and turns it into fragments for fragment shader
-        VkPipelineRasterizationStateCreateInfo rasterizer{};
-        rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-        rasterizer.depthClampEnable = VK_FALSE;
-        rasterizer.rasterizerDiscardEnable = VK_FALSE;
-        rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-        rasterizer.lineWidth = 1.0f;
-        rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-        rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
-        rasterizer.depthBiasEnable = VK_FALSE;
-        rasterizer.depthBiasConstantFactor = 0.0f;  // Optional
-        rasterizer.depthBiasClamp = 0.0f;           // Optional
-        rasterizer.depthBiasSlopeFactor = 0.0f;     // Optional
-
-        // Multisampling
-        VkPipelineMultisampleStateCreateInfo multisampling{};
-        multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-        multisampling.sampleShadingEnable = VK_FALSE;
-        multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-        multisampling.minSampleShading = 1.0f;           // Optional
-        multisampling.pSampleMask = nullptr;             // Optional
-        multisampling.alphaToCoverageEnable = VK_FALSE;  // Optional
-        multisampling.alphaToOneEnable = VK_FALSE;       // Optional
-
-        // Color blending
-        VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-        colorBlendAttachment.colorWriteMask =
-            VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-        colorBlendAttachment.blendEnable = VK_FALSE;
-        colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;   // Optional
-        colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;  // Optional
-        colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;              // Optional
-        colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;   // Optional
-        colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;  // Optional
-        colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;              // Optional
-
-        VkPipelineColorBlendStateCreateInfo colorBlending{};
-        colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-        colorBlending.logicOpEnable = VK_FALSE;
-        colorBlending.logicOp = VK_LOGIC_OP_COPY;  // Optional
-        colorBlending.attachmentCount = 1;
-        colorBlending.pAttachments = &colorBlendAttachment;
-        colorBlending.blendConstants[0] = 0.0f;  // Optional
-        colorBlending.blendConstants[1] = 0.0f;  // Optional
-        colorBlending.blendConstants[2] = 0.0f;  // Optional
-        colorBlending.blendConstants[3] = 0.0f;  // Optional
-
-        VkGraphicsPipelineCreateInfo pipelineInfo{};
-        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages_.size());
-        pipelineInfo.pStages = shaderStages_.data();
-        pipelineInfo.pVertexInputState = &vertexInputInfo;
-        pipelineInfo.pInputAssemblyState = &inputAssembly;
-        pipelineInfo.pViewportState = &viewportState;
-        pipelineInfo.pRasterizationState = &rasterizer;
-        pipelineInfo.pMultisampleState = &multisampling;
-        pipelineInfo.pDepthStencilState = nullptr;  // Optional
-        pipelineInfo.pColorBlendState = &colorBlending;
-        pipelineInfo.pDynamicState = nullptr;  // Optional
-        pipelineInfo.layout = pipelineLayout_;
-        pipelineInfo.renderPass = renderPass_;
-        pipelineInfo.subpass = 0;
-        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;  // Optional
-        pipelineInfo.basePipelineIndex = -1;               // Optional
-
-        if (vkCreateGraphicsPipelines(deviceContext_.GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr,
-                                      &pipeline_) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create graphics pipeline!");
-        }
-
-        descriptorSetLayoutBindingDirty_ = false;
-        inputBindingsDirty_ = false;
-    }
-
-    shaderModulesDirty_ = false;
+GraphicsPipeline::~GraphicsPipeline() { vkDestroyPipeline(deviceContext_.GetDevice(), pipeline_, nullptr); }
+
+void GraphicsPipeline::SetViewport(VkCommandBuffer &rCommandBuffer, VkExtent2D extent) {
+    VkViewport viewport{};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = static_cast<float>(extent.width);
+    viewport.height = static_cast<float>(extent.height);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(rCommandBuffer, 0, 1, &viewport);
+
+    // Anything outside gets discarded
+    VkRect2D scissor{};
+    scissor.offset = {0, 0};
+    scissor.extent = extent;
+    vkCmdSetScissor(rCommandBuffer, 0, 1, &scissor);
 }
 
 void GraphicsPipeline::Bind(VkCommandBuffer &rCommandBuffer) {
     // Bind graphics pipeline
     vkCmdBindPipeline(rCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_);
-
-    // vkCmdBindDescriptorSets(rCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1,
-    // &m_descriptorSets[i], 0, nullptr);
-}
-
-void GraphicsPipeline::destroyShaderModules() {
-    for (VkPipelineShaderStageCreateInfo &rInfo : shaderStages_) {
-        // destroy old shader modules
-        vkDestroyShaderModule(deviceContext_.GetDevice(), rInfo.module, nullptr);
-    }
-    shaderStages_.clear();
-}
-
-void GraphicsPipeline::createShaderModules() {
-    assert(shaderStages_.empty());
-    for (const ShaderModule &rModule : shaderModules_) {
-        VkShaderModule shaderModule = createShaderModule(rModule.Code);
-
-        VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
-        vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        vertShaderStageInfo.stage = rModule.Flags;
-        vertShaderStageInfo.module = shaderModule;
-        vertShaderStageInfo.pName = "main";
-
-        shaderStages_.push_back(std::move(vertShaderStageInfo));
-    }
 }
@@ -1,54 +1,86 @@
 #pragma once
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <vector>
-#include "DeviceContext.h"
-#include "Swapchain.h"
+#include "PipelineLayout.h"
+#include "ShaderModule.h"
 
+class DeviceContext;
+
+/**
+ * @brief Immutable graphics pipeline, created and shared by the PipelineRegistry.
+ */
 class GraphicsPipeline {
 public:
-    struct ShaderModule {
+    struct ShaderStage {
         VkShaderStageFlagBits Flags;
-        std::vector<char> Code;
+        std::shared_ptr<const ShaderModule> Module;
     };
 
-public:
-    GraphicsPipeline(DeviceContext &rDeviceContext, Swapchain &rSwapchain, VkRenderPass renderPass,
-                     VkFormat imageFormat);
-    virtual ~GraphicsPipeline();
-    VkShaderModule createShaderModule(const std::vector<char> &rCode);
+    /**
+     * @brief Everything that ends up in the pipeline, two pipelines with equal state are interchangeable.
+     */
+    struct State {
+        std::vector<ShaderStage> shaderStages;
+        std::vector<VkVertexInputBindingDescription> inputBindingDescriptions;
+        std::vector<VkVertexInputAttributeDescription> inputAttributeDescriptions;
+        /// Set 0, created by the registry
+        std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings;
+        /// Sets 1 and up, for layouts the registry cannot create (e.g. bindless)
+        std::vector<std::shared_ptr<const DescriptorSetLayout>> extraSetLayouts;
+        std::vector<VkPushConstantRange> pushConstantRanges;
 
-    void SetShaderModules(std::vector<ShaderModule> &&rrModules);
+        // Viewport and scissor are dynamic, the extent is not part of the pipeline.
+        // The color format guards against a destroyed render pass handle being reused for another format.
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+        uint32_t subpass = 0;
+        /// Color attachments of the subpass, all written with the same blend state
+        uint32_t colorAttachmentCount = 1;
 
-    void SetDescriptorSetBinding(std::vector<VkDescriptorSetLayoutBinding> &&rrBindings);
+        VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+        VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+        VkFrontFace frontFace = VK_FRONT_FACE_CLOCKWISE;
+        bool blendEnable = false;
+        bool depthTestEnable = false;
+        bool depthWriteEnable = false;
 
-    void SetVertexBindings(std::vector<VkVertexInputBindingDescription> &&rrInputBindingDescriptions,
-                           std::vector<VkVertexInputAttributeDescription> &&rrInputAttributeDescriptions);
+        /// Shader modules are content addressed by the ShaderLibrary, equal code means equal module
+        uint64_t ComputeHash() const;
+        bool operator==(const State &rOther) const;
+    };
 
-    void Update();
-    void Bind(VkCommandBuffer &rCommandBuffer);
+public:
+    GraphicsPipeline(DeviceContext &rDeviceContext, const State &rState,
+                     std::shared_ptr<const PipelineLayout> spPipelineLayout);
+    virtual ~GraphicsPipeline();
 
-private:
-    void destroyShaderModules();
-    void createShaderModules();
+    GraphicsPipeline(const GraphicsPipeline &) = delete;
+    GraphicsPipeline &operator=(const GraphicsPipeline &) = delete;
 
-private:
-    DeviceContext &deviceContext_;
-    VkRenderPass renderPass_;
-    VkExtent2D extent_;
+    /// Unique per pipeline, used to sort draws
+    uint32_t GetId() const { return id_; }
+    const State &GetState() const { return state_; }
+    const PipelineLayout &GetLayout() const { return *spPipelineLayout_; }
 
-    std::vector<VkPipelineShaderStageCreateInfo> shaderStages_;
-    std::vector<ShaderModule> shaderModules_;
-    bool shaderModulesDirty_ = false;
+    void Bind(VkCommandBuffer &rCommandBuffer);
 
-    std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings_;
-    bool descriptorSetLayoutBindingDirty_ = false;
+    /**
+     * @brief Sets viewport and scissor to cover extent. They are dynamic state of every pipeline and stay valid
+     * across pipeline binds, so this is recorded once per command buffer.
+     */
+    static void SetViewport(VkCommandBuffer &rCommandBuffer, VkExtent2D extent);
 
-    std::vector<VkVertexInputBindingDescription> inputBindingDescriptions_;
-    std::vector<VkVertexInputAttributeDescription> inputAttributeDescriptions_;
-    bool inputBindingsDirty_ = false;
+private:
+    static inline std::atomic<uint32_t> nextId_ = 0;
 
-    VkDescriptorSetLayout descriptorSetLayout_ = VK_NULL_HANDLE;
-    VkPipelineLayout pipelineLayout_ = VK_NULL_HANDLE;
+    DeviceContext &deviceContext_;
+    uint32_t id_;
+    State state_;
+    std::shared_ptr<const PipelineLayout> spPipelineLayout_;
     VkPipeline pipeline_ = VK_NULL_HANDLE;
 };
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+/**
+ * @brief Fast non-cryptographic 64 bit hashing of byte ranges, used for cache keys.
+ */
+class Hash final {
+public:
+    Hash() = delete;
+
+    /**
+     * @brief Finalizer of MurmurHash3, spreads every input bit over the whole value.
+     */
+    static uint64_t Mix(uint64_t value) {
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccdull;
+        value ^= value >> 33;
+        value *= 0xc4ceb9fe1a85ec53ull;
+        value ^= value >> 33;
+        return value;
+    }
+
+    static uint64_t Combine(uint64_t seed, uint64_t value) {
+        return Mix(seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2)));
+    }
+
+    /**
+     * @brief Word wise multiply-rotate hash, hashing large ranges is bound by reading the memory.
+     */
+    static uint64_t Bytes(std::span<const unsigned char> data) {
+        const uint64_t multiplier = 0x9e3779b97f4a7c15ull;
+        uint64_t hash = Mix(data.size());
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= data.size(); i += sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, data.data() + i, sizeof(word));
+            uint64_t value = hash ^ Mix(word);
+            hash = (value << 27 | value >> 37) * multiplier;
+        }
+        uint64_t tail = 0;
+        if (i < data.size()) {
+            std::memcpy(&tail, data.data() + i, data.size() - i);
+        }
+        return Mix(hash ^ tail);
+    }
+
+    /**
+     * @brief Hashes the object representation of trivially copyable elements, they must not contain padding.
+     */
+    template <typename T>
+    static uint64_t Bytes(const std::vector<T> &rValues) {
+        return Bytes(std::span<const unsigned char>(reinterpret_cast<const unsigned char *>(rValues.data()),
+                                                    rValues.size() * sizeof(T)));
+    }
+};
@@ -0,0 +1,141 @@
+#include "HeadlessTarget.h"
+
+#include <stdexcept>
+
+HeadlessTarget::HeadlessTarget(DeviceContext &rDeviceContext, VkExtent2D extent, VkFormat format)
+    : rDeviceContext_(rDeviceContext), imageFormat_(format), extent_(extent) {
+    // No surface, device does not need to support presentation
+    rDeviceContext_.CreateDevice(VK_NULL_HANDLE);
+}
+
+HeadlessTarget::~HeadlessTarget() { DestroyResources(); }
+
+void HeadlessTarget::Resize(VkExtent2D extent) {
+    extent_ = extent;
+    outOfDate_ = true;
+}
+
+bool HeadlessTarget::Update() {
+    if (!outOfDate_) {
+        return false;
+    }
+    outOfDate_ = false;
+
+    // Wait until no resources are in use anymore
+    rDeviceContext_.WaitIdle();
+
+    DestroyResources();
+    createImages();
+    createSyncObjects();
+
+    return true;
+}
+
+/**
+ * @brief Destroys images and sync objects.
+ */
+void HeadlessTarget::DestroyResources() {
+    cleanupSyncObjects();
+
+    for (VkImageView imageView : imageViews_) {
+        vkDestroyImageView(rDeviceContext_.GetDevice(), imageView, nullptr);
+    }
+    imageViews_.clear();
+
+    for (VkImage image : images_) {
+        vkDestroyImage(rDeviceContext_.GetDevice(), image, nullptr);
+    }
+    images_.clear();
+
+    for (MemoryAllocator::Allocation &rAllocation : imageAllocations_) {
+        rDeviceContext_.GetMemoryAllocator().Free(rAllocation);
+    }
+    imageAllocations_.clear();
+}
+
+void HeadlessTarget::WaitForNextFrame() {
+    vkWaitForFences(rDeviceContext_.GetDevice(), 1, &inFlightFences_[currentFrame_], VK_TRUE, UINT64_MAX);
+}
+
+HeadlessTarget::AvailableImageInfo HeadlessTarget::AcquireImage() {
+    // Every frame in flight owns its image, so the image is free as soon as the frame fence signaled
+    AvailableImageInfo availableInfo;
+    availableInfo.imageIndex = currentFrame_;
+    availableInfo.frameIndex = currentFrame_;
+    availableInfo.inFlightFence = inFlightFences_[currentFrame_];
+    return availableInfo;
+}
+
+bool HeadlessTarget::Present(const AvailableImageInfo &availableInfo) {
+    // Nothing to present, image stays in GetFinalLayout() for readback
+    currentFrame_ = (currentFrame_ + 1) % MAX_FRAMES_IN_FLIGHT;
+    return true;
+}
+
+void HeadlessTarget::createImages() {
+    images_.resize(MAX_FRAMES_IN_FLIGHT);
+    imageAllocations_.resize(MAX_FRAMES_IN_FLIGHT);
+    imageViews_.resize(MAX_FRAMES_IN_FLIGHT);
+
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = imageFormat_;
+        imageInfo.extent = {extent_.width, extent_.height, 1};
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        if (vkCreateImage(rDeviceContext_.GetDevice(), &imageInfo, nullptr, &images_[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create offscreen image!");
+        }
+
+        imageAllocations_[i] =
+            rDeviceContext_.GetMemoryAllocator().AllocateImageMemory(images_[i], VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        VkImageViewCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        createInfo.image = images_[i];
+        createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        createInfo.format = imageFormat_;
+        createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+        createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+        createInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+        createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+        createInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        createInfo.subresourceRange.baseMipLevel = 0;
+        createInfo.subresourceRange.levelCount = 1;
+        createInfo.subresourceRange.baseArrayLayer = 0;
+        createInfo.subresourceRange.layerCount = 1;
+        if (vkCreateImageView(rDeviceContext_.GetDevice(), &createInfo, nullptr, &imageViews_[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create image views!");
+        }
+    }
+}
+
+void HeadlessTarget::createSyncObjects() {
+    inFlightFences_.resize(MAX_FRAMES_IN_FLIGHT);
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        if (vkCreateFence(rDeviceContext_.GetDevice(), &fenceInfo, nullptr, &inFlightFences_[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create sync objects for a frame!");
+        }
+    }
+    currentFrame_ = 0;
+}
+
+void HeadlessTarget::cleanupSyncObjects() {
+    for (VkFence &fence : inFlightFences_) {
+        vkDestroyFence(rDeviceContext_.GetDevice(), fence, nullptr);
+    }
+    inFlightFences_.clear();
+}
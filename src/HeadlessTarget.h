@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "DeviceContext.h"
+#include "RenderTarget.h"
+
+/**
+ * @brief Offscreen render target without window or surface.
+ * Renders into device local images, one per frame in flight, and picks a device without presentation support.
+ */
+class HeadlessTarget final : public RenderTarget {
+public:
+    HeadlessTarget(DeviceContext &rDeviceContext, VkExtent2D extent, VkFormat format = VK_FORMAT_R8G8B8A8_UNORM);
+    ~HeadlessTarget() override;
+
+    void Resize(VkExtent2D extent);
+
+    bool Update() override;
+
+    void DestroyResources();
+
+    void WaitForNextFrame() override;
+
+    AvailableImageInfo AcquireImage() override;
+
+    bool Present(const AvailableImageInfo &availableInfo) override;
+
+    VkFormat &GetImageFormat() override { return imageFormat_; }
+    VkExtent2D &GetExtent2D() override { return extent_; }
+    std::vector<VkImageView> &GetImageViews() override { return imageViews_; }
+    std::vector<VkImage> &GetImages() { return images_; }
+    uint32_t GetNumberOfImages() const override { return static_cast<uint32_t>(images_.size()); }
+    VkImageLayout GetFinalLayout() const override { return VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL; }
+
+private:
+    void createImages();
+
+    void createSyncObjects();
+
+    void cleanupSyncObjects();
+
+private:
+    DeviceContext &rDeviceContext_;
+    bool outOfDate_ = true;
+    VkFormat imageFormat_ = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent_{};
+    std::vector<VkImage> images_;
+    std::vector<MemoryAllocator::Allocation> imageAllocations_;
+    std::vector<VkImageView> imageViews_;
+
+    // Synchronisation GPU-CPU, there is no acquire / present so fences are enough
+    std::vector<VkFence> inFlightFences_;
+
+    uint32_t currentFrame_ = 0;
+};
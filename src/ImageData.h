@@ -1,8 +1,9 @@
 #pragma once
 
 #include <stdint.h>
+#include <vector>
 
-enum class ImageFormat : uint32_t { r8g8b8_srgb };
+enum class ImageFormat : uint32_t { r8g8b8a8_srgb };
 
 struct ImageData {
     uint32_t width_;
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Per-instance data of instanced draws, read from a second vertex binding that advances once per instance.
+ * The Scene writes one per visible object into the instance buffer of the frame.
+ */
+struct InstanceData {
+    /// Meshes use binding 0
+    static constexpr uint32_t BINDING = 1;
+    /// One location per column of the transform and one for the material, mesh attributes have to use the locations
+    /// below (16 is the minimum limit of vertex attributes)
+    static constexpr uint32_t FIRST_LOCATION = 11;
+    static constexpr uint32_t MATERIAL_LOCATION = FIRST_LOCATION + 4;
+
+    glm::mat4 transform;
+    /// Material::GetBindlessIndex, lets instances of one draw use different materials
+    uint32_t materialIndex = 0;
+    // Keeps the stride a multiple of 16 like the instance array in shaders/cull.comp (std430)
+    uint32_t padding[3] = {};
+
+    static VkVertexInputBindingDescription GetBindingDescription() {
+        VkVertexInputBindingDescription bindingDescription{};
+        bindingDescription.binding = BINDING;
+        bindingDescription.stride = sizeof(InstanceData);
+        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+        return bindingDescription;
+    }
+
+    static std::array<VkVertexInputAttributeDescription, 5> GetAttributeDescriptions() {
+        std::array<VkVertexInputAttributeDescription, 5> attributeDescriptions{};
+        for (uint32_t column = 0; column < 4; column++) {
+            attributeDescriptions[column].binding = BINDING;
+            attributeDescriptions[column].location = FIRST_LOCATION + column;
+            attributeDescriptions[column].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+            attributeDescriptions[column].offset =
+                static_cast<uint32_t>(offsetof(InstanceData, transform) + column * sizeof(glm::vec4));
+        }
+        attributeDescriptions[4].binding = BINDING;
+        attributeDescriptions[4].location = MATERIAL_LOCATION;
+        attributeDescriptions[4].format = VK_FORMAT_R32_UINT;
+        attributeDescriptions[4].offset = static_cast<uint32_t>(offsetof(InstanceData, materialIndex));
+        return attributeDescriptions;
+    }
+};
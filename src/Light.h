@@ -0,0 +1,22 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+/**
+ * @brief Point or spot light fading out at radius, stored like the light arrays of the lighting shaders (std430,
+ * shaders/lights.glsl).
+ */
+struct Light {
+    glm::vec3 position = glm::vec3(0.0f);
+    /// Distance at which the light has no effect anymore
+    float radius = 1.0f;
+    glm::vec3 color = glm::vec3(1.0f);
+    float intensity = 1.0f;
+    /// Spot lights shine along the direction (normalized)
+    glm::vec3 direction = glm::vec3(0.0f, 0.0f, 1.0f);
+    /// Cosine of the half angle of the spot cone, point lights shine everywhere (-1)
+    float spotCosine = -1.0f;
+};
+
+/// Light every surface receives without any light nearby, in both lighting paths
+constexpr float AMBIENT_LIGHT = 0.03f;
@@ -0,0 +1,149 @@
+#include "LightCuller.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "ComputePipeline.h"
+#include "DeviceContext.h"
+#include "RenderContext.h"
+#include "ShaderLibrary.h"
+
+namespace {
+const char *LIGHT_CULL_SHADER_FILE = "shaders/light_cull.comp.spv";
+
+// Cluster in shaders/clusters.glsl, the light count followed by the light indices
+constexpr VkDeviceSize CLUSTER_SIZE = (1 + LightCuller::MAX_LIGHTS_PER_CLUSTER) * sizeof(uint32_t);
+
+glm::vec3 unproject(const glm::mat4 &rInverseViewProjection, float depth) {
+    glm::vec4 world = rInverseViewProjection * glm::vec4(0.0f, 0.0f, depth, 1.0f);
+    return glm::vec3(world) / world.w;
+}
+}  // namespace
+
+LightCuller::LightCuller(DeviceContext &rDeviceContext) : rDeviceContext_(rDeviceContext) {
+    // The registry returns this layout to the lit pipelines as long as it lives
+    spSetLayout_ = rDeviceContext_.GetPipelineRegistry().GetDescriptorSetLayout(GetSetLayoutBindings());
+
+    for (Buffer &rBuffer : clusters_) {
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = CLUSTER_COUNT * CLUSTER_SIZE;
+        bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        if (vkCreateBuffer(rDeviceContext_.GetDevice(), &bufferInfo, nullptr, &rBuffer.buffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create cluster buffer!");
+        }
+        rBuffer.allocation = rDeviceContext_.GetMemoryAllocator().AllocateBufferMemory(
+            rBuffer.buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+}
+
+LightCuller::~LightCuller() {
+    for (Buffer &rBuffer : clusters_) {
+        vkDestroyBuffer(rDeviceContext_.GetDevice(), rBuffer.buffer, nullptr);
+        rDeviceContext_.GetMemoryAllocator().Free(rBuffer.allocation);
+    }
+}
+
+std::vector<VkDescriptorSetLayoutBinding> LightCuller::GetSetLayoutBindings() {
+    // Written by the culling pass, read by the lit fragment shaders
+    std::vector<VkDescriptorSetLayoutBinding> bindings(3);
+    for (uint32_t binding = 0; binding < bindings.size(); binding++) {
+        bindings[binding].binding = binding;
+        bindings[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[binding].descriptorCount = 1;
+        bindings[binding].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+    return bindings;
+}
+
+VkDescriptorSet LightCuller::Update(const RenderContext &rContext, const std::vector<Light> &rLights) {
+    if (!updatePipeline(rContext)) {
+        return VK_NULL_HANDLE;
+    }
+    FrameContext &rFrameContext = rContext.frameContext;
+
+    // Depth slices are measured along the axis through the center of the view
+    ClusteringData clustering{};
+    clustering.inverseViewProjection = glm::inverse(rContext.viewProjection);
+    const glm::vec3 nearPoint = unproject(clustering.inverseViewProjection, 0.0f);
+    const glm::vec3 axis = unproject(clustering.inverseViewProjection, 1.0f) - nearPoint;
+    clustering.nearPoint = glm::vec4(nearPoint, 1.0f);
+    clustering.axis = glm::vec4(axis / glm::dot(axis, axis), 0.0f);
+    clustering.ambient = glm::vec4(glm::vec3(AMBIENT_LIGHT), 0.0f);
+    const VkExtent2D extent = rContext.renderTarget.GetExtent2D();
+    clustering.inverseExtent =
+        glm::vec2(1.0f / static_cast<float>(extent.width), 1.0f / static_cast<float>(extent.height));
+    clustering.lightCount = static_cast<uint32_t>(rLights.size());
+    FrameContext::BufferRange clusteringRange = rFrameContext.AllocateStorageData(sizeof(clustering));
+    std::memcpy(clusteringRange.pData, &clustering, sizeof(clustering));
+
+    // Empty ranges are not allowed, without lights one unused element is bound
+    const VkDeviceSize lightsSize = std::max<size_t>(rLights.size(), 1) * sizeof(Light);
+    FrameContext::BufferRange lightRange = rFrameContext.AllocateStorageData(lightsSize);
+    if (!rLights.empty()) {
+        std::memcpy(lightRange.pData, rLights.data(), rLights.size() * sizeof(Light));
+    }
+
+    VkDescriptorSet descriptorSet = rFrameContext.AllocateDescriptorSet(spSetLayout_->GetHandle());
+    std::array<VkDescriptorBufferInfo, 3> bufferInfos = {{
+        {lightRange.buffer, lightRange.offset, lightsSize},
+        {clusters_[rContext.frameIndex].buffer, 0, VK_WHOLE_SIZE},
+        {clusteringRange.buffer, clusteringRange.offset, sizeof(clustering)},
+    }};
+    std::array<VkWriteDescriptorSet, 3> descriptorWrites{};
+    for (uint32_t binding = 0; binding < descriptorWrites.size(); binding++) {
+        descriptorWrites[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[binding].dstSet = descriptorSet;
+        descriptorWrites[binding].dstBinding = binding;
+        descriptorWrites[binding].descriptorCount = 1;
+        descriptorWrites[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[binding].pBufferInfo = &bufferInfos[binding];
+    }
+    vkUpdateDescriptorSets(rContext.deviceContext.GetDevice(), static_cast<uint32_t>(descriptorWrites.size()),
+                           descriptorWrites.data(), 0, nullptr);
+    return descriptorSet;
+}
+
+void LightCuller::Record(const RenderContext &rContext) {
+    spPipeline_->Bind(rContext.commandBuffer);
+    vkCmdBindDescriptorSets(rContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                            spPipeline_->GetLayout().GetHandle(), 0, 1, &rContext.lightSet, 0, nullptr);
+    vkCmdDispatch(rContext.commandBuffer, (CLUSTER_COUNT + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+    // Lit fragment shaders read the light lists
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(rContext.commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+bool LightCuller::updatePipeline(const RenderContext &rContext) {
+    ShaderLibrary &rShaderLibrary = rContext.deviceContext.GetShaderLibrary();
+    if (spPipeline_ != nullptr && shaderGeneration_ == rShaderLibrary.GetGeneration()) {
+        return true;
+    }
+    std::shared_ptr<const ShaderModule> spShader = rShaderLibrary.GetShaderModule(LIGHT_CULL_SHADER_FILE);
+    if (spShader == nullptr) {
+        return false;
+    }
+    shaderGeneration_ = rShaderLibrary.GetGeneration();
+    if (spPipeline_ != nullptr && &spPipeline_->GetShaderModule() == spShader.get()) {
+        return true;
+    }
+
+    std::shared_ptr<const PipelineLayout> spPipelineLayout =
+        rContext.deviceContext.GetPipelineRegistry().GetPipelineLayout({spSetLayout_}, {});
+
+    if (spPipeline_ != nullptr) {
+        // Frames still in flight may use the previous pipeline
+        rContext.frameContext.Retain(spPipeline_);
+    }
+    spPipeline_ = std::make_shared<ComputePipeline>(rContext.deviceContext, std::move(spShader),
+                                                    std::move(spPipelineLayout));
+    return true;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Light.h"
+#include "MemoryAllocator.h"
+#include "PipelineLayout.h"
+#include "RenderTarget.h"
+
+class ComputePipeline;
+class DeviceContext;
+struct RenderContext;
+
+/**
+ * @brief Clustered lighting: the view frustum is split into a grid of clusters (screen tiles times depth slices), a
+ * compute pass assigns every light to the clusters its bounding sphere touches. The lit shaders (see
+ * shaders/clustered_shading.glsl) only loop over the lights of their fragment's cluster, so thousands of lights cost
+ * about as much per pixel as the few nearby ones, at most MAX_LIGHTS_PER_CLUSTER.
+ * Slices are spaced evenly between the near and the far plane, the view projection needs a finite far plane.
+ */
+class LightCuller final {
+public:
+    /// Grid of shaders/clusters.glsl
+    static constexpr uint32_t CLUSTER_COUNT_X = 16u;
+    static constexpr uint32_t CLUSTER_COUNT_Y = 9u;
+    static constexpr uint32_t CLUSTER_COUNT_Z = 24u;
+    static constexpr uint32_t CLUSTER_COUNT = CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z;
+    /// Further lights touching a cluster are dropped, this bounds the cost per pixel
+    static constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 128u;
+    /// local_size_x of shaders/light_cull.comp
+    static constexpr uint32_t WORKGROUP_SIZE = 64u;
+
+public:
+    explicit LightCuller(DeviceContext &rDeviceContext);
+    ~LightCuller();
+
+    LightCuller(const LightCuller &) = delete;
+    LightCuller &operator=(const LightCuller &) = delete;
+
+    /**
+     * @brief Bindings of the light set: lights, clusters and clustering constants. Lit pipelines put it after their
+     * other sets.
+     */
+    static std::vector<VkDescriptorSetLayoutBinding> GetSetLayoutBindings();
+
+    /**
+     * @brief Copies the lights and clustering constants of the frame and writes the light set, before the materials
+     * update.
+     * @return the light set of the frame, VK_NULL_HANDLE while the culling shader is not loaded
+     */
+    VkDescriptorSet Update(const RenderContext &rContext, const std::vector<Light> &rLights);
+
+    /**
+     * @brief Records the culling dispatch for rContext.lightSet into rContext.commandBuffer, before the render pass
+     * begins.
+     */
+    void Record(const RenderContext &rContext);
+
+private:
+    // Clustering in shaders/clusters.glsl (std430)
+    struct ClusteringData {
+        glm::mat4 inverseViewProjection;
+        glm::vec4 nearPoint;
+        glm::vec4 axis;
+        glm::vec4 ambient;
+        glm::vec2 inverseExtent;
+        uint32_t lightCount;
+        uint32_t padding;
+    };
+
+    struct Buffer {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        MemoryAllocator::Allocation allocation;
+    };
+
+    bool updatePipeline(const RenderContext &rContext);
+
+private:
+    DeviceContext &rDeviceContext_;
+    std::shared_ptr<const DescriptorSetLayout> spSetLayout_;
+    std::shared_ptr<ComputePipeline> spPipeline_;
+    // Shader library generation the shader was looked up at
+    uint64_t shaderGeneration_ = 0;
+    // Light lists per frame in flight, written on the GPU only
+    std::array<Buffer, RenderTarget::MAX_FRAMES_IN_FLIGHT> clusters_;
+};
@@ -0,0 +1,95 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::filesystem::path &rFilePath) {
+    HANDLE file = CreateFileW(rFilePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("failed to open file: " + rFilePath.string() + "!");
+    }
+    fileHandle_ = file;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        throw std::runtime_error("failed to get size of file: " + rFilePath.string() + "!");
+    }
+    size_ = static_cast<size_t>(fileSize.QuadPart);
+    if (size_ == 0) {
+        // Empty files can not be mapped
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        throw std::runtime_error("failed to map file: " + rFilePath.string() + "!");
+    }
+    mappingHandle_ = mapping;
+
+    pData_ = static_cast<const unsigned char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (pData_ == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        throw std::runtime_error("failed to map file: " + rFilePath.string() + "!");
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (pData_ != nullptr) {
+        UnmapViewOfFile(pData_);
+    }
+    if (mappingHandle_ != nullptr) {
+        CloseHandle(mappingHandle_);
+    }
+    CloseHandle(fileHandle_);
+}
+#else
+MappedFile::MappedFile(const std::filesystem::path &rFilePath) {
+    int fd = open(rFilePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("failed to open file: " + rFilePath.string() + "!");
+    }
+
+    struct stat fileStat {};
+    if (fstat(fd, &fileStat) != 0) {
+        close(fd);
+        throw std::runtime_error("failed to get size of file: " + rFilePath.string() + "!");
+    }
+    size_ = static_cast<size_t>(fileStat.st_size);
+    if (size_ == 0) {
+        // Empty files can not be mapped
+        close(fd);
+        return;
+    }
+
+    void *pMapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    // Mapping keeps its own reference to the file
+    close(fd);
+    if (pMapped == MAP_FAILED) {
+        throw std::runtime_error("failed to map file: " + rFilePath.string() + "!");
+    }
+    // Data is read front to back once (hashing, uploading)
+    madvise(pMapped, size_, MADV_SEQUENTIAL);
+    pData_ = static_cast<const unsigned char *>(pMapped);
+}
+
+MappedFile::~MappedFile() {
+    if (pData_ != nullptr) {
+        munmap(const_cast<unsigned char *>(pData_), size_);
+    }
+}
+#endif
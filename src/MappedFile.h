@@ -0,0 +1,26 @@
+#pragma once
+
+#include <filesystem>
+#include <span>
+
+/**
+ * @brief Read-only memory mapping of a whole file, pages are loaded by the OS on first access.
+ */
+class MappedFile final {
+public:
+    explicit MappedFile(const std::filesystem::path &rFilePath);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    std::span<const unsigned char> GetData() const { return {pData_, size_}; }
+
+private:
+    const unsigned char *pData_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void *fileHandle_ = nullptr;
+    void *mappingHandle_ = nullptr;
+#endif
+};
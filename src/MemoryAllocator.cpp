@@ -0,0 +1,353 @@
+#include "MemoryAllocator.h"
+
+#include <algorithm>
+#include <bit>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+
+namespace {
+// Smallest node handed out by the buddy allocator
+const VkDeviceSize MIN_NODE_SIZE = 256;
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+VkDeviceSize alignDown(VkDeviceSize value, VkDeviceSize alignment) { return value / alignment * alignment; }
+
+uint32_t orderOf(VkDeviceSize nodeSize) { return static_cast<uint32_t>(std::countr_zero(nodeSize / MIN_NODE_SIZE)); }
+
+VkDeviceSize nodeSizeOf(uint32_t order) { return MIN_NODE_SIZE << order; }
+}  // namespace
+
+struct MemoryAllocator::Block {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize size = 0;
+    void *pMapped = nullptr;
+    uint32_t memoryType = 0;
+    bool linear = true;
+    bool dedicated = false;
+    uint32_t allocationCount = 0;
+    VkDeviceSize usedBytes = 0;
+
+    // Buddy allocator state: free node offsets per order (order 0 = MIN_NODE_SIZE) and order of live allocations
+    std::vector<std::set<VkDeviceSize>> freeNodes;
+    std::unordered_map<VkDeviceSize, uint32_t> allocatedOrders;
+
+    bool Allocate(VkDeviceSize nodeSize, VkDeviceSize &rOffset) {
+        uint32_t order = orderOf(nodeSize);
+        if (order >= freeNodes.size()) {
+            return false;
+        }
+
+        // Find smallest free node that fits
+        uint32_t current = order;
+        while (current < freeNodes.size() && freeNodes[current].empty()) {
+            current++;
+        }
+        if (current == freeNodes.size()) {
+            return false;
+        }
+
+        VkDeviceSize offset = *freeNodes[current].begin();
+        freeNodes[current].erase(freeNodes[current].begin());
+
+        // Split down to requested order, upper halves become free buddies
+        while (current > order) {
+            current--;
+            freeNodes[current].insert(offset + nodeSizeOf(current));
+        }
+
+        allocatedOrders[offset] = order;
+        allocationCount++;
+        usedBytes += nodeSize;
+        rOffset = offset;
+        return true;
+    }
+
+    void Free(VkDeviceSize offset) {
+        auto it = allocatedOrders.find(offset);
+        if (it == allocatedOrders.end()) {
+            throw std::runtime_error("memory allocator: freeing unknown allocation!");
+        }
+        uint32_t order = it->second;
+        allocatedOrders.erase(it);
+        allocationCount--;
+        usedBytes -= nodeSizeOf(order);
+
+        // Merge with free buddies as far as possible
+        while (order + 1 < freeNodes.size()) {
+            VkDeviceSize buddy = offset ^ nodeSizeOf(order);
+            auto buddyIt = freeNodes[order].find(buddy);
+            if (buddyIt == freeNodes[order].end()) {
+                break;
+            }
+            freeNodes[order].erase(buddyIt);
+            offset = std::min(offset, buddy);
+            order++;
+        }
+        freeNodes[order].insert(offset);
+    }
+};
+
+MemoryAllocator::MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize blockSize)
+    : device_(device), blockSize_(std::bit_floor(std::max(blockSize, MIN_NODE_SIZE))) {
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties_);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    bufferImageGranularity_ = std::max<VkDeviceSize>(properties.limits.bufferImageGranularity, 1);
+    nonCoherentAtomSize_ = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+}
+
+MemoryAllocator::~MemoryAllocator() {
+    uint32_t leaked = 0;
+    for (uint32_t i = 0; i < blocks_.size(); i++) {
+        if (blocks_[i] != nullptr) {
+            leaked += blocks_[i]->allocationCount;
+            destroyBlock(i);
+        }
+    }
+    if (leaked > 0) {
+        std::cerr << "memory allocator: " << leaked << " allocations were not freed" << std::endl;
+    }
+}
+
+uint32_t MemoryAllocator::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
+    uint64_t key = (static_cast<uint64_t>(typeFilter) << 32) | properties;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = memoryTypeCache_.find(key);
+    if (it != memoryTypeCache_.end()) {
+        return it->second;
+    }
+
+    for (uint32_t i = 0; i < memoryProperties_.memoryTypeCount; i++) {
+        if ((typeFilter & (1 << i)) && (memoryProperties_.memoryTypes[i].propertyFlags & properties) == properties) {
+            memoryTypeCache_[key] = i;
+            return i;
+        }
+    }
+    throw std::runtime_error("failed to find suitable memory type!");
+}
+
+MemoryAllocator::Allocation MemoryAllocator::AllocateBufferMemory(VkBuffer buffer, VkMemoryPropertyFlags properties) {
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
+
+    Allocation allocation = allocate(memRequirements, properties, true);
+    if (vkBindBufferMemory(device_, buffer, allocation.memory, allocation.offset) != VK_SUCCESS) {
+        Free(allocation);
+        throw std::runtime_error("failed to bind buffer memory!");
+    }
+    return allocation;
+}
+
+MemoryAllocator::Allocation MemoryAllocator::AllocateImageMemory(VkImage image, VkMemoryPropertyFlags properties) {
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device_, image, &memRequirements);
+
+    Allocation allocation = allocate(memRequirements, properties, false);
+    if (vkBindImageMemory(device_, image, allocation.memory, allocation.offset) != VK_SUCCESS) {
+        Free(allocation);
+        throw std::runtime_error("failed to bind image memory!");
+    }
+    return allocation;
+}
+
+void MemoryAllocator::Free(Allocation &rAllocation) {
+    if (!rAllocation.IsValid()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Block &rBlock = *blocks_[rAllocation.blockIndex];
+    if (rBlock.dedicated) {
+        destroyBlock(rAllocation.blockIndex);
+    } else {
+        rBlock.Free(rAllocation.offset);
+
+        if (rBlock.allocationCount == 0) {
+            // Keep one empty block per memory type around to avoid allocation churn
+            bool hasOtherBlock = std::any_of(blocks_.begin(), blocks_.end(), [&rBlock](const auto &rspOther) {
+                return rspOther != nullptr && rspOther.get() != &rBlock && !rspOther->dedicated &&
+                       rspOther->memoryType == rBlock.memoryType && rspOther->linear == rBlock.linear;
+            });
+            if (hasOtherBlock) {
+                destroyBlock(rAllocation.blockIndex);
+            }
+        }
+    }
+    rAllocation = Allocation{};
+}
+
+void MemoryAllocator::Flush(const Allocation &rAllocation, VkDeviceSize offset, VkDeviceSize size) {
+    VkMemoryPropertyFlags flags = memoryProperties_.memoryTypes[rAllocation.memoryType].propertyFlags;
+    if ((flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) || rAllocation.pMapped == nullptr) {
+        return;
+    }
+    if (size == VK_WHOLE_SIZE) {
+        size = rAllocation.size - offset;
+    }
+
+    VkDeviceSize blockSize;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        blockSize = blocks_[rAllocation.blockIndex]->size;
+    }
+
+    // Range has to be aligned to nonCoherentAtomSize (or reach the end of the memory object)
+    VkDeviceSize begin = alignDown(rAllocation.offset + offset, nonCoherentAtomSize_);
+    VkDeviceSize end = std::min(alignUp(rAllocation.offset + offset + size, nonCoherentAtomSize_), blockSize);
+
+    VkMappedMemoryRange range{};
+    range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range.memory = rAllocation.memory;
+    range.offset = begin;
+    range.size = end - begin;
+    vkFlushMappedMemoryRanges(device_, 1, &range);
+}
+
+std::vector<MemoryAllocator::HeapStatistics> MemoryAllocator::GetHeapStatistics() const {
+    std::vector<HeapStatistics> statistics(memoryProperties_.memoryHeapCount);
+    for (uint32_t i = 0; i < memoryProperties_.memoryHeapCount; i++) {
+        statistics[i].heapSize = memoryProperties_.memoryHeaps[i].size;
+        statistics[i].flags = memoryProperties_.memoryHeaps[i].flags;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &rspBlock : blocks_) {
+        if (rspBlock == nullptr) {
+            continue;
+        }
+        HeapStatistics &rHeap = statistics[memoryProperties_.memoryTypes[rspBlock->memoryType].heapIndex];
+        rHeap.blockCount++;
+        rHeap.allocationCount += rspBlock->allocationCount;
+        rHeap.blockBytes += rspBlock->size;
+        rHeap.usedBytes += rspBlock->usedBytes;
+    }
+    return statistics;
+}
+
+void MemoryAllocator::PrintStatistics(std::ostream &rStream) const {
+    const double mib = 1024.0 * 1024.0;
+    std::vector<HeapStatistics> statistics = GetHeapStatistics();
+    for (size_t i = 0; i < statistics.size(); i++) {
+        const HeapStatistics &rHeap = statistics[i];
+        rStream << "Heap " << i << ((rHeap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? " (device local)" : "")
+                << ": " << rHeap.usedBytes / mib << " / " << rHeap.blockBytes / mib << " MiB used in "
+                << rHeap.allocationCount << " allocations, " << rHeap.blockCount << " blocks, heap size "
+                << rHeap.heapSize / mib << " MiB" << std::endl;
+    }
+}
+
+MemoryAllocator::Allocation MemoryAllocator::allocate(const VkMemoryRequirements &rRequirements,
+                                                      VkMemoryPropertyFlags properties, bool linear) {
+    uint32_t memoryType = FindMemoryType(rRequirements.memoryTypeBits, properties);
+
+    if (bufferImageGranularity_ <= 1) {
+        // Buffers and images may share pages, no need to separate them
+        linear = true;
+    }
+
+    // Buddy nodes are aligned to their size
+    VkDeviceSize nodeSize = std::bit_ceil(std::max({rRequirements.size, rRequirements.alignment, MIN_NODE_SIZE}));
+
+    // Do not let one block take more than an eighth of a small heap
+    VkDeviceSize heapSize = memoryProperties_.memoryHeaps[memoryProperties_.memoryTypes[memoryType].heapIndex].size;
+    VkDeviceSize blockSize = std::max(std::min(blockSize_, std::bit_floor(heapSize / 8)), MIN_NODE_SIZE);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Allocation allocation;
+    allocation.memoryType = memoryType;
+
+    if (nodeSize > blockSize / 2) {
+        // Large resources get their own memory object
+        allocation.blockIndex = createBlock(memoryType, rRequirements.size, linear, true);
+        Block &rBlock = *blocks_[allocation.blockIndex];
+        rBlock.allocationCount = 1;
+        rBlock.usedBytes = rRequirements.size;
+
+        allocation.memory = rBlock.memory;
+        allocation.offset = 0;
+        allocation.size = rRequirements.size;
+        allocation.pMapped = rBlock.pMapped;
+        return allocation;
+    }
+
+    VkDeviceSize offset = 0;
+    uint32_t blockIndex = 0;
+    bool found = false;
+    for (; blockIndex < blocks_.size(); blockIndex++) {
+        Block *pBlock = blocks_[blockIndex].get();
+        if (pBlock != nullptr && !pBlock->dedicated && pBlock->memoryType == memoryType && pBlock->linear == linear &&
+            pBlock->Allocate(nodeSize, offset)) {
+            found = true;
+            break;
+        }
+    }
+
+    if (!found) {
+        blockIndex = createBlock(memoryType, blockSize, linear, false);
+        if (!blocks_[blockIndex]->Allocate(nodeSize, offset)) {
+            throw std::runtime_error("memory allocator: allocation does not fit into new block!");
+        }
+    }
+
+    Block &rBlock = *blocks_[blockIndex];
+    allocation.memory = rBlock.memory;
+    allocation.offset = offset;
+    allocation.size = rRequirements.size;
+    allocation.pMapped = (rBlock.pMapped != nullptr) ? static_cast<char *>(rBlock.pMapped) + offset : nullptr;
+    allocation.blockIndex = blockIndex;
+    return allocation;
+}
+
+uint32_t MemoryAllocator::createBlock(uint32_t memoryType, VkDeviceSize size, bool linear, bool dedicated) {
+    auto spBlock = std::make_unique<Block>();
+    spBlock->size = size;
+    spBlock->memoryType = memoryType;
+    spBlock->linear = linear;
+    spBlock->dedicated = dedicated;
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryType;
+
+    if (vkAllocateMemory(device_, &allocInfo, nullptr, &spBlock->memory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate device memory block!");
+    }
+
+    if (memoryProperties_.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        // Host visible blocks stay mapped for their whole lifetime
+        if (vkMapMemory(device_, spBlock->memory, 0, VK_WHOLE_SIZE, 0, &spBlock->pMapped) != VK_SUCCESS) {
+            vkFreeMemory(device_, spBlock->memory, nullptr);
+            throw std::runtime_error("failed to map device memory block!");
+        }
+    }
+
+    if (!dedicated) {
+        spBlock->freeNodes.resize(orderOf(size) + 1);
+        spBlock->freeNodes.back().insert(0);
+    }
+
+    if (!freeBlockSlots_.empty()) {
+        uint32_t index = freeBlockSlots_.back();
+        freeBlockSlots_.pop_back();
+        blocks_[index] = std::move(spBlock);
+        return index;
+    }
+    blocks_.push_back(std::move(spBlock));
+    return static_cast<uint32_t>(blocks_.size() - 1);
+}
+
+void MemoryAllocator::destroyBlock(uint32_t blockIndex) {
+    Block &rBlock = *blocks_[blockIndex];
+    if (rBlock.pMapped != nullptr) {
+        vkUnmapMemory(device_, rBlock.memory);
+    }
+    vkFreeMemory(device_, rBlock.memory, nullptr);
+    blocks_[blockIndex].reset();
+    freeBlockSlots_.push_back(blockIndex);
+}
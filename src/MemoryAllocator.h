@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Sub-allocates device memory out of large blocks per memory type.
+ * Blocks are split with a buddy allocator, so every allocation is aligned to its (power of two) size. Linear
+ * resources (buffers) and optimal tiled images are placed in separate blocks to respect bufferImageGranularity.
+ * Allocations larger than half a block get their own dedicated vkAllocateMemory.
+ */
+class MemoryAllocator final {
+public:
+    struct Allocation {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        // Persistently mapped pointer to the start of the allocation (host visible memory only)
+        void *pMapped = nullptr;
+        uint32_t memoryType = 0;
+        uint32_t blockIndex = 0;
+
+        bool IsValid() const { return memory != VK_NULL_HANDLE; }
+    };
+
+    struct HeapStatistics {
+        VkDeviceSize heapSize = 0;
+        VkMemoryHeapFlags flags = 0;
+        uint32_t blockCount = 0;
+        uint32_t allocationCount = 0;
+        // Memory allocated from the driver
+        VkDeviceSize blockBytes = 0;
+        // Memory handed out to resources (including padding to power of two)
+        VkDeviceSize usedBytes = 0;
+    };
+
+    static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+public:
+    MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE);
+    ~MemoryAllocator();
+
+    MemoryAllocator(const MemoryAllocator &) = delete;
+    MemoryAllocator &operator=(const MemoryAllocator &) = delete;
+
+    /**
+     * @brief Returns first memory type matching filter and properties. Memory properties are queried once.
+     */
+    uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+
+    /**
+     * @brief Allocates memory for the buffer and binds it.
+     */
+    Allocation AllocateBufferMemory(VkBuffer buffer, VkMemoryPropertyFlags properties);
+
+    /**
+     * @brief Allocates memory for an optimal tiled image and binds it.
+     */
+    Allocation AllocateImageMemory(VkImage image, VkMemoryPropertyFlags properties);
+
+    void Free(Allocation &rAllocation);
+
+    /**
+     * @brief Flushes a range of a non-coherent mapped allocation (no-op for coherent memory).
+     */
+    void Flush(const Allocation &rAllocation, VkDeviceSize offset, VkDeviceSize size);
+
+    const VkPhysicalDeviceMemoryProperties &GetMemoryProperties() const { return memoryProperties_; }
+
+    std::vector<HeapStatistics> GetHeapStatistics() const;
+    void PrintStatistics(std::ostream &rStream) const;
+
+private:
+    struct Block;
+
+    Allocation allocate(const VkMemoryRequirements &rRequirements, VkMemoryPropertyFlags properties, bool linear);
+    uint32_t createBlock(uint32_t memoryType, VkDeviceSize size, bool linear, bool dedicated);
+    void destroyBlock(uint32_t blockIndex);
+
+private:
+    VkDevice device_;
+    VkPhysicalDeviceMemoryProperties memoryProperties_{};
+    VkDeviceSize bufferImageGranularity_ = 1;
+    VkDeviceSize nonCoherentAtomSize_ = 1;
+    VkDeviceSize blockSize_;
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Block>> blocks_;
+    std::vector<uint32_t> freeBlockSlots_;
+    std::unordered_map<uint64_t, uint32_t> memoryTypeCache_;
+};
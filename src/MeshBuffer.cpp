@@ -0,0 +1,43 @@
+#include "MeshBuffer.h"
+
+#include <stdexcept>
+
+#include "DeviceContext.h"
+
+MeshBuffer::MeshBuffer(DeviceContext &rDeviceContext, VkDeviceSize vertexBufferSize, VkDeviceSize indexBufferSize)
+    : rDeviceContext_(rDeviceContext) {
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = vertexBufferSize;
+    bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(rDeviceContext_.GetDevice(), &bufferInfo, nullptr, &vertexBuffer_) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create vertex buffer!");
+    }
+    vertexAllocation_ =
+        rDeviceContext_.GetMemoryAllocator().AllocateBufferMemory(vertexBuffer_, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    if (indexBufferSize > 0) {
+        bufferInfo.size = indexBufferSize;
+        bufferInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+        if (vkCreateBuffer(rDeviceContext_.GetDevice(), &bufferInfo, nullptr, &indexBuffer_) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create index buffer!");
+        }
+        indexAllocation_ =
+            rDeviceContext_.GetMemoryAllocator().AllocateBufferMemory(indexBuffer_, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+}
+
+MeshBuffer::~MeshBuffer() {
+    vkDestroyBuffer(rDeviceContext_.GetDevice(), vertexBuffer_, nullptr);
+    rDeviceContext_.GetMemoryAllocator().Free(vertexAllocation_);
+
+    if (indexBuffer_ != VK_NULL_HANDLE) {
+        vkDestroyBuffer(rDeviceContext_.GetDevice(), indexBuffer_, nullptr);
+        rDeviceContext_.GetMemoryAllocator().Free(indexAllocation_);
+    }
+}
+
+bool MeshBuffer::IsReady() const { return rDeviceContext_.GetUploadManager().IsComplete(uploadTicket_); }
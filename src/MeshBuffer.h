@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <cstdint>
+
+#include "MemoryAllocator.h"
+#include "UploadManager.h"
+
+class DeviceContext;
+
+/**
+ * @brief Device local vertex and optional index data of a mesh, filled through the UploadManager.
+ */
+class MeshBuffer final {
+public:
+    MeshBuffer(DeviceContext &rDeviceContext, VkDeviceSize vertexBufferSize, VkDeviceSize indexBufferSize = 0);
+    ~MeshBuffer();
+
+    MeshBuffer(const MeshBuffer &) = delete;
+    MeshBuffer &operator=(const MeshBuffer &) = delete;
+
+    /**
+     * @brief Data can only be used for drawing once the upload finished.
+     */
+    bool IsReady() const;
+
+    /// Unique per buffer, used to sort draws
+    uint32_t GetId() const { return id_; }
+
+    VkBuffer GetVertexBuffer() const { return vertexBuffer_; }
+    uint32_t GetVertexCount() const { return vertexCount_; }
+
+    bool IsIndexed() const { return indexBuffer_ != VK_NULL_HANDLE; }
+    VkBuffer GetIndexBuffer() const { return indexBuffer_; }
+    VkIndexType GetIndexType() const { return indexType_; }
+    uint32_t GetIndexCount() const { return indexCount_; }
+
+private:
+    friend class ResourceManager;
+
+    static inline std::atomic<uint32_t> nextId_ = 0;
+
+    DeviceContext &rDeviceContext_;
+    uint32_t id_ = nextId_++;
+    VkBuffer vertexBuffer_ = VK_NULL_HANDLE;
+    MemoryAllocator::Allocation vertexAllocation_;
+    uint32_t vertexCount_ = 0;
+    VkBuffer indexBuffer_ = VK_NULL_HANDLE;
+    MemoryAllocator::Allocation indexAllocation_;
+    VkIndexType indexType_ = VK_INDEX_TYPE_UINT32;
+    uint32_t indexCount_ = 0;
+    UploadManager::Ticket uploadTicket_ = 0;
+};
@@ -0,0 +1,157 @@
+#include "MeshCache.h"
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "Hash.h"
+#include "MappedFile.h"
+#include "VertexData.h"
+
+namespace {
+const std::array<char, 4> MAGIC = {'M', 'E', 'S', 'H'};
+
+// Blobs start at this alignment, so they can be read in place as index or float data
+const uint64_t BLOB_ALIGNMENT = 16;
+
+struct FileHeader {
+    std::array<char, 4> magic;
+    uint32_t version;
+    uint64_t sourceHash;
+    uint32_t binding;
+    uint32_t stride;
+    uint32_t inputRate;
+    uint32_t attributeCount;
+    uint32_t indexType;
+    uint32_t reserved;
+    uint64_t vertexOffset;
+    uint64_t vertexSize;
+    uint64_t indexOffset;
+    uint64_t indexSize;
+};
+
+struct FileAttribute {
+    uint32_t location;
+    uint32_t binding;
+    uint32_t format;
+    uint32_t offset;
+};
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+bool isInRange(uint64_t offset, uint64_t size, uint64_t fileSize) {
+    return offset <= fileSize && size <= fileSize - offset;
+}
+}  // namespace
+
+MeshCache::MeshCache(std::filesystem::path cacheDirectory) : cacheDirectory_(std::move(cacheDirectory)) {}
+
+std::shared_ptr<VertexData> MeshCache::Load(uint64_t sourceHash) const {
+    std::filesystem::path cachePath = getCachePath(sourceHash);
+    std::error_code error;
+    if (!std::filesystem::exists(cachePath, error)) {
+        return nullptr;
+    }
+
+    auto spMappedFile = std::make_shared<MappedFile>(cachePath);
+    std::span<const unsigned char> data = spMappedFile->GetData();
+
+    FileHeader header;
+    if (data.size() < sizeof(header)) {
+        return nullptr;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    // Stale or foreign files are ignored and get overwritten
+    uint64_t attributesSize = static_cast<uint64_t>(header.attributeCount) * sizeof(FileAttribute);
+    if (header.magic != MAGIC || header.version != VERSION || header.sourceHash != sourceHash ||
+        !isInRange(sizeof(header), attributesSize, data.size()) ||
+        !isInRange(header.vertexOffset, header.vertexSize, data.size()) ||
+        !isInRange(header.indexOffset, header.indexSize, data.size())) {
+        return nullptr;
+    }
+
+    auto spVertexData = std::make_shared<VertexData>();
+    spVertexData->inputBindingDescription.binding = header.binding;
+    spVertexData->inputBindingDescription.stride = header.stride;
+    spVertexData->inputBindingDescription.inputRate = static_cast<VkVertexInputRate>(header.inputRate);
+
+    for (uint32_t i = 0; i < header.attributeCount; i++) {
+        FileAttribute fileAttribute;
+        std::memcpy(&fileAttribute, data.data() + sizeof(header) + i * sizeof(FileAttribute), sizeof(fileAttribute));
+
+        VkVertexInputAttributeDescription &rAttribute = spVertexData->attributeDescriptions.emplace_back();
+        rAttribute.location = fileAttribute.location;
+        rAttribute.binding = fileAttribute.binding;
+        rAttribute.format = static_cast<VkFormat>(fileAttribute.format);
+        rAttribute.offset = fileAttribute.offset;
+    }
+
+    // Vertex and index data stay in the mapping, the file is kept open as long as the vertex data is alive
+    spVertexData->indexType = static_cast<VkIndexType>(header.indexType);
+    spVertexData->mappedVertexBuffer = data.subspan(header.vertexOffset, header.vertexSize);
+    spVertexData->mappedIndexBuffer = data.subspan(header.indexOffset, header.indexSize);
+    spVertexData->spMappedFile = std::move(spMappedFile);
+    return spVertexData;
+}
+
+void MeshCache::Store(uint64_t sourceHash, const VertexData &rVertexData) const {
+    std::span<const unsigned char> vertexBuffer = rVertexData.GetVertexBuffer();
+    std::span<const unsigned char> indexBuffer = rVertexData.GetIndexBuffer();
+
+    FileHeader header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.sourceHash = sourceHash;
+    header.binding = rVertexData.inputBindingDescription.binding;
+    header.stride = rVertexData.inputBindingDescription.stride;
+    header.inputRate = static_cast<uint32_t>(rVertexData.inputBindingDescription.inputRate);
+    header.attributeCount = static_cast<uint32_t>(rVertexData.attributeDescriptions.size());
+    header.indexType = static_cast<uint32_t>(rVertexData.indexType);
+    header.vertexOffset = alignUp(sizeof(header) + header.attributeCount * sizeof(FileAttribute), BLOB_ALIGNMENT);
+    header.vertexSize = vertexBuffer.size();
+    header.indexOffset = alignUp(header.vertexOffset + header.vertexSize, BLOB_ALIGNMENT);
+    header.indexSize = indexBuffer.size();
+
+    std::vector<char> file(header.indexOffset + header.indexSize, 0);
+    std::memcpy(file.data(), &header, sizeof(header));
+    for (uint32_t i = 0; i < header.attributeCount; i++) {
+        const VkVertexInputAttributeDescription &rAttribute = rVertexData.attributeDescriptions[i];
+        FileAttribute fileAttribute{rAttribute.location, rAttribute.binding, static_cast<uint32_t>(rAttribute.format),
+                                    rAttribute.offset};
+        std::memcpy(file.data() + sizeof(header) + i * sizeof(FileAttribute), &fileAttribute, sizeof(fileAttribute));
+    }
+    std::memcpy(file.data() + header.vertexOffset, vertexBuffer.data(), vertexBuffer.size());
+    std::memcpy(file.data() + header.indexOffset, indexBuffer.data(), indexBuffer.size());
+
+    std::filesystem::create_directories(cacheDirectory_);
+
+    // Write to a temporary file first, so a crash never leaves a truncated cache file behind.
+    // Name is unique per thread, as the same mesh may be loaded concurrently.
+    std::filesystem::path cachePath = getCachePath(sourceHash);
+    std::filesystem::path tempPath = cachePath;
+    tempPath += "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+    {
+        std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+        if (!stream.write(file.data(), static_cast<std::streamsize>(file.size()))) {
+            throw std::runtime_error("failed to write mesh cache file: " + tempPath.string() + "!");
+        }
+    }
+    std::filesystem::rename(tempPath, cachePath);
+}
+
+uint64_t MeshCache::HashFile(const std::filesystem::path &rFilePath) {
+    MappedFile file(rFilePath);
+    return Hash::Bytes(file.GetData());
+}
+
+std::filesystem::path MeshCache::getCachePath(uint64_t sourceHash) const {
+    std::ostringstream fileName;
+    fileName << std::hex << std::setw(16) << std::setfill('0') << sourceHash << ".mesh";
+    return cacheDirectory_ / fileName.str();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+struct VertexData;
+
+/**
+ * @brief Binary mesh files holding preprocessed vertex and index data, keyed by the content hash of their source.
+ * Cached meshes are memory mapped, so their data can be uploaded without parsing or intermediate copies.
+ */
+class MeshCache final {
+public:
+    /// Increment whenever the file layout or the mesh preprocessing changes
+    static constexpr uint32_t VERSION = 1u;
+
+public:
+    explicit MeshCache(std::filesystem::path cacheDirectory);
+
+    /**
+     * @brief Returns cached mesh data for the source content hash, or nullptr if there is no valid cache file.
+     */
+    std::shared_ptr<VertexData> Load(uint64_t sourceHash) const;
+
+    /**
+     * @brief Writes mesh data created from the source with this content hash into the cache.
+     */
+    void Store(uint64_t sourceHash, const VertexData &rVertexData) const;
+
+    static uint64_t HashFile(const std::filesystem::path &rFilePath);
+
+private:
+    std::filesystem::path getCachePath(uint64_t sourceHash) const;
+
+private:
+    std::filesystem::path cacheDirectory_;
+};
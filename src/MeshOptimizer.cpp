@@ -0,0 +1,194 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+// Scoring constants from Tom Forsyth, "Linear-Speed Vertex Cache Optimisation"
+const float CACHE_DECAY_POWER = 1.5f;
+const float LAST_TRIANGLE_SCORE = 0.75f;
+const float VALENCE_BOOST_SCALE = 2.0f;
+const float VALENCE_BOOST_POWER = 0.5f;
+
+float vertexScore(int32_t cachePosition, uint32_t remainingTriangles) {
+    if (remainingTriangles == 0) {
+        // No triangle needs this vertex anymore
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            // Vertices of the last triangle get a fixed score, so the next triangle does not depend on their order
+            score = LAST_TRIANGLE_SCORE;
+        } else {
+            const float scaler = 1.0f / (MeshOptimizer::CACHE_SIZE - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+        }
+    }
+
+    // Prefer vertices with few remaining triangles, so they are finished and do not get lonely
+    score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+    return score;
+}
+}  // namespace
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t> &rIndices, uint32_t vertexCount) {
+    const size_t triangleCount = rIndices.size() / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // Vertex to triangle adjacency, the first remainingTriangles entries of a vertex are not yet emitted
+    std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+    for (uint32_t index : rIndices) {
+        remainingTriangles[index]++;
+    }
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remainingTriangles[v];
+    }
+    std::vector<uint32_t> adjacency(rIndices.size());
+    {
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < rIndices.size(); i++) {
+            adjacency[fill[rIndices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+
+    std::vector<int32_t> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        vertexScores[v] = vertexScore(-1, remainingTriangles[v]);
+    }
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    size_t bestTriangle = 0;
+    for (size_t t = 0; t < triangleCount; t++) {
+        triangleScores[t] =
+            vertexScores[rIndices[t * 3]] + vertexScores[rIndices[t * 3 + 1]] + vertexScores[rIndices[t * 3 + 2]];
+        if (triangleScores[t] > triangleScores[bestTriangle]) {
+            bestTriangle = t;
+        }
+    }
+
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> newCache;
+    cache.reserve(CACHE_SIZE + 3);
+    newCache.reserve(CACHE_SIZE + 3);
+
+    std::vector<uint32_t> output;
+    output.reserve(rIndices.size());
+
+    const size_t noTriangle = std::numeric_limits<size_t>::max();
+    size_t deadEndCursor = 0;
+
+    for (size_t i = 0; i < triangleCount; i++) {
+        if (bestTriangle == noTriangle) {
+            // No triangle touches the cache, continue with the next one in input order
+            while (emitted[deadEndCursor]) {
+                deadEndCursor++;
+            }
+            bestTriangle = deadEndCursor;
+        }
+
+        const uint32_t *pTriangle = &rIndices[bestTriangle * 3];
+        output.insert(output.end(), pTriangle, pTriangle + 3);
+        emitted[bestTriangle] = true;
+
+        newCache.clear();
+        for (uint32_t k = 0; k < 3; k++) {
+            uint32_t v = pTriangle[k];
+
+            // Remove triangle from remaining adjacency of its vertex
+            uint32_t *pBegin = &adjacency[adjacencyOffsets[v]];
+            uint32_t *pEnd = pBegin + remainingTriangles[v];
+            uint32_t *pFound = std::find(pBegin, pEnd, static_cast<uint32_t>(bestTriangle));
+            std::swap(*pFound, *(pEnd - 1));
+            remainingTriangles[v]--;
+
+            if (std::find(newCache.begin(), newCache.end(), v) == newCache.end()) {
+                newCache.push_back(v);
+            }
+        }
+        // Simulated LRU cache, the vertices of the emitted triangle move to the front
+        for (uint32_t v : cache) {
+            if (v != pTriangle[0] && v != pTriangle[1] && v != pTriangle[2]) {
+                newCache.push_back(v);
+            }
+        }
+
+        // Update scores of vertices that are in the cache or just dropped out of it
+        for (size_t c = 0; c < newCache.size(); c++) {
+            uint32_t v = newCache[c];
+            cachePositions[v] = c < CACHE_SIZE ? static_cast<int32_t>(c) : -1;
+            vertexScores[v] = vertexScore(cachePositions[v], remainingTriangles[v]);
+        }
+
+        // Only triangles of these vertices changed their score, pick the best of them
+        bestTriangle = noTriangle;
+        float bestScore = -std::numeric_limits<float>::max();
+        for (uint32_t v : newCache) {
+            for (uint32_t a = 0; a < remainingTriangles[v]; a++) {
+                uint32_t t = adjacency[adjacencyOffsets[v] + a];
+                const uint32_t *pIndices = &rIndices[static_cast<size_t>(t) * 3];
+                triangleScores[t] = vertexScores[pIndices[0]] + vertexScores[pIndices[1]] + vertexScores[pIndices[2]];
+                if (triangleScores[t] > bestScore) {
+                    bestScore = triangleScores[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        newCache.resize(std::min<size_t>(newCache.size(), CACHE_SIZE));
+        std::swap(cache, newCache);
+    }
+
+    rIndices = std::move(output);
+}
+
+uint32_t MeshOptimizer::OptimizeVertexFetch(std::vector<uint32_t> &rIndices, std::vector<unsigned char> &rVertexBuffer,
+                                            uint32_t vertexSize) {
+    const size_t vertexCount = rVertexBuffer.size() / vertexSize;
+    const uint32_t unused = std::numeric_limits<uint32_t>::max();
+
+    std::vector<uint32_t> remap(vertexCount, unused);
+    std::vector<unsigned char> vertexBuffer(rVertexBuffer.size());
+    uint32_t nextVertex = 0;
+
+    for (uint32_t &rIndex : rIndices) {
+        if (remap[rIndex] == unused) {
+            remap[rIndex] = nextVertex;
+            std::memcpy(&vertexBuffer[static_cast<size_t>(nextVertex) * vertexSize],
+                        &rVertexBuffer[static_cast<size_t>(rIndex) * vertexSize], vertexSize);
+            nextVertex++;
+        }
+        rIndex = remap[rIndex];
+    }
+
+    vertexBuffer.resize(static_cast<size_t>(nextVertex) * vertexSize);
+    rVertexBuffer = std::move(vertexBuffer);
+    return nextVertex;
+}
+
+float MeshOptimizer::CalculateACMR(const std::vector<uint32_t> &rIndices, uint32_t vertexCount, uint32_t cacheSize) {
+    const size_t triangleCount = rIndices.size() / 3;
+    if (triangleCount == 0) {
+        return 0.0f;
+    }
+
+    // A vertex is in a FIFO cache if less than cacheSize misses happened since it was inserted
+    std::vector<uint32_t> insertTimes(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+    size_t misses = 0;
+    for (uint32_t index : rIndices) {
+        if (time - insertTimes[index] > cacheSize) {
+            insertTimes[index] = time++;
+            misses++;
+        }
+    }
+    return static_cast<float>(misses) / static_cast<float>(triangleCount);
+}
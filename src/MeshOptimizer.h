@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Reorders indexed triangle lists for post-transform vertex cache reuse and vertex fetch locality.
+ */
+class MeshOptimizer final {
+public:
+    /// Cache size the triangle order is optimized for
+    static constexpr uint32_t CACHE_SIZE = 32u;
+    /// Cache size used to report ACMR, FIFO caches of this size are a common lower bound of real hardware
+    static constexpr uint32_t REPORT_CACHE_SIZE = 16u;
+
+public:
+    MeshOptimizer() = delete;
+
+    /**
+     * @brief Reorders triangles with Forsyth's linear-speed vertex cache optimization.
+     * Vertices are not touched, so the index buffer stays valid for the same vertex buffer.
+     */
+    static void OptimizeVertexCache(std::vector<uint32_t> &rIndices, uint32_t vertexCount);
+
+    /**
+     * @brief Reorders vertices into the order they are first referenced by rIndices and remaps the indices.
+     * Unreferenced vertices are dropped. Returns the new vertex count.
+     */
+    static uint32_t OptimizeVertexFetch(std::vector<uint32_t> &rIndices, std::vector<unsigned char> &rVertexBuffer,
+                                        uint32_t vertexSize);
+
+    /**
+     * @brief Average cache miss ratio (transformed vertices per triangle) of a simulated FIFO vertex cache.
+     * 3.0 is the worst case, around 0.5 - 0.7 is typical for optimized meshes.
+     */
+    static float CalculateACMR(const std::vector<uint32_t> &rIndices, uint32_t vertexCount,
+                               uint32_t cacheSize = REPORT_CACHE_SIZE);
+};
@@ -0,0 +1,495 @@
+#include "ObjParser.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+#include "MappedFile.h"
+
+namespace {
+// Chunks smaller than this are not worth a thread
+const size_t MIN_CHUNK_SIZE = 1024 * 1024;
+
+enum Attribute : uint32_t { POSITION = 0, TEX_COORD = 1, NORMAL = 2 };
+
+/**
+ * Attribute indices of one face corner. Absolute indices are stored as in the file (1-based), relative (negative)
+ * indices are stored relative to the start of the chunk, as only the chunk local attribute count is known while
+ * parsing.
+ */
+struct Corner {
+    std::array<int32_t, 3> index;
+    uint8_t presentMask;
+    uint8_t relativeMask;
+};
+
+struct Chunk {
+    const char *pBegin = nullptr;
+    const char *pEnd = nullptr;
+
+    std::vector<float> positions;
+    std::vector<float> texCoords;
+    std::vector<float> normals;
+    std::vector<Corner> corners;
+
+    // Attribute layout of the first corner and whether all corners of the chunk share it
+    uint8_t layoutMask = 0;
+    bool consistent = true;
+
+    // Offsets into the merged arrays, in elements (vertices, corners)
+    std::array<size_t, 3> attributeBase{};
+    size_t cornerBase = 0;
+};
+
+void parallelFor(uint32_t count, const std::function<void(uint32_t)> &rFunction) {
+    std::vector<std::exception_ptr> exceptions(count);
+    auto run = [&](uint32_t i) {
+        try {
+            rFunction(i);
+        } catch (...) {
+            exceptions[i] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < count; i++) {
+        threads.emplace_back(run, i);
+    }
+    if (count > 0) {
+        // Calling thread takes the first item
+        run(0);
+    }
+    for (std::thread &rThread : threads) {
+        rThread.join();
+    }
+
+    for (const std::exception_ptr &rException : exceptions) {
+        if (rException) {
+            std::rethrow_exception(rException);
+        }
+    }
+}
+
+bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+const char *skipBlanks(const char *p, const char *pEnd) {
+    while (p < pEnd && isBlank(*p)) {
+        p++;
+    }
+    return p;
+}
+
+const char *skipLine(const char *p, const char *pEnd) {
+    const char *pNewLine = static_cast<const char *>(std::memchr(p, '\n', pEnd - p));
+    return pNewLine != nullptr ? pNewLine + 1 : pEnd;
+}
+
+double powerOfTen(int32_t exponent) {
+    static const std::array<double, 23> exactPowers = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                                       1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                                       1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    if (exponent >= 0 && exponent < static_cast<int32_t>(exactPowers.size())) {
+        return exactPowers[exponent];
+    }
+    return std::pow(10.0, exponent);
+}
+
+/**
+ * Locale independent float parser for the plain decimal notation used in OBJ files, accurate to float precision.
+ */
+const char *parseFloat(const char *p, const char *pEnd, float &rValue) {
+    p = skipBlanks(p, pEnd);
+
+    bool negative = false;
+    if (p < pEnd && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+
+    // Up to 18 significant digits fit into the mantissa, remaining integer digits only scale it
+    const uint64_t maxMantissa = 100000000000000000ull;
+    uint64_t mantissa = 0;
+    int32_t exponent = 0;
+    bool hasDigits = false;
+    for (; p < pEnd && isDigit(*p); p++) {
+        hasDigits = true;
+        if (mantissa < maxMantissa) {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+        } else {
+            exponent++;
+        }
+    }
+    if (p < pEnd && *p == '.') {
+        p++;
+        for (; p < pEnd && isDigit(*p); p++) {
+            hasDigits = true;
+            if (mantissa < maxMantissa) {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                exponent--;
+            }
+        }
+    }
+    if (!hasDigits) {
+        throw std::runtime_error("obj: invalid number!");
+    }
+
+    if (p < pEnd && (*p == 'e' || *p == 'E')) {
+        p++;
+        bool negativeExponent = false;
+        if (p < pEnd && (*p == '-' || *p == '+')) {
+            negativeExponent = (*p == '-');
+            p++;
+        }
+        int32_t value = 0;
+        for (; p < pEnd && isDigit(*p); p++) {
+            if (value < 10000) {
+                value = value * 10 + (*p - '0');
+            }
+        }
+        exponent += negativeExponent ? -value : value;
+    }
+
+    double value = static_cast<double>(mantissa);
+    if (mantissa != 0 && exponent != 0) {
+        // Dividing by an exact power keeps e.g. 0.1 correctly rounded
+        value = exponent < 0 ? value / powerOfTen(-exponent) : value * powerOfTen(exponent);
+    }
+    rValue = static_cast<float>(negative ? -value : value);
+    return p;
+}
+
+const char *parseFloats(const char *p, const char *pEnd, uint32_t count, std::vector<float> &rOutput) {
+    for (uint32_t i = 0; i < count; i++) {
+        p = parseFloat(p, pEnd, rOutput.emplace_back());
+    }
+    return p;
+}
+
+const char *parseIndex(const char *p, const char *pEnd, size_t localCount, Corner &rCorner, Attribute attribute) {
+    bool negative = false;
+    if (p < pEnd && *p == '-') {
+        negative = true;
+        p++;
+    }
+
+    int64_t value = 0;
+    bool hasDigits = false;
+    for (; p < pEnd && isDigit(*p); p++) {
+        hasDigits = true;
+        value = value * 10 + (*p - '0');
+        if (value > std::numeric_limits<int32_t>::max()) {
+            throw std::runtime_error("obj: face index out of range!");
+        }
+    }
+    if (!hasDigits || value == 0) {
+        throw std::runtime_error("obj: invalid face index!");
+    }
+
+    rCorner.presentMask |= 1u << attribute;
+    if (negative) {
+        // -1 references the last attribute parsed so far, which may still be in a previous chunk
+        rCorner.relativeMask |= 1u << attribute;
+        rCorner.index[attribute] = static_cast<int32_t>(static_cast<int64_t>(localCount) - value);
+    } else {
+        rCorner.index[attribute] = static_cast<int32_t>(value);
+    }
+    return p;
+}
+
+const char *parseFace(const char *p, const char *pEnd, Chunk &rChunk, std::vector<Corner> &rPolygon) {
+    rPolygon.clear();
+    while (true) {
+        p = skipBlanks(p, pEnd);
+        if (p >= pEnd || *p == '\n' || *p == '#') {
+            break;
+        }
+
+        Corner &rCorner = rPolygon.emplace_back();
+        rCorner = Corner{};
+        p = parseIndex(p, pEnd, rChunk.positions.size() / 3, rCorner, POSITION);
+        if (p < pEnd && *p == '/') {
+            p++;
+            if (p < pEnd && *p != '/') {
+                p = parseIndex(p, pEnd, rChunk.texCoords.size() / 2, rCorner, TEX_COORD);
+            }
+            if (p < pEnd && *p == '/') {
+                p++;
+                p = parseIndex(p, pEnd, rChunk.normals.size() / 3, rCorner, NORMAL);
+            }
+        }
+    }
+
+    if (rPolygon.size() < 3) {
+        throw std::runtime_error("obj: face with less than 3 vertices!");
+    }
+
+    if (rChunk.corners.empty()) {
+        rChunk.layoutMask = rPolygon.front().presentMask;
+    }
+    // Triangulate as fan
+    for (size_t i = 1; i + 1 < rPolygon.size(); i++) {
+        rChunk.corners.push_back(rPolygon[0]);
+        rChunk.corners.push_back(rPolygon[i]);
+        rChunk.corners.push_back(rPolygon[i + 1]);
+    }
+    for (const Corner &rCorner : rPolygon) {
+        rChunk.consistent &= (rCorner.presentMask == rChunk.layoutMask);
+    }
+    return p;
+}
+
+void parseChunk(Chunk &rChunk) {
+    std::vector<Corner> polygon;
+    const char *p = rChunk.pBegin;
+    const char *pEnd = rChunk.pEnd;
+
+    while (p < pEnd) {
+        p = skipBlanks(p, pEnd);
+        if (pEnd - p >= 2) {
+            if (p[0] == 'v' && isBlank(p[1])) {
+                p = parseFloats(p + 2, pEnd, 3, rChunk.positions);
+            } else if (p[0] == 'f' && isBlank(p[1])) {
+                p = parseFace(p + 2, pEnd, rChunk, polygon);
+            } else if (pEnd - p >= 3 && p[0] == 'v' && p[1] == 'n' && isBlank(p[2])) {
+                p = parseFloats(p + 3, pEnd, 3, rChunk.normals);
+            } else if (pEnd - p >= 3 && p[0] == 'v' && p[1] == 't' && isBlank(p[2])) {
+                p = parseFloats(p + 3, pEnd, 2, rChunk.texCoords);
+            }
+        }
+        // Skips optional components (w, vertex colors), comments and unsupported statements
+        p = skipLine(p, pEnd);
+    }
+}
+
+uint64_t hashVertex(const unsigned char *pVertex, uint32_t vertexSize) {
+    // FNV-1a over 32 bit words (all attributes are floats) with a final avalanche
+    uint64_t hash = 14695981039346656037ull;
+    for (uint32_t i = 0; i < vertexSize; i += sizeof(uint32_t)) {
+        uint32_t word;
+        std::memcpy(&word, pVertex + i, sizeof(word));
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return hash;
+}
+}  // namespace
+
+ObjMesh ObjParser::Parse(const std::filesystem::path &rFilePath, uint32_t numThreads) {
+    if (numThreads == 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    MappedFile file(rFilePath);
+    const char *pData = reinterpret_cast<const char *>(file.GetData().data());
+    const size_t size = file.GetData().size();
+
+    // Split into line aligned chunks
+    const uint32_t numChunks =
+        static_cast<uint32_t>(std::clamp<size_t>(size / MIN_CHUNK_SIZE, 1, static_cast<size_t>(numThreads)));
+    std::vector<Chunk> chunks(numChunks);
+    const char *pPrevious = pData;
+    for (uint32_t i = 0; i < numChunks; i++) {
+        const char *pEnd = pData + size;
+        if (i + 1 < numChunks) {
+            pEnd = std::max(pPrevious, pData + size / numChunks * (i + 1));
+            pEnd = skipLine(pEnd, pData + size);
+        }
+        chunks[i].pBegin = pPrevious;
+        chunks[i].pEnd = pEnd;
+        pPrevious = pEnd;
+    }
+
+    parallelFor(numChunks, [&](uint32_t i) { parseChunk(chunks[i]); });
+
+    // Chunk offsets into merged arrays
+    std::array<size_t, 3> attributeCounts{};
+    size_t cornerCount = 0;
+    int32_t layoutMask = -1;
+    for (Chunk &rChunk : chunks) {
+        rChunk.attributeBase = attributeCounts;
+        rChunk.cornerBase = cornerCount;
+        attributeCounts[POSITION] += rChunk.positions.size() / 3;
+        attributeCounts[TEX_COORD] += rChunk.texCoords.size() / 2;
+        attributeCounts[NORMAL] += rChunk.normals.size() / 3;
+        cornerCount += rChunk.corners.size();
+
+        if (rChunk.corners.empty()) {
+            continue;
+        }
+        if (layoutMask < 0) {
+            layoutMask = rChunk.layoutMask;
+        }
+        if (!rChunk.consistent || rChunk.layoutMask != layoutMask) {
+            throw std::runtime_error("obj: face vertex attributes not consistent!");
+        }
+    }
+    if (cornerCount > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("obj: too many faces!");
+    }
+
+    ObjMesh mesh;
+    mesh.hasTexCoords = (layoutMask > 0) && (layoutMask & (1u << TEX_COORD));
+    mesh.hasNormals = (layoutMask > 0) && (layoutMask & (1u << NORMAL));
+    mesh.vertexSize = 3 * sizeof(float);
+    if (mesh.hasNormals) {
+        mesh.vertexSize += 3 * sizeof(float);
+    }
+    if (mesh.hasTexCoords) {
+        mesh.vertexSize += 2 * sizeof(float);
+    }
+    if (cornerCount == 0) {
+        return mesh;
+    }
+
+    // Merge attributes of all chunks, relative indices can reference attributes of previous chunks
+    std::vector<float> positions(attributeCounts[POSITION] * 3);
+    std::vector<float> texCoords(attributeCounts[TEX_COORD] * 2);
+    std::vector<float> normals(attributeCounts[NORMAL] * 3);
+    parallelFor(numChunks, [&](uint32_t i) {
+        Chunk &rChunk = chunks[i];
+        std::copy(rChunk.positions.begin(), rChunk.positions.end(),
+                  positions.begin() + rChunk.attributeBase[POSITION] * 3);
+        std::copy(rChunk.texCoords.begin(), rChunk.texCoords.end(),
+                  texCoords.begin() + rChunk.attributeBase[TEX_COORD] * 2);
+        std::copy(rChunk.normals.begin(), rChunk.normals.end(), normals.begin() + rChunk.attributeBase[NORMAL] * 3);
+        rChunk.positions = {};
+        rChunk.texCoords = {};
+        rChunk.normals = {};
+    });
+
+    // Assemble interleaved vertex of every corner at its preallocated offset, hash it and count hash partitions
+    const uint32_t numPartitions = numThreads;
+    const uint32_t vertexSize = mesh.vertexSize;
+    std::vector<unsigned char> cornerVertices(cornerCount * vertexSize);
+    std::vector<uint64_t> hashes(cornerCount);
+    std::vector<std::vector<size_t>> partitionOffsets(numChunks, std::vector<size_t>(numPartitions, 0));
+
+    auto partitionOf = [numPartitions](uint64_t hash) { return static_cast<uint32_t>((hash >> 40) % numPartitions); };
+
+    parallelFor(numChunks, [&](uint32_t i) {
+        const Chunk &rChunk = chunks[i];
+        auto resolve = [&](const Corner &rCorner, Attribute attribute) {
+            int64_t index = rCorner.index[attribute];
+            if (rCorner.relativeMask & (1u << attribute)) {
+                index += static_cast<int64_t>(rChunk.attributeBase[attribute]);
+            } else {
+                index -= 1;
+            }
+            if (index < 0 || static_cast<size_t>(index) >= attributeCounts[attribute]) {
+                throw std::runtime_error("obj: face index out of range!");
+            }
+            return static_cast<size_t>(index);
+        };
+
+        for (size_t c = 0; c < rChunk.corners.size(); c++) {
+            const Corner &rCorner = rChunk.corners[c];
+            const size_t corner = rChunk.cornerBase + c;
+            unsigned char *pVertex = &cornerVertices[corner * vertexSize];
+
+            uint32_t offset = 0;
+            std::memcpy(pVertex, &positions[resolve(rCorner, POSITION) * 3], 3 * sizeof(float));
+            offset += 3 * sizeof(float);
+            if (mesh.hasNormals) {
+                std::memcpy(pVertex + offset, &normals[resolve(rCorner, NORMAL) * 3], 3 * sizeof(float));
+                offset += 3 * sizeof(float);
+            }
+            if (mesh.hasTexCoords) {
+                std::memcpy(pVertex + offset, &texCoords[resolve(rCorner, TEX_COORD) * 2], 2 * sizeof(float));
+            }
+
+            hashes[corner] = hashVertex(pVertex, vertexSize);
+            partitionOffsets[i][partitionOf(hashes[corner])]++;
+        }
+    });
+
+    // Counts to offsets, partitions are contiguous and ordered by chunk within a partition
+    std::vector<size_t> partitionBegin(numPartitions + 1, 0);
+    size_t offset = 0;
+    for (uint32_t p = 0; p < numPartitions; p++) {
+        partitionBegin[p] = offset;
+        for (uint32_t i = 0; i < numChunks; i++) {
+            size_t count = partitionOffsets[i][p];
+            partitionOffsets[i][p] = offset;
+            offset += count;
+        }
+    }
+    partitionBegin[numPartitions] = offset;
+
+    std::vector<uint32_t> partitionedCorners(cornerCount);
+    parallelFor(numChunks, [&](uint32_t i) {
+        const Chunk &rChunk = chunks[i];
+        for (size_t c = 0; c < rChunk.corners.size(); c++) {
+            const size_t corner = rChunk.cornerBase + c;
+            partitionedCorners[partitionOffsets[i][partitionOf(hashes[corner])]++] = static_cast<uint32_t>(corner);
+        }
+    });
+    chunks.clear();
+
+    // Deduplicate every partition independently with an open addressing table, ids are partition local first
+    mesh.indices.resize(cornerCount);
+    std::vector<std::vector<uint32_t>> uniqueCorners(numPartitions);
+    parallelFor(numPartitions, [&](uint32_t p) {
+        const size_t count = partitionBegin[p + 1] - partitionBegin[p];
+        size_t tableSize = 16;
+        while (tableSize < count * 2) {
+            tableSize *= 2;
+        }
+        // Slot stores corner + 1 of the first occurrence, 0 is empty
+        std::vector<uint32_t> slots(tableSize, 0);
+        std::vector<uint32_t> slotIds(tableSize);
+        std::vector<uint32_t> &rUnique = uniqueCorners[p];
+
+        for (size_t k = partitionBegin[p]; k < partitionBegin[p + 1]; k++) {
+            const uint32_t corner = partitionedCorners[k];
+            const unsigned char *pVertex = &cornerVertices[static_cast<size_t>(corner) * vertexSize];
+            size_t slot = hashes[corner] & (tableSize - 1);
+            while (true) {
+                if (slots[slot] == 0) {
+                    slots[slot] = corner + 1;
+                    slotIds[slot] = static_cast<uint32_t>(rUnique.size());
+                    rUnique.push_back(corner);
+                    break;
+                }
+                const uint32_t other = slots[slot] - 1;
+                if (hashes[other] == hashes[corner] &&
+                    std::memcmp(&cornerVertices[static_cast<size_t>(other) * vertexSize], pVertex, vertexSize) == 0) {
+                    break;
+                }
+                slot = (slot + 1) & (tableSize - 1);
+            }
+            mesh.indices[corner] = slotIds[slot];
+        }
+    });
+
+    // Partition local ids to global ids, copy unique vertices to their final place
+    std::vector<uint32_t> vertexBase(numPartitions, 0);
+    uint32_t vertexCount = 0;
+    for (uint32_t p = 0; p < numPartitions; p++) {
+        vertexBase[p] = vertexCount;
+        vertexCount += static_cast<uint32_t>(uniqueCorners[p].size());
+    }
+
+    mesh.vertices.resize(static_cast<size_t>(vertexCount) * vertexSize);
+    parallelFor(numPartitions, [&](uint32_t p) {
+        const std::vector<uint32_t> &rUnique = uniqueCorners[p];
+        for (size_t id = 0; id < rUnique.size(); id++) {
+            std::memcpy(&mesh.vertices[(vertexBase[p] + id) * vertexSize],
+                        &cornerVertices[static_cast<size_t>(rUnique[id]) * vertexSize], vertexSize);
+        }
+        for (size_t k = partitionBegin[p]; k < partitionBegin[p + 1]; k++) {
+            mesh.indices[partitionedCorners[k]] += vertexBase[p];
+        }
+    });
+
+    return mesh;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+/**
+ * @brief Interleaved, deduplicated vertices (position, optional normal, optional tex coords) of an OBJ file.
+ */
+struct ObjMesh {
+    bool hasNormals = false;
+    bool hasTexCoords = false;
+    uint32_t vertexSize = 0;
+    std::vector<unsigned char> vertices;
+    // Triangle list, faces with more corners are triangulated as fans
+    std::vector<uint32_t> indices;
+};
+
+/**
+ * @brief Multi-threaded OBJ parser. The memory mapped file is split into line-aligned chunks that are parsed in
+ * parallel, vertex assembly and deduplication run in parallel on hash partitions. Materials, groups and smoothing
+ * groups are ignored, all shapes end up in one mesh.
+ */
+class ObjParser final {
+public:
+    ObjParser() = delete;
+
+    /**
+     * @brief Parses the file with numThreads threads (0 = number of hardware threads).
+     */
+    static ObjMesh Parse(const std::filesystem::path &rFilePath, uint32_t numThreads = 0);
+};
@@ -0,0 +1,158 @@
+#include "PipelineCache.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+std::vector<char> readFile(const std::filesystem::path &rFilePath) {
+    std::ifstream file(rFilePath, std::ios::ate | std::ios::binary);
+    if (!file.is_open()) {
+        return {};
+    }
+    std::vector<char> data(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(data.data(), static_cast<std::streamsize>(data.size()));
+    return data;
+}
+}  // namespace
+
+PipelineCache::PipelineCache(VkDevice device, VkPhysicalDevice physicalDevice, std::filesystem::path filePath,
+                             bool creationFeedbackSupported)
+    : device_(device), filePath_(std::move(filePath)), creationFeedbackSupported_(creationFeedbackSupported) {
+    vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties_);
+
+    std::vector<char> data = readFile(filePath_);
+    if (!data.empty() && !isCompatible(data)) {
+        // Driver update or other GPU, drivers may crash on foreign data, so do not even pass it
+        std::cout << "Pipeline cache " << filePath_.string() << " was created by another device or driver, ignored"
+                  << std::endl;
+        data.clear();
+    }
+
+    VkPipelineCacheCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = data.size();
+    createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+    if (vkCreatePipelineCache(device_, &createInfo, nullptr, &pipelineCache_) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline cache!");
+    }
+    loadedSize_ = data.size();
+}
+
+PipelineCache::~PipelineCache() {
+    try {
+        Save();
+    } catch (const std::exception &rException) {
+        std::cerr << rException.what() << std::endl;
+    }
+    vkDestroyPipelineCache(device_, pipelineCache_, nullptr);
+}
+
+bool PipelineCache::isCompatible(const std::vector<char> &rData) const {
+    VkPipelineCacheHeaderVersionOne header;
+    if (rData.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, rData.data(), sizeof(header));
+
+    return header.headerSize >= sizeof(header) && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           header.vendorID == deviceProperties_.vendorID && header.deviceID == deviceProperties_.deviceID &&
+           std::memcmp(header.pipelineCacheUUID, deviceProperties_.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+VkPipeline PipelineCache::CreateGraphicsPipeline(const VkGraphicsPipelineCreateInfo &rCreateInfo) {
+    return createPipeline(rCreateInfo, [this](const VkGraphicsPipelineCreateInfo &rInfo, VkPipeline &rPipeline) {
+        if (vkCreateGraphicsPipelines(device_, pipelineCache_, 1, &rInfo, nullptr, &rPipeline) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create graphics pipeline!");
+        }
+    });
+}
+
+VkPipeline PipelineCache::CreateComputePipeline(const VkComputePipelineCreateInfo &rCreateInfo) {
+    return createPipeline(rCreateInfo, [this](const VkComputePipelineCreateInfo &rInfo, VkPipeline &rPipeline) {
+        if (vkCreateComputePipelines(device_, pipelineCache_, 1, &rInfo, nullptr, &rPipeline) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create compute pipeline!");
+        }
+    });
+}
+
+template <typename CreateInfo, typename Create>
+VkPipeline PipelineCache::createPipeline(const CreateInfo &rCreateInfo, Create &&rrCreate) {
+    CreateInfo createInfo = rCreateInfo;
+
+    VkPipelineCreationFeedbackEXT feedback{};
+    VkPipelineCreationFeedbackCreateInfoEXT feedbackInfo{};
+    if (creationFeedbackSupported_) {
+        feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+        feedbackInfo.pNext = createInfo.pNext;
+        feedbackInfo.pPipelineCreationFeedback = &feedback;
+        createInfo.pNext = &feedbackInfo;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    rrCreate(createInfo, pipeline);
+    double durationMs =
+        std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    std::lock_guard<std::mutex> lock(statisticsMutex_);
+    Timings *pTimings = &unknown_;
+    if (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT_EXT) {
+        bool hit = (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT) != 0;
+        pTimings = hit ? &hits_ : &misses_;
+    }
+    pTimings->count++;
+    pTimings->totalMs += durationMs;
+    return pipeline;
+}
+
+void PipelineCache::Save() {
+    size_t size = 0;
+    if (vkGetPipelineCacheData(device_, pipelineCache_, &size, nullptr) != VK_SUCCESS || size == 0) {
+        return;
+    }
+    std::vector<char> data(size);
+    if (vkGetPipelineCacheData(device_, pipelineCache_, &size, data.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to get pipeline cache data!");
+    }
+
+    if (filePath_.has_parent_path()) {
+        std::filesystem::create_directories(filePath_.parent_path());
+    }
+
+    // Replace old file only once the new one is complete
+    std::filesystem::path tempPath = filePath_;
+    tempPath += ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.write(data.data(), static_cast<std::streamsize>(size))) {
+            throw std::runtime_error("failed to write pipeline cache: " + tempPath.string() + "!");
+        }
+    }
+    std::filesystem::rename(tempPath, filePath_);
+}
+
+void PipelineCache::PrintStatistics(std::ostream &rStream) const {
+    std::lock_guard<std::mutex> lock(statisticsMutex_);
+    auto print = [&rStream](const char *pName, const Timings &rTimings) {
+        rStream << "  " << pName << ": " << rTimings.count << " pipelines, " << rTimings.totalMs << " ms total";
+        if (rTimings.count > 0) {
+            rStream << ", " << rTimings.totalMs / rTimings.count << " ms avg";
+        }
+        rStream << std::endl;
+    };
+
+    rStream << "Pipeline cache (" << loadedSize_ << " bytes loaded from " << filePath_.string() << "):" << std::endl;
+    if (creationFeedbackSupported_) {
+        print("hits", hits_);
+        print("misses", misses_);
+    }
+    if (unknown_.count > 0 || !creationFeedbackSupported_) {
+        print("created (no feedback)", unknown_);
+    }
+}
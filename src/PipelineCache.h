@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+/**
+ * @brief VkPipelineCache shared by all pipelines of a device, persisted to disk between runs.
+ * Cache data of another driver or device is discarded on load.
+ */
+class PipelineCache final {
+public:
+    PipelineCache(VkDevice device, VkPhysicalDevice physicalDevice, std::filesystem::path filePath,
+                  bool creationFeedbackSupported);
+    /// Saves the cache to disk
+    ~PipelineCache();
+
+    PipelineCache(const PipelineCache &) = delete;
+    PipelineCache &operator=(const PipelineCache &) = delete;
+
+    VkPipelineCache GetHandle() const { return pipelineCache_; }
+
+    /**
+     * @brief Creates the pipeline through the cache and records whether it was a cache hit and how long it took.
+     */
+    VkPipeline CreateGraphicsPipeline(const VkGraphicsPipelineCreateInfo &rCreateInfo);
+    VkPipeline CreateComputePipeline(const VkComputePipelineCreateInfo &rCreateInfo);
+
+    void Save();
+
+    void PrintStatistics(std::ostream &rStream) const;
+
+private:
+    struct Timings {
+        uint32_t count = 0;
+        double totalMs = 0.0;
+    };
+
+    bool isCompatible(const std::vector<char> &rData) const;
+
+    /**
+     * @brief Chains creation feedback into the create info and times the creation.
+     */
+    template <typename CreateInfo, typename Create>
+    VkPipeline createPipeline(const CreateInfo &rCreateInfo, Create &&rrCreate);
+
+private:
+    VkDevice device_;
+    VkPhysicalDeviceProperties deviceProperties_{};
+    std::filesystem::path filePath_;
+    bool creationFeedbackSupported_;
+    VkPipelineCache pipelineCache_ = VK_NULL_HANDLE;
+    size_t loadedSize_ = 0;
+
+    mutable std::mutex statisticsMutex_;
+    Timings hits_;
+    Timings misses_;
+    // Without VK_EXT_pipeline_creation_feedback hits and misses can not be told apart
+    Timings unknown_;
+};
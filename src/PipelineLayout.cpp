@@ -0,0 +1,58 @@
+#include "PipelineLayout.h"
+
+#include <stdexcept>
+
+DescriptorSetLayout::DescriptorSetLayout(VkDevice device, const std::vector<VkDescriptorSetLayoutBinding> &rBindings,
+                                         const std::vector<VkDescriptorBindingFlags> &rBindingFlags)
+    : device_(device), bindings_(rBindings) {
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings_.size());
+    layoutInfo.pBindings = bindings_.data();
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+    if (!rBindingFlags.empty()) {
+        if (rBindingFlags.size() != bindings_.size()) {
+            throw std::runtime_error("failed to create descriptor set layout, binding flags do not match bindings!");
+        }
+        bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        bindingFlagsInfo.bindingCount = static_cast<uint32_t>(rBindingFlags.size());
+        bindingFlagsInfo.pBindingFlags = rBindingFlags.data();
+        layoutInfo.pNext = &bindingFlagsInfo;
+
+        for (VkDescriptorBindingFlags flags : rBindingFlags) {
+            if ((flags & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) != 0) {
+                layoutInfo.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+            }
+        }
+    }
+
+    if (vkCreateDescriptorSetLayout(device_, &layoutInfo, nullptr, &descriptorSetLayout_) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor set layout!");
+    }
+}
+
+DescriptorSetLayout::~DescriptorSetLayout() { vkDestroyDescriptorSetLayout(device_, descriptorSetLayout_, nullptr); }
+
+PipelineLayout::PipelineLayout(VkDevice device, std::vector<std::shared_ptr<const DescriptorSetLayout>> &&rrSetLayouts,
+                               const std::vector<VkPushConstantRange> &rPushConstantRanges)
+    : device_(device), setLayouts_(std::move(rrSetLayouts)) {
+    std::vector<VkDescriptorSetLayout> setLayoutHandles;
+    setLayoutHandles.reserve(setLayouts_.size());
+    for (const std::shared_ptr<const DescriptorSetLayout> &rSetLayout : setLayouts_) {
+        setLayoutHandles.push_back(rSetLayout->GetHandle());
+    }
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayoutHandles.size());
+    pipelineLayoutInfo.pSetLayouts = setLayoutHandles.data();
+    pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(rPushConstantRanges.size());
+    pipelineLayoutInfo.pPushConstantRanges = rPushConstantRanges.data();
+
+    if (vkCreatePipelineLayout(device_, &pipelineLayoutInfo, nullptr, &pipelineLayout_) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline layout!");
+    }
+}
+
+PipelineLayout::~PipelineLayout() { vkDestroyPipelineLayout(device_, pipelineLayout_, nullptr); }
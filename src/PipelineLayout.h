@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Owning wrapper of a VkDescriptorSetLayout, shared through the PipelineRegistry.
+ */
+class DescriptorSetLayout final {
+public:
+    /**
+     * @brief Binding flags are optional, one per binding. With VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT the layout
+     * can only be allocated from pools created with VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT.
+     */
+    DescriptorSetLayout(VkDevice device, const std::vector<VkDescriptorSetLayoutBinding> &rBindings,
+                        const std::vector<VkDescriptorBindingFlags> &rBindingFlags = {});
+    ~DescriptorSetLayout();
+
+    DescriptorSetLayout(const DescriptorSetLayout &) = delete;
+    DescriptorSetLayout &operator=(const DescriptorSetLayout &) = delete;
+
+    VkDescriptorSetLayout GetHandle() const { return descriptorSetLayout_; }
+    const std::vector<VkDescriptorSetLayoutBinding> &GetBindings() const { return bindings_; }
+
+private:
+    VkDevice device_;
+    std::vector<VkDescriptorSetLayoutBinding> bindings_;
+    VkDescriptorSetLayout descriptorSetLayout_ = VK_NULL_HANDLE;
+};
+
+/**
+ * @brief Owning wrapper of a VkPipelineLayout, keeps its descriptor set layouts alive.
+ */
+class PipelineLayout final {
+public:
+    PipelineLayout(VkDevice device, std::vector<std::shared_ptr<const DescriptorSetLayout>> &&rrSetLayouts,
+                   const std::vector<VkPushConstantRange> &rPushConstantRanges);
+    ~PipelineLayout();
+
+    PipelineLayout(const PipelineLayout &) = delete;
+    PipelineLayout &operator=(const PipelineLayout &) = delete;
+
+    VkPipelineLayout GetHandle() const { return pipelineLayout_; }
+    const std::vector<std::shared_ptr<const DescriptorSetLayout>> &GetSetLayouts() const { return setLayouts_; }
+
+private:
+    VkDevice device_;
+    std::vector<std::shared_ptr<const DescriptorSetLayout>> setLayouts_;
+    VkPipelineLayout pipelineLayout_ = VK_NULL_HANDLE;
+};
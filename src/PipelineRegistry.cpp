@@ -0,0 +1,138 @@
+#include "PipelineRegistry.h"
+
+#include <cstring>
+
+#include "DeviceContext.h"
+#include "Hash.h"
+
+namespace {
+template <typename T>
+bool equalBytes(const std::vector<T> &rA, const std::vector<T> &rB) {
+    return rA.size() == rB.size() && (rA.empty() || std::memcmp(rA.data(), rB.data(), rA.size() * sizeof(T)) == 0);
+}
+
+template <typename Map>
+size_t countAlive(const Map &rMap) {
+    size_t count = 0;
+    for (const auto &rEntry : rMap) {
+        count += rEntry.second.expired() ? 0 : 1;
+    }
+    return count;
+}
+}  // namespace
+
+bool PipelineRegistry::PipelineLayoutKey::operator==(const PipelineLayoutKey &rOther) const {
+    return setLayouts == rOther.setLayouts && equalBytes(pushConstantRanges, rOther.pushConstantRanges);
+}
+
+size_t PipelineRegistry::BindingsHasher::operator()(const std::vector<VkDescriptorSetLayoutBinding> &rBindings) const {
+    return static_cast<size_t>(Hash::Bytes(rBindings));
+}
+
+bool PipelineRegistry::BindingsEqual::operator()(const std::vector<VkDescriptorSetLayoutBinding> &rA,
+                                                 const std::vector<VkDescriptorSetLayoutBinding> &rB) const {
+    return equalBytes(rA, rB);
+}
+
+size_t PipelineRegistry::PipelineLayoutKeyHasher::operator()(const PipelineLayoutKey &rKey) const {
+    // Set layouts are deduplicated themselves, so equal layouts have equal handles
+    return static_cast<size_t>(Hash::Combine(Hash::Bytes(rKey.setLayouts), Hash::Bytes(rKey.pushConstantRanges)));
+}
+
+PipelineRegistry::PipelineRegistry(DeviceContext &rDeviceContext) : rDeviceContext_(rDeviceContext) {}
+
+// Defined before its users, they need the deduced return type
+template <typename Map, typename Key, typename Create>
+auto PipelineRegistry::getOrCreate(Map &rMap, const Key &rKey, Counters &rCounters, Create &&rrCreate) {
+    rCounters.requests++;
+    auto it = rMap.find(rKey);
+    if (it != rMap.end()) {
+        if (auto spExisting = it->second.lock()) {
+            return spExisting;
+        }
+    }
+
+    // Forget destroyed objects, creating is rare and far more expensive than this
+    std::erase_if(rMap, [](const auto &rEntry) { return rEntry.second.expired(); });
+
+    auto spCreated = rrCreate();
+    rMap.insert_or_assign(rKey, spCreated);
+    rCounters.created++;
+    return spCreated;
+}
+
+std::shared_ptr<const DescriptorSetLayout> PipelineRegistry::GetDescriptorSetLayout(
+    const std::vector<VkDescriptorSetLayoutBinding> &rBindings) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return getDescriptorSetLayout(rBindings);
+}
+
+std::shared_ptr<const PipelineLayout> PipelineRegistry::GetPipelineLayout(
+    const std::vector<std::shared_ptr<const DescriptorSetLayout>> &rSetLayouts,
+    const std::vector<VkPushConstantRange> &rPushConstantRanges) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return getPipelineLayout(rSetLayouts, rPushConstantRanges);
+}
+
+std::shared_ptr<GraphicsPipeline> PipelineRegistry::GetGraphicsPipeline(const GraphicsPipeline::State &rState) {
+    // Held while compiling, so concurrent requests of the same state do not compile it twice
+    std::lock_guard<std::mutex> lock(mutex_);
+    pipelineCounters_.requests++;
+    const uint64_t hash = rState.ComputeHash();
+    auto [begin, end] = pipelines_.equal_range(hash);
+    for (auto it = begin; it != end; ++it) {
+        // Different states may share a hash
+        std::shared_ptr<GraphicsPipeline> spExisting = it->second.lock();
+        if (spExisting != nullptr && spExisting->GetState() == rState) {
+            return spExisting;
+        }
+    }
+
+    // Forget destroyed pipelines, creating is rare and far more expensive than this
+    std::erase_if(pipelines_, [](const auto &rEntry) { return rEntry.second.expired(); });
+
+    std::vector<std::shared_ptr<const DescriptorSetLayout>> setLayouts = {
+        getDescriptorSetLayout(rState.descriptorSetLayoutBindings)};
+    setLayouts.insert(setLayouts.end(), rState.extraSetLayouts.begin(), rState.extraSetLayouts.end());
+    std::shared_ptr<const PipelineLayout> spPipelineLayout = getPipelineLayout(setLayouts, rState.pushConstantRanges);
+    auto spCreated = std::make_shared<GraphicsPipeline>(rDeviceContext_, rState, std::move(spPipelineLayout));
+    pipelines_.emplace(hash, spCreated);
+    pipelineCounters_.created++;
+    return spCreated;
+}
+
+void PipelineRegistry::PrintStatistics(std::ostream &rStream) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto print = [&rStream](const char *pName, const Counters &rCounters, size_t alive) {
+        rStream << "  " << pName << ": " << rCounters.requests << " requests, " << rCounters.created << " created, "
+                << alive << " alive" << std::endl;
+    };
+
+    rStream << "Pipeline registry:" << std::endl;
+    print("pipelines", pipelineCounters_, countAlive(pipelines_));
+    print("pipeline layouts", pipelineLayoutCounters_, countAlive(pipelineLayouts_));
+    print("descriptor set layouts", descriptorSetLayoutCounters_, countAlive(descriptorSetLayouts_));
+}
+
+std::shared_ptr<const DescriptorSetLayout> PipelineRegistry::getDescriptorSetLayout(
+    const std::vector<VkDescriptorSetLayoutBinding> &rBindings) {
+    return getOrCreate(descriptorSetLayouts_, rBindings, descriptorSetLayoutCounters_, [&]() {
+        return std::make_shared<const DescriptorSetLayout>(rDeviceContext_.GetDevice(), rBindings);
+    });
+}
+
+std::shared_ptr<const PipelineLayout> PipelineRegistry::getPipelineLayout(
+    const std::vector<std::shared_ptr<const DescriptorSetLayout>> &rSetLayouts,
+    const std::vector<VkPushConstantRange> &rPushConstantRanges) {
+    PipelineLayoutKey key;
+    key.pushConstantRanges = rPushConstantRanges;
+    for (const std::shared_ptr<const DescriptorSetLayout> &rSetLayout : rSetLayouts) {
+        key.setLayouts.push_back(rSetLayout->GetHandle());
+    }
+
+    return getOrCreate(pipelineLayouts_, key, pipelineLayoutCounters_, [&]() {
+        return std::make_shared<const PipelineLayout>(
+            rDeviceContext_.GetDevice(), std::vector<std::shared_ptr<const DescriptorSetLayout>>(rSetLayouts),
+            rPushConstantRanges);
+    });
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+#include "GraphicsPipeline.h"
+#include "PipelineLayout.h"
+
+class DeviceContext;
+
+/**
+ * @brief Deduplicates pipelines, pipeline layouts and descriptor set layouts by their full state.
+ * Objects are shared and reference counted, the registry only keeps weak references and an object is destroyed
+ * with its last user. Requesting equal state again while it is alive returns the same object.
+ */
+class PipelineRegistry final {
+public:
+    explicit PipelineRegistry(DeviceContext &rDeviceContext);
+
+    PipelineRegistry(const PipelineRegistry &) = delete;
+    PipelineRegistry &operator=(const PipelineRegistry &) = delete;
+
+    std::shared_ptr<const DescriptorSetLayout> GetDescriptorSetLayout(
+        const std::vector<VkDescriptorSetLayoutBinding> &rBindings);
+
+    std::shared_ptr<const PipelineLayout> GetPipelineLayout(
+        const std::vector<std::shared_ptr<const DescriptorSetLayout>> &rSetLayouts,
+        const std::vector<VkPushConstantRange> &rPushConstantRanges);
+
+    /**
+     * @brief Returns a pipeline for the state, only compiles a new one if no pipeline with equal state is alive.
+     */
+    std::shared_ptr<GraphicsPipeline> GetGraphicsPipeline(const GraphicsPipeline::State &rState);
+
+    void PrintStatistics(std::ostream &rStream) const;
+
+private:
+    struct PipelineLayoutKey {
+        std::vector<VkDescriptorSetLayout> setLayouts;
+        std::vector<VkPushConstantRange> pushConstantRanges;
+
+        bool operator==(const PipelineLayoutKey &rOther) const;
+    };
+
+    struct BindingsHasher {
+        size_t operator()(const std::vector<VkDescriptorSetLayoutBinding> &rBindings) const;
+    };
+    struct BindingsEqual {
+        bool operator()(const std::vector<VkDescriptorSetLayoutBinding> &rA,
+                        const std::vector<VkDescriptorSetLayoutBinding> &rB) const;
+    };
+    struct PipelineLayoutKeyHasher {
+        size_t operator()(const PipelineLayoutKey &rKey) const;
+    };
+
+    struct Counters {
+        uint32_t requests = 0;
+        uint32_t created = 0;
+    };
+
+    // Callers hold mutex_
+    std::shared_ptr<const DescriptorSetLayout> getDescriptorSetLayout(
+        const std::vector<VkDescriptorSetLayoutBinding> &rBindings);
+    std::shared_ptr<const PipelineLayout> getPipelineLayout(
+        const std::vector<std::shared_ptr<const DescriptorSetLayout>> &rSetLayouts,
+        const std::vector<VkPushConstantRange> &rPushConstantRanges);
+
+    template <typename Map, typename Key, typename Create>
+    static auto getOrCreate(Map &rMap, const Key &rKey, Counters &rCounters, Create &&rrCreate);
+
+private:
+    DeviceContext &rDeviceContext_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::vector<VkDescriptorSetLayoutBinding>, std::weak_ptr<const DescriptorSetLayout>,
+                       BindingsHasher, BindingsEqual>
+        descriptorSetLayouts_;
+    std::unordered_map<PipelineLayoutKey, std::weak_ptr<const PipelineLayout>, PipelineLayoutKeyHasher>
+        pipelineLayouts_;
+    // Keyed by state hash, states hold their shader modules and set layouts and must not keep them alive
+    std::unordered_multimap<uint64_t, std::weak_ptr<GraphicsPipeline>> pipelines_;
+
+    Counters descriptorSetLayoutCounters_;
+    Counters pipelineLayoutCounters_;
+    Counters pipelineCounters_;
+};
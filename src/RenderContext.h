@@ -3,14 +3,29 @@
 #include <vulkan/vulkan.h>
 
 #include "DeviceContext.h"
-#include "Swapchain.h"
+#include "DrawConstants.h"
+#include "FrameContext.h"
+#include "RenderTarget.h"
 
 struct RenderContext {
     DeviceContext &deviceContext;
-    Swapchain &swapchain;
+    RenderTarget &renderTarget;
     VkRenderPass &renderPass;
     VkFormat &imageFormat;
     VkCommandBuffer &commandBuffer;
+    // Resources that live until the GPU finished this frame
+    FrameContext &frameContext;
+    // Slot of frameContext in the ring of frames in flight
+    uint32_t frameIndex = 0;
     uint32_t imageIndex = 0;
     bool outOfDate = 0;
+    // Constants of this frame (see Engine), bound with every draw packet
+    FrameContext::UniformRange frameUniforms{};
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    // Materials pick their shaders for it, the Scene draws accordingly
+    DrawMode drawMode = DrawMode::Instanced;
+    // Materials draw into the G-buffer of the DeferredRenderer instead of the output
+    bool deferred = false;
+    // Light set of the LightCuller while lighting clustered, materials shade with the lights of its clusters
+    VkDescriptorSet lightSet = VK_NULL_HANDLE;
 };
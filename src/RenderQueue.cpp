@@ -0,0 +1,253 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <array>
+
+#include "DrawConstants.h"
+#include "FrameContext.h"
+#include "GraphicsPipeline.h"
+#include "InstanceData.h"
+#include "MeshBuffer.h"
+#include "materials/Material.h"
+
+namespace {
+const uint64_t ID_MASK = 0xffffu;
+const uint64_t DEPTH_MAX = 0xfffu;
+const uint32_t RADIX_BITS = 8u;
+const uint32_t RADIX_PASSES = 64u / RADIX_BITS;
+const uint32_t RADIX_BUCKETS = 1u << RADIX_BITS;
+
+uint32_t radixDigit(uint64_t key, uint32_t pass) {
+    return static_cast<uint32_t>(key >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1);
+}
+
+void printBinds(std::ostream &rStream, const char *pName, uint64_t binds, uint64_t avoided) {
+    rStream << "  " << pName << ": " << binds << " binds, " << avoided << " avoided";
+    if (binds + avoided > 0) {
+        rStream << " (" << 100.0 * static_cast<double>(avoided) / static_cast<double>(binds + avoided) << "%)";
+    }
+    rStream << std::endl;
+}
+}  // namespace
+
+uint64_t RenderQueue::MakeSortKey(Pass pass, uint32_t pipelineId, uint32_t materialId, uint32_t meshId,
+                                  float depth) {
+    const uint64_t quantizedDepth = static_cast<uint64_t>(std::clamp(depth, 0.0f, 1.0f) * DEPTH_MAX);
+    const uint64_t state = (pipelineId & ID_MASK) << 32 | (materialId & ID_MASK) << 16 | (meshId & ID_MASK);
+
+    // 4 bit pass | 60 bit pass dependent order
+    uint64_t key = static_cast<uint64_t>(pass) << 60;
+    if (pass == Pass::Transparent) {
+        // Blending needs back to front order, farthest first
+        key |= (DEPTH_MAX - quantizedDepth) << 48 | state;
+    } else {
+        // Fewest state changes first, front to back within equal state for early depth rejection
+        key |= state << 12 | quantizedDepth;
+    }
+    return key;
+}
+
+float RenderQueue::ViewDepth(const glm::mat4 &rViewProjection, const glm::vec3 &rPosition) {
+    const glm::vec4 clip = rViewProjection * glm::vec4(rPosition, 1.0f);
+    return clip.w > 0.0f ? clip.z / clip.w : 0.0f;
+}
+
+void RenderQueue::Clear() {
+    packets_.clear();
+    entries_.clear();
+}
+
+void RenderQueue::Push(uint64_t sortKey, const DrawPacket &rPacket) {
+    entries_.push_back({sortKey, static_cast<uint32_t>(packets_.size())});
+    packets_.push_back(rPacket);
+}
+
+void RenderQueue::Sort() {
+    const size_t count = entries_.size();
+    if (count < 2) {
+        return;
+    }
+    scratch_.resize(count);
+
+    // Histograms of all passes in one read of the keys
+    std::array<std::array<uint32_t, RADIX_BUCKETS>, RADIX_PASSES> histograms{};
+    for (const SortEntry &rEntry : entries_) {
+        for (uint32_t pass = 0; pass < RADIX_PASSES; pass++) {
+            histograms[pass][radixDigit(rEntry.key, pass)]++;
+        }
+    }
+
+    SortEntry *pSource = entries_.data();
+    SortEntry *pDestination = scratch_.data();
+    for (uint32_t pass = 0; pass < RADIX_PASSES; pass++) {
+        std::array<uint32_t, RADIX_BUCKETS> &rHistogram = histograms[pass];
+        if (rHistogram[radixDigit(pSource[0].key, pass)] == count) {
+            // All keys share this byte (e.g. unused ids or depth), the pass would not change the order
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (uint32_t &rBucket : rHistogram) {
+            uint32_t bucketSize = rBucket;
+            rBucket = offset;
+            offset += bucketSize;
+        }
+        for (size_t i = 0; i < count; i++) {
+            pDestination[rHistogram[radixDigit(pSource[i].key, pass)]++] = pSource[i];
+        }
+        std::swap(pSource, pDestination);
+    }
+
+    if (pSource != entries_.data()) {
+        entries_.swap(scratch_);
+    }
+}
+
+void RenderQueue::Submit(VkCommandBuffer &rCommandBuffer, size_t begin, size_t end) {
+    Statistics statistics;
+    GraphicsPipeline *pBoundPipeline = nullptr;
+    const PipelineLayout *pBoundUniformLayout = nullptr;
+    VkDescriptorSet boundUniformSet = VK_NULL_HANDLE;
+    uint32_t boundUniformOffset = 0;
+    const PipelineLayout *pBoundLayout = nullptr;
+    uint64_t boundBindKey = 0;
+    VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+    VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+    VkIndexType boundIndexType = VK_INDEX_TYPE_UINT32;
+    VkBuffer boundInstanceBuffer = VK_NULL_HANDLE;
+    VkDeviceSize boundInstanceOffset = 0;
+
+    for (size_t i = begin; i < end; i++) {
+        const DrawPacket &rPacket = packets_[entries_[i].packet];
+        const MeshBuffer &rMeshBuffer = *rPacket.pMeshBuffer;
+
+        bool pipelineChanged = rPacket.pPipeline != pBoundPipeline;
+        if (pipelineChanged) {
+            rPacket.pPipeline->Bind(rCommandBuffer);
+            pBoundPipeline = rPacket.pPipeline;
+            statistics.pipelineBinds++;
+        } else {
+            statistics.pipelineBindsAvoided++;
+        }
+
+        // Bound resources stay valid across pipelines with the same layout, so bindless materials (sharing one table)
+        // bind once per command buffer. Another layout may be incompatible, so resources are bound again.
+        const PipelineLayout *pLayout = &rPacket.pPipeline->GetLayout();
+        if (rPacket.uniformSet != VK_NULL_HANDLE) {
+            // Only moves the dynamic offset within the ring, the set itself changes when the ring grows
+            if (pLayout != pBoundUniformLayout || rPacket.uniformSet != boundUniformSet ||
+                rPacket.uniformOffset != boundUniformOffset) {
+                vkCmdBindDescriptorSets(rCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pLayout->GetHandle(),
+                                        FrameContext::UNIFORM_SET, 1, &rPacket.uniformSet, 1, &rPacket.uniformOffset);
+                pBoundUniformLayout = pLayout;
+                boundUniformSet = rPacket.uniformSet;
+                boundUniformOffset = rPacket.uniformOffset;
+                statistics.uniformBinds++;
+            } else {
+                statistics.uniformBindsAvoided++;
+            }
+        }
+
+        const uint64_t bindKey = rPacket.pMaterial->GetBindKey();
+        if (pLayout != pBoundLayout || bindKey != boundBindKey) {
+            rPacket.pMaterial->Bind(rCommandBuffer);
+            pBoundLayout = pLayout;
+            boundBindKey = bindKey;
+            statistics.materialBinds++;
+        } else {
+            statistics.materialBindsAvoided++;
+        }
+
+        if (rPacket.pConstants != nullptr) {
+            vkCmdPushConstants(rCommandBuffer, pLayout->GetHandle(), DrawConstants::STAGES, 0, sizeof(DrawConstants),
+                               rPacket.pConstants);
+            statistics.constantPushes++;
+        }
+
+        if (rMeshBuffer.GetVertexBuffer() != boundVertexBuffer) {
+            VkBuffer vertexBuffers[] = {rMeshBuffer.GetVertexBuffer()};
+            VkDeviceSize offsets[] = {0};
+            vkCmdBindVertexBuffers(rCommandBuffer, 0, 1, vertexBuffers, offsets);
+            boundVertexBuffer = rMeshBuffer.GetVertexBuffer();
+            statistics.vertexBufferBinds++;
+        } else {
+            statistics.vertexBufferBindsAvoided++;
+        }
+
+        // Usually one range per frame, so it is bound once per command buffer. Per-draw modes have none.
+        if (rPacket.instanceBuffer != VK_NULL_HANDLE) {
+            if (rPacket.instanceBuffer != boundInstanceBuffer || rPacket.instanceOffset != boundInstanceOffset) {
+                vkCmdBindVertexBuffers(rCommandBuffer, InstanceData::BINDING, 1, &rPacket.instanceBuffer,
+                                       &rPacket.instanceOffset);
+                boundInstanceBuffer = rPacket.instanceBuffer;
+                boundInstanceOffset = rPacket.instanceOffset;
+                statistics.instanceBufferBinds++;
+            } else {
+                statistics.instanceBufferBindsAvoided++;
+            }
+        }
+
+        if (rMeshBuffer.IsIndexed()) {
+            if (rMeshBuffer.GetIndexBuffer() != boundIndexBuffer || rMeshBuffer.GetIndexType() != boundIndexType) {
+                vkCmdBindIndexBuffer(rCommandBuffer, rMeshBuffer.GetIndexBuffer(), 0, rMeshBuffer.GetIndexType());
+                boundIndexBuffer = rMeshBuffer.GetIndexBuffer();
+                boundIndexType = rMeshBuffer.GetIndexType();
+                statistics.indexBufferBinds++;
+            } else {
+                statistics.indexBufferBindsAvoided++;
+            }
+        }
+
+        if (rPacket.indirectBuffer != VK_NULL_HANDLE) {
+            if (rMeshBuffer.IsIndexed()) {
+                vkCmdDrawIndexedIndirect(rCommandBuffer, rPacket.indirectBuffer, rPacket.indirectOffset, 1, 0);
+            } else {
+                vkCmdDrawIndirect(rCommandBuffer, rPacket.indirectBuffer, rPacket.indirectOffset, 1, 0);
+            }
+            statistics.indirectDraws++;
+        } else if (rMeshBuffer.IsIndexed()) {
+            vkCmdDrawIndexed(rCommandBuffer, rMeshBuffer.GetIndexCount(), rPacket.instanceCount, 0, 0,
+                             rPacket.firstInstance);
+        } else {
+            vkCmdDraw(rCommandBuffer, rMeshBuffer.GetVertexCount(), rPacket.instanceCount, 0, rPacket.firstInstance);
+        }
+        statistics.draws++;
+        statistics.instances += rPacket.instanceCount;
+    }
+
+    std::lock_guard<std::mutex> lock(statisticsMutex_);
+    statistics_.draws += statistics.draws;
+    statistics_.instances += statistics.instances;
+    statistics_.indirectDraws += statistics.indirectDraws;
+    statistics_.pipelineBinds += statistics.pipelineBinds;
+    statistics_.pipelineBindsAvoided += statistics.pipelineBindsAvoided;
+    statistics_.constantPushes += statistics.constantPushes;
+    statistics_.uniformBinds += statistics.uniformBinds;
+    statistics_.uniformBindsAvoided += statistics.uniformBindsAvoided;
+    statistics_.materialBinds += statistics.materialBinds;
+    statistics_.materialBindsAvoided += statistics.materialBindsAvoided;
+    statistics_.vertexBufferBinds += statistics.vertexBufferBinds;
+    statistics_.vertexBufferBindsAvoided += statistics.vertexBufferBindsAvoided;
+    statistics_.indexBufferBinds += statistics.indexBufferBinds;
+    statistics_.indexBufferBindsAvoided += statistics.indexBufferBindsAvoided;
+    statistics_.instanceBufferBinds += statistics.instanceBufferBinds;
+    statistics_.instanceBufferBindsAvoided += statistics.instanceBufferBindsAvoided;
+}
+
+RenderQueue::Statistics RenderQueue::GetStatistics() const {
+    std::lock_guard<std::mutex> lock(statisticsMutex_);
+    return statistics_;
+}
+
+void RenderQueue::PrintStatistics(std::ostream &rStream) const {
+    Statistics statistics = GetStatistics();
+    rStream << "Render queue (" << statistics.draws << " draws, " << statistics.indirectDraws << " of them indirect, "
+            << statistics.instances << " direct instances):" << std::endl;
+    printBinds(rStream, "pipelines", statistics.pipelineBinds, statistics.pipelineBindsAvoided);
+    rStream << "  push constants: " << statistics.constantPushes << std::endl;
+    printBinds(rStream, "uniforms", statistics.uniformBinds, statistics.uniformBindsAvoided);
+    printBinds(rStream, "materials", statistics.materialBinds, statistics.materialBindsAvoided);
+    printBinds(rStream, "vertex buffers", statistics.vertexBufferBinds, statistics.vertexBufferBindsAvoided);
+    printBinds(rStream, "index buffers", statistics.indexBufferBinds, statistics.indexBufferBindsAvoided);
+    printBinds(rStream, "instance buffers", statistics.instanceBufferBinds, statistics.instanceBufferBindsAvoided);
+}
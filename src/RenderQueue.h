@@ -0,0 +1,113 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+class GraphicsPipeline;
+class Material;
+class MeshBuffer;
+struct DrawConstants;
+
+/**
+ * @brief Everything needed to record one (instanced) draw, the state it needs is bound by the RenderQueue.
+ * Instances [firstInstance, firstInstance + instanceCount) are read from the instance buffer at instanceOffset.
+ */
+struct DrawPacket {
+    GraphicsPipeline *pPipeline = nullptr;
+    Material *pMaterial = nullptr;
+    const MeshBuffer *pMeshBuffer = nullptr;
+    VkBuffer instanceBuffer = VK_NULL_HANDLE;
+    VkDeviceSize instanceOffset = 0;
+    uint32_t firstInstance = 0;
+    uint32_t instanceCount = 1;
+    // If set, the draw parameters are read from this buffer instead (see GpuCuller)
+    VkBuffer indirectBuffer = VK_NULL_HANDLE;
+    VkDeviceSize indirectOffset = 0;
+    // Frame constants, bound as set 0 with a dynamic offset (see FrameContext::AllocateUniformData)
+    VkDescriptorSet uniformSet = VK_NULL_HANDLE;
+    uint32_t uniformOffset = 0;
+    // Pushed before the draw if set (DrawMode::PushConstants), must stay valid until the queue was submitted
+    const DrawConstants *pConstants = nullptr;
+};
+
+/**
+ * @brief Draw packets of a frame, sorted by 64 bit keys so draws sharing state are recorded next to each other.
+ * Binds of state that is already bound are skipped while recording.
+ */
+class RenderQueue final {
+public:
+    enum class Pass : uint8_t { Opaque = 0, Transparent = 1 };
+
+    struct Statistics {
+        uint64_t draws = 0;
+        uint64_t instances = 0;
+        // Included in draws, their instance count is only known to the GPU
+        uint64_t indirectDraws = 0;
+        uint64_t pipelineBinds = 0;
+        uint64_t pipelineBindsAvoided = 0;
+        uint64_t constantPushes = 0;
+        uint64_t uniformBinds = 0;
+        uint64_t uniformBindsAvoided = 0;
+        uint64_t materialBinds = 0;
+        uint64_t materialBindsAvoided = 0;
+        uint64_t vertexBufferBinds = 0;
+        uint64_t vertexBufferBindsAvoided = 0;
+        uint64_t indexBufferBinds = 0;
+        uint64_t indexBufferBindsAvoided = 0;
+        uint64_t instanceBufferBinds = 0;
+        uint64_t instanceBufferBindsAvoided = 0;
+    };
+
+public:
+    /**
+     * @brief Builds the sort key, ids are truncated to 16 bits (only grouping gets worse on collisions).
+     * Opaque draws are grouped by pipeline, material and mesh, then sorted front to back.
+     * Transparent draws are sorted back to front first, state only breaks ties.
+     * @param depth view depth normalized to [0, 1], quantized to 12 bits
+     */
+    static uint64_t MakeSortKey(Pass pass, uint32_t pipelineId, uint32_t materialId, uint32_t meshId, float depth);
+
+    /**
+     * @brief Depth of the world space position for MakeSortKey, positions behind the camera sort as nearest.
+     */
+    static float ViewDepth(const glm::mat4 &rViewProjection, const glm::vec3 &rPosition);
+
+    void Clear();
+    void Push(uint64_t sortKey, const DrawPacket &rPacket);
+
+    /**
+     * @brief Stable LSD radix sort of the keys, byte positions equal for all keys are skipped.
+     */
+    void Sort();
+
+    size_t GetSize() const { return entries_.size(); }
+
+    /**
+     * @brief Records the sorted draws [begin, end). Bound state is tracked per call, so disjoint ranges can be
+     * recorded into different command buffers concurrently.
+     */
+    void Submit(VkCommandBuffer &rCommandBuffer, size_t begin, size_t end);
+
+    Statistics GetStatistics() const;
+    void PrintStatistics(std::ostream &rStream) const;
+
+private:
+    struct SortEntry {
+        uint64_t key;
+        uint32_t packet;
+    };
+
+private:
+    std::vector<DrawPacket> packets_;
+    std::vector<SortEntry> entries_;
+    std::vector<SortEntry> scratch_;
+
+    // Accumulated over all frames
+    mutable std::mutex statisticsMutex_;
+    Statistics statistics_;
+};
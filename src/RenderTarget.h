@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+
+#include <limits>
+#include <vector>
+
+/**
+ * @brief Common interface of everything the engine can render into.
+ * Implemented by the Swapchain (window output) and the HeadlessTarget (offscreen images).
+ */
+class RenderTarget {
+public:
+    static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2u;
+
+    struct AvailableImageInfo {
+        uint32_t imageIndex = std::numeric_limits<uint32_t>::max();
+        // Slot of the frame in flight [0, MAX_FRAMES_IN_FLIGHT), its previous use finished on the GPU
+        uint32_t frameIndex = 0;
+        VkSemaphore imageAvailableSemaphore = VK_NULL_HANDLE;
+        VkSemaphore renderFinishedSemaphore = VK_NULL_HANDLE;
+        VkFence inFlightFence = VK_NULL_HANDLE;
+
+        bool IsValid() { return imageIndex != std::numeric_limits<uint32_t>::max(); }
+    };
+
+public:
+    virtual ~RenderTarget() = default;
+
+    /**
+     * @brief Recreates images if necessary.
+     * @return true if images were recreated (everything depending on them has to be recreated as well)
+     */
+    virtual bool Update() = 0;
+
+    virtual void WaitForNextFrame() = 0;
+
+    virtual AvailableImageInfo AcquireImage() = 0;
+
+    virtual bool Present(const AvailableImageInfo &availableInfo) = 0;
+
+    virtual VkFormat &GetImageFormat() = 0;
+    virtual VkExtent2D &GetExtent2D() = 0;
+    virtual std::vector<VkImageView> &GetImageViews() = 0;
+    virtual uint32_t GetNumberOfImages() const = 0;
+
+    /**
+     * @brief Layout the images have to be in once rendering finished.
+     */
+    virtual VkImageLayout GetFinalLayout() const = 0;
+};
@@ -3,16 +3,21 @@
 #include <vulkan/vulkan.h>
 
 #include <array>
+#include <cstring>
 #include <fstream>
 #include <glm/glm.hpp>
 #include <iostream>
+#include <limits>
+
+#include "DeviceContext.h"
+#include "MeshBuffer.h"
+#include "MeshOptimizer.h"
+#include "ObjParser.h"
+#include "Texture.h"
 
 #define STB_IMAGE_IMPLEMENTATION // define this in only *one* .cc
 #include <stb_image.h>
 
-#define TINYOBJLOADER_IMPLEMENTATION // define this in only *one* .cc
-#include <tiny_obj_loader.h>
-
 namespace {
 VkVertexInputBindingDescription getBindingDescription(uint32_t vertexSize) {
     VkVertexInputBindingDescription bindingDescription{};
@@ -34,7 +39,7 @@ std::vector<VkVertexInputAttributeDescription> getAttributeDescription(bool hasN
         rAttribute.location = location++;
         rAttribute.format = VK_FORMAT_R32G32B32_SFLOAT;
         rAttribute.offset = offset;
-        offset += 24;  // 3 * 32bit floats
+        offset += 12;  // 3 * 32bit floats
     }
 
     if (hasNormals) {
@@ -43,7 +48,7 @@ std::vector<VkVertexInputAttributeDescription> getAttributeDescription(bool hasN
         rAttribute.location = location++;
         rAttribute.format = VK_FORMAT_R32G32B32_SFLOAT;
         rAttribute.offset = offset;
-        offset += 24;  // 3 * 32bit floats
+        offset += 12;  // 3 * 32bit floats
     }
 
     if (hasTexCoords) {
@@ -52,51 +57,24 @@ std::vector<VkVertexInputAttributeDescription> getAttributeDescription(bool hasN
         rAttribute.location = location++;
         rAttribute.format = VK_FORMAT_R32G32_SFLOAT;
         rAttribute.offset = offset;
-        offset += 16;  // 2 * 32bit floats
+        offset += 8;   // 2 * 32bit floats
     }
     return attributeDescriptions;
 }
 
-uint32_t findMemoryType(VkPhysicalDevice &physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-            return i;
-        }
+VkFormat toVkFormat(ImageFormat format) {
+    switch (format) {
+        case ImageFormat::r8g8b8a8_srgb:
+            return VK_FORMAT_R8G8B8A8_SRGB;
     }
-    throw std::runtime_error("failed to find suitable memory type!");
-}
-
-void createBuffer(VkDevice &device, VkPhysicalDevice &physicalDevice, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
-                  VkBuffer &buffer, VkDeviceMemory &bufferMemory) {
-    VkBufferCreateInfo bufferInfo{};
-    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    bufferInfo.size = size;
-    bufferInfo.usage = usage;
-    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-    if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create buffer!");
-    }
-
-    VkMemoryRequirements memRequirements;
-    vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
-
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(physicalDevice, memRequirements.memoryTypeBits, properties);
-
-    if (vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate buffer memory!");
-    }
-
-    vkBindBufferMemory(device, buffer, bufferMemory, 0);
+    throw std::runtime_error("unsupported image format!");
 }
 
 }  // namespace
 
+ResourceManager::ResourceManager(DeviceContext &rDeviceContext)
+    : rDeviceContext_(rDeviceContext), meshCache_("cache/meshes"), assetLoader_(*this) {}
+
 std::vector<char> ResourceManager::ReadBinaryFile(const std::filesystem::path &rFilePath) {
     std::ifstream file(rFilePath, std::ios::ate | std::ios::binary);
 
@@ -114,94 +92,121 @@ std::vector<char> ResourceManager::ReadBinaryFile(const std::filesystem::path &r
 }
 
 std::shared_ptr<VertexData> ResourceManager::LoadVertexDataFromObjFile(const std::filesystem::path &rFilePath) {
-    tinyobj::attrib_t attrib;
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-    std::string err;
-    bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &err, rFilePath.string().c_str(), nullptr, true);
-
-    if (!ret || !err.empty()) {
-        throw std::runtime_error("tinyobjloader error: " + err);
-    }
-
-    if (shapes.empty()) {
-        // Get vertex definition of first vertex
-        return std::make_shared<VertexData>();
-    }
-
-    tinyobj::index_t first = shapes.front().mesh.indices.front();
-    bool hasNormals = (first.normal_index >= 0);
-    bool hasTexCoords = (first.texcoord_index >= 0);
-    uint32_t vertexSize = 3 * sizeof(float);
-    if (hasNormals) {
-        vertexSize += 3 * sizeof(float);
-    }
-    if (hasTexCoords) {
-        vertexSize += 2 * sizeof(float);
-    }
+    ObjMesh mesh = ObjParser::Parse(rFilePath);
 
-    size_t containerSize = 0;
-    for (const tinyobj::shape_t &rShape : shapes) {
-        containerSize += rShape.mesh.num_face_vertices.size() * vertexSize;
+    auto spVertexData = std::make_shared<VertexData>();
+    if (mesh.indices.empty()) {
+        return spVertexData;
     }
 
-    auto spVertexData = std::make_shared<VertexData>();
+    const uint32_t vertexSize = mesh.vertexSize;
+    const size_t cornerCount = mesh.indices.size();
     std::vector<unsigned char> &container = spVertexData->vertexBuffer;
-    container.reserve(containerSize);
-
-    // Loop over shapes and combine them into one object
-    for (const tinyobj::shape_t &rShape : shapes) {
-        // Loop over faces
-        uint32_t offset = 0;
-        for (size_t numVertices = 0; numVertices < rShape.mesh.num_face_vertices.size(); numVertices++) {
-            // Loop over vertices in the face.
-            for (size_t v = 0; v < numVertices; v++) {
-                tinyobj::index_t idx = rShape.mesh.indices[offset++];
-
-                if (hasNormals != (idx.normal_index >= 0)) {
-                    throw std::runtime_error("tinyobjloader: normal data not consistent!");
-                }
-                if (hasTexCoords != (idx.texcoord_index >= 0)) {
-                    throw std::runtime_error("tinyobjloader: tex coords data not consistent!");
-                }
-
-                uint32_t vertexOffset = 0;
-                std::memcpy(&container[offset * vertexSize],
-                            &attrib.vertices[static_cast<size_t>(idx.vertex_index) * 3], 3 * sizeof(float));
-                vertexOffset += 3 * sizeof(float);
-
-                if (hasNormals) {
-                    std::memcpy(&container[offset * vertexSize + vertexOffset],
-                                &attrib.normals[static_cast<size_t>(idx.normal_index) * 3], 3 * sizeof(float));
-                    vertexOffset += 3 * sizeof(float);
-                }
-                if (hasTexCoords) {
-                    std::memcpy(&container[offset * vertexSize + vertexOffset],
-                                &attrib.texcoords[static_cast<size_t>(idx.texcoord_index) * 2], 2 * sizeof(float));
-                }
-            }
+    container = std::move(mesh.vertices);
+    std::vector<uint32_t> &indices = mesh.indices;
+
+    uint32_t vertexCount = static_cast<uint32_t>(container.size() / vertexSize);
+    float acmrBefore = MeshOptimizer::CalculateACMR(indices, vertexCount);
+
+    MeshOptimizer::OptimizeVertexCache(indices, vertexCount);
+    vertexCount = MeshOptimizer::OptimizeVertexFetch(indices, container, vertexSize);
+    float acmrAfter = MeshOptimizer::CalculateACMR(indices, vertexCount);
+
+    std::cout << "Loaded " << rFilePath.filename().string() << ": " << indices.size() / 3 << " triangles, "
+              << vertexCount << " vertices (" << cornerCount << " unindexed), ACMR " << acmrBefore << " -> "
+              << acmrAfter << std::endl;
+
+    // 16 bit indices halve index memory and bandwidth if possible
+    if (vertexCount <= std::numeric_limits<uint16_t>::max()) {
+        spVertexData->indexType = VK_INDEX_TYPE_UINT16;
+        spVertexData->indexBuffer.resize(indices.size() * sizeof(uint16_t));
+        auto *pIndices = reinterpret_cast<uint16_t *>(spVertexData->indexBuffer.data());
+        for (size_t i = 0; i < indices.size(); i++) {
+            pIndices[i] = static_cast<uint16_t>(indices[i]);
         }
+    } else {
+        spVertexData->indexType = VK_INDEX_TYPE_UINT32;
+        spVertexData->indexBuffer.resize(indices.size() * sizeof(uint32_t));
+        std::memcpy(spVertexData->indexBuffer.data(), indices.data(), spVertexData->indexBuffer.size());
     }
 
     spVertexData->inputBindingDescription = getBindingDescription(vertexSize);
-    spVertexData->attributeDescriptions = getAttributeDescription(hasNormals, hasTexCoords);
+    spVertexData->attributeDescriptions = getAttributeDescription(mesh.hasNormals, mesh.hasTexCoords);
+    return spVertexData;
+}
+
+std::shared_ptr<VertexData> ResourceManager::LoadVertexData(const std::filesystem::path &rFilePath) {
+    uint64_t sourceHash = MeshCache::HashFile(rFilePath);
+    std::shared_ptr<VertexData> spVertexData = meshCache_.Load(sourceHash);
+    if (spVertexData != nullptr) {
+        return spVertexData;
+    }
+
+    spVertexData = LoadVertexDataFromObjFile(rFilePath);
+    try {
+        meshCache_.Store(sourceHash, *spVertexData);
+    } catch (const std::exception &rException) {
+        // Not fatal, mesh is parsed again next time
+        std::cerr << "Failed to cache mesh " << rFilePath.string() << ": " << rException.what() << std::endl;
+    }
     return spVertexData;
 }
 
 std::shared_ptr<ImageData> ResourceManager::LoadImageDataFromFile(const std::filesystem::path &rFilePath) {
     int texWidth, texHeight, texChannels;
-    stbi_uc* pixels = stbi_load(rFilePath.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb); // STBI_rgb_alpha
+    // Always load 4 channels, 3 channel formats are rarely supported for optimal tiled images
+    stbi_uc* pixels = stbi_load(rFilePath.string().c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
 
     if (!pixels) {
         throw std::runtime_error("failed to load texture image!");
     }
 
-    size_t length = texWidth * texHeight * texChannels;
+    size_t length = static_cast<size_t>(texWidth) * texHeight * 4;
 
-    std::vector<unsigned char> data;
-    data.reserve(length);
+    std::vector<unsigned char> data(length);
     std::memcpy(data.data(), pixels, length);
     stbi_image_free(pixels);
 
-    return std::make_shared<ImageData>(static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), ImageFormat::r8g8b8_srgb, std::move(data));
+    return std::make_shared<ImageData>(static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), ImageFormat::r8g8b8a8_srgb, std::move(data));
+}
+
+std::shared_ptr<Texture> ResourceManager::GetTexture(const std::string &rTextureId) {
+    auto it = textures_.find(rTextureId);
+    if (it == textures_.end()) {
+        return nullptr;
+    }
+    return it->second.lock();
+}
+
+std::shared_ptr<Texture> ResourceManager::CreateTexture(const std::string &rTextureId, const ImageData &rImageData) {
+    auto spTexture = std::make_shared<Texture>(rDeviceContext_, VkExtent2D{rImageData.width_, rImageData.height_},
+                                               toVkFormat(rImageData.format_));
+    spTexture->uploadTicket_ = rDeviceContext_.GetUploadManager().UploadImage(
+        rImageData.data_, spTexture->image_, VkExtent3D{rImageData.width_, rImageData.height_, 1});
+
+    textures_[rTextureId] = spTexture;
+    return spTexture;
+}
+
+std::shared_ptr<MeshBuffer> ResourceManager::CreateVertexDataBuffer(const VertexData &rVertexData) {
+    std::span<const unsigned char> vertexBuffer = rVertexData.GetVertexBuffer();
+    std::span<const unsigned char> indexBuffer = rVertexData.GetIndexBuffer();
+    if (vertexBuffer.empty()) {
+        throw std::runtime_error("vertex data is empty!");
+    }
+
+    auto spMeshBuffer = std::make_shared<MeshBuffer>(rDeviceContext_, vertexBuffer.size(), indexBuffer.size());
+    spMeshBuffer->vertexCount_ = static_cast<uint32_t>(vertexBuffer.size() / rVertexData.inputBindingDescription.stride);
+
+    // Copy goes through the staging ring and is submitted with all other uploads of this frame
+    UploadManager &rUploadManager = rDeviceContext_.GetUploadManager();
+    spMeshBuffer->uploadTicket_ = rUploadManager.UploadBuffer(vertexBuffer, spMeshBuffer->vertexBuffer_);
+
+    if (!indexBuffer.empty()) {
+        spMeshBuffer->indexType_ = rVertexData.indexType;
+        spMeshBuffer->indexCount_ = rVertexData.GetIndexCount();
+        // Tickets complete in order, so the later one covers both uploads
+        spMeshBuffer->uploadTicket_ = rUploadManager.UploadBuffer(indexBuffer, spMeshBuffer->indexBuffer_);
+    }
+    return spMeshBuffer;
 }
@@ -2,22 +2,56 @@
 
 
 #include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include "VertexData.h"
 #include "ImageData.h"
+#include "AssetLoader.h"
+#include "MeshCache.h"
+
+class DeviceContext;
+class MeshBuffer;
+class Texture;
 
 class ResourceManager {
 public:
+    explicit ResourceManager(DeviceContext &rDeviceContext);
+
     static std::vector<char> ReadBinaryFile(const std::filesystem::path &rFilePath);
     static std::shared_ptr<VertexData> LoadVertexDataFromObjFile(const std::filesystem::path &rFilePath);
     static std::shared_ptr<ImageData> LoadImageDataFromFile(const std::filesystem::path &rFilePath);
 
-    struct STextureHandle {
-        uint32_t test;
-    };
+    /**
+     * @brief Loads mesh from the binary mesh cache, parses and caches the OBJ file if its content is not cached yet.
+     */
+    std::shared_ptr<VertexData> LoadVertexData(const std::filesystem::path &rFilePath);
+
+    /**
+     * @brief Background loading of files, meshes and images. Loader functions of this class are thread safe.
+     */
+    AssetLoader &GetAssetLoader() { return assetLoader_; }
+
+    /**
+     * @brief Returns texture created with this id if it is still alive, nullptr otherwise.
+     */
+    std::shared_ptr<Texture> GetTexture(const std::string &rTextureId);
+
+    /**
+     * @brief Creates device local texture, upload happens asynchronously (see Texture::IsReady).
+     */
+    std::shared_ptr<Texture> CreateTexture(const std::string &rTextureId, const ImageData &rImageData);
 
-    std::shared_ptr<STextureHandle> GetTexture(const std::string &rTextureId);
-    std::shared_ptr<STextureHandle> CreateTexture(const std::string &rTextureId);
+    /**
+     * @brief Creates device local vertex buffer, upload happens asynchronously (see MeshBuffer::IsReady).
+     */
+    std::shared_ptr<MeshBuffer> CreateVertexDataBuffer(const VertexData &rVertexData);
 
-    void CreateVertexDataBuffer(const VertexData &rVertexData);
+private:
+    DeviceContext &rDeviceContext_;
+    MeshCache meshCache_;
+    // Destroyed first, so running loads finish before the cache goes away
+    AssetLoader assetLoader_;
+    std::unordered_map<std::string, std::weak_ptr<Texture>> textures_;
 };
@@ -1,24 +1,561 @@
 #include "Scene.h"
 
-void Scene::AddObject(std::unique_ptr<Object> &&rrObject) { objects_.push_back(std::move(rrObject)); }
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
 
-void Scene::RemoveObject(const Object &rObject) {
-    auto it = std::find_if(objects_.begin(), objects_.end(),
-                           [&rObject](const std::unique_ptr<Object> &rObj) { return rObj.get() == &rObject; });
+#include "FrameContext.h"
+#include "GpuCuller.h"
+#include "GraphicsPipeline.h"
+#include "MeshBuffer.h"
+#include "RenderContext.h"
+#include "ResourceManager.h"
+#include "VertexData.h"
+#include "materials/Material.h"
 
-    if (it != objects_.end()) {
-        objects_.erase(it);
+namespace {
+// Up to this many objects a SIMD test of every object is faster than walking the tree
+const size_t LINEAR_CULL_MAX_OBJECTS = 4096;
+
+bool sphereIntersects(const Frustum &rFrustum, const Bounds &rBounds) {
+    for (const glm::vec4 &rPlane : rFrustum.GetPlanes()) {
+        if (rPlane.x * rBounds.center.x + rPlane.y * rBounds.center.y + rPlane.z * rBounds.center.z + rPlane.w <
+            -rBounds.radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Box around the positions (location 0, three floats) and a sphere around the box center enclosing all
+ * positions, it is usually tighter than the sphere around the box. Infinite if the layout has no such positions.
+ */
+Bounds computeBounds(const VertexData &rVertexData) {
+    auto it = std::find_if(rVertexData.attributeDescriptions.begin(), rVertexData.attributeDescriptions.end(),
+                           [](const VkVertexInputAttributeDescription &rAttribute) {
+                               return rAttribute.location == 0 && rAttribute.format == VK_FORMAT_R32G32B32_SFLOAT;
+                           });
+    std::span<const unsigned char> vertexBuffer = rVertexData.GetVertexBuffer();
+    const uint32_t stride = rVertexData.inputBindingDescription.stride;
+    if (it == rVertexData.attributeDescriptions.end() || stride == 0 || vertexBuffer.size() < stride) {
+        return Bounds::Infinite();
+    }
+
+    const size_t vertexCount = vertexBuffer.size() / stride;
+    auto position = [&](size_t vertex) {
+        float xyz[3];
+        std::memcpy(xyz, vertexBuffer.data() + vertex * stride + it->offset, sizeof(xyz));
+        return glm::vec3(xyz[0], xyz[1], xyz[2]);
+    };
+
+    Bounds bounds{position(0), position(0), glm::vec3(0.0f), 0.0f};
+    for (size_t i = 1; i < vertexCount; i++) {
+        bounds.min = glm::min(bounds.min, position(i));
+        bounds.max = glm::max(bounds.max, position(i));
+    }
+    bounds.center = (bounds.min + bounds.max) * 0.5f;
+
+    float radiusSquared = 0.0f;
+    for (size_t i = 0; i < vertexCount; i++) {
+        glm::vec3 offset = position(i) - bounds.center;
+        radiusSquared = std::max(radiusSquared, offset.x * offset.x + offset.y * offset.y + offset.z * offset.z);
+    }
+    bounds.radius = std::sqrt(radiusSquared);
+    return bounds;
+}
+
+/// Moves the last element into index, like the SlotMap does with the entities
+template <typename T>
+void swapRemove(std::vector<T> &rValues, uint32_t index) {
+    if (index + 1 != rValues.size()) {
+        rValues[index] = std::move(rValues.back());
+    }
+    rValues.pop_back();
+}
+
+/**
+ * @brief Ids are unique, so owner and mesh buffer fit into one exact key. Bindless materials only differ in the
+ * material index of their instances, so all of them with one pipeline share a batch. The top bit keeps pipeline and
+ * material ids apart.
+ */
+uint64_t batchKey(const Material &rMaterial, const GraphicsPipeline &rPipeline, const MeshBuffer &rMeshBuffer) {
+    const uint64_t owner = rMaterial.GetBindlessIndex() != Material::INVALID_BINDLESS_INDEX
+                               ? (1ull << 31 | rPipeline.GetId())
+                               : rMaterial.GetId();
+    return owner << 32 | rMeshBuffer.GetId();
+}
+}  // namespace
+
+MeshObject Scene::CreateMeshObject() {
+    const uint32_t index = static_cast<uint32_t>(entities_.GetSize());
+    const ObjectHandle handle = entities_.Insert(Entity{});
+    bounds_.Add(Bounds::Infinite());
+    transforms_.push_back(glm::mat4(1.0f));
+    meshes_.emplace_back();
+    materials_.emplace_back();
+    drawItems_.emplace_back();
+    addUnbounded(index);
+    if (spGpuCuller_ != nullptr) {
+        spGpuCuller_->Add(glm::mat4(1.0f), Bounds::Infinite());
+    }
+
+    // Not culled yet, visible until the next Cull
+    if (culled_) {
+        visible_.push_back(index);
     }
+    return MeshObject(*this, handle);
+}
+
+bool Scene::RemoveObject(ObjectHandle handle) {
+    if (!entities_.Contains(handle)) {
+        return false;
+    }
+
+    const uint32_t index = entities_.GetIndex(handle);
+    if (entities_[index].leaf != Bvh::INVALID_NODE) {
+        bvh_.Remove(entities_[index].leaf);
+    } else {
+        removeUnbounded(index);
+    }
+    setMaterial(index, nullptr);
+    if (meshes_[index].spMeshBuffer != nullptr) {
+        retired_.push_back(std::move(meshes_[index].spMeshBuffer));
+    }
+
+    // The slot map moves the last object into the hole, all components follow
+    const uint32_t last = static_cast<uint32_t>(entities_.GetSize()) - 1;
+    entities_.Remove(handle);
+    bounds_.Remove(index);
+    swapRemove(transforms_, index);
+    swapRemove(meshes_, index);
+    swapRemove(materials_, index);
+    swapRemove(drawItems_, index);
+    if (spGpuCuller_ != nullptr) {
+        spGpuCuller_->Remove(index);
+    }
+    if (index != last) {
+        const Entity &rMoved = entities_[index];
+        if (rMoved.leaf != Bvh::INVALID_NODE) {
+            bvh_.SetUserData(rMoved.leaf, index);
+        } else {
+            unbounded_[rMoved.unboundedPosition] = index;
+        }
+    }
+
+    // Visibility indices are stale, draw everything until the next Cull
+    culled_ = false;
+    visible_.clear();
+    return true;
+}
+
+MeshObject Scene::FindObject(ObjectHandle handle) {
+    return entities_.Contains(handle) ? MeshObject(*this, handle) : MeshObject();
+}
+
+void Scene::SetGpuCulling(bool enabled) {
+    if (enabled == (spGpuCuller_ != nullptr)) {
+        return;
+    }
+    if (!enabled) {
+        // Frames in flight may still read its buffers
+        retired_.push_back(std::move(spGpuCuller_));
+        return;
+    }
+
+    spGpuCuller_ = std::make_shared<GpuCuller>();
+    for (uint32_t index = 0; index < entities_.GetSize(); index++) {
+        spGpuCuller_->Add(transforms_[index], bounds_.Get(index));
+        spGpuCuller_->SetDrawItem(index, drawItems_[index].pMaterial, drawItems_[index].pMeshBuffer);
+    }
+}
+
+void Scene::Cull(const Frustum &rFrustum) {
+    // Links objects whose bounds became known, or rebuilds if much changed
+    bvh_.Optimize();
+
+    // Most of the tree is visited if most objects were visible, the view rarely changes that much between frames
+    const bool mostlyVisible = culled_ && 2 * visible_.size() > entities_.GetSize();
+    visible_.clear();
+    if (spGpuCuller_ != nullptr) {
+        // Culled on the GPU while drawing, the CPU path only runs until the culling shader is loaded
+        frustum_ = rFrustum;
+        culled_ = false;
+        return;
+    }
+
+    queryFrustum(rFrustum, visible_, mostlyVisible);
+    culled_ = true;
 }
 
 void Scene::Update(const RenderContext &rContext) {
-    for (auto &rspObject : objects_) {
-        rspObject->Update(rContext);
+    for (std::shared_ptr<const void> &rspRetired : retired_) {
+        rContext.frameContext.Retain(std::move(rspRetired));
+    }
+    retired_.clear();
+
+    updateMeshes(rContext);
+    for (auto &[pMaterial, rUsage] : materialUsages_) {
+        rUsage.spMaterial->Update(rContext);
     }
 }
 
-void Scene::Draw(const RenderContext &rContext) {
-    for (auto &rspObject : objects_) {
-        rspObject->Draw(rContext);
+void Scene::Draw(const RenderContext &rContext, RenderQueue &rQueue) {
+    rQueue.Clear();
+    if (rContext.drawMode != DrawMode::Instanced) {
+        drawPerObject(rContext, rQueue);
+        rQueue.Sort();
+        return;
+    }
+    if (spGpuCuller_ != nullptr && spGpuCuller_->Record(rContext, frustum_, rQueue)) {
+        rQueue.Sort();
+        return;
+    }
+    batches_.clear();
+    batchLookup_.clear();
+    instances_.clear();
+
+    // Objects sharing material and mesh are mostly visited in a row, so state is only looked up when it changes
+    Material *pMaterial = nullptr;
+    GraphicsPipeline *pPipeline = nullptr;
+    uint32_t materialIndex = Material::INVALID_BINDLESS_INDEX;
+    const MeshBuffer *pMeshBuffer = nullptr;
+    uint32_t batch = 0;
+    auto collect = [&](uint32_t index) {
+        const DrawItem &rItem = drawItems_[index];
+        if (rItem.pMaterial == nullptr || rItem.pMeshBuffer == nullptr) {
+            return;
+        }
+        if (rItem.pMaterial != pMaterial) {
+            pMaterial = rItem.pMaterial;
+            pPipeline = pMaterial->IsReady() ? &pMaterial->GetPipeline() : nullptr;
+            materialIndex = pMaterial->GetBindlessIndex();
+            pMeshBuffer = nullptr;
+        }
+        if (pPipeline == nullptr) {
+            return;
+        }
+
+        if (rItem.pMeshBuffer != pMeshBuffer) {
+            pMeshBuffer = rItem.pMeshBuffer;
+            const uint64_t key = batchKey(*pMaterial, *pPipeline, *pMeshBuffer);
+            auto [it, inserted] = batchLookup_.try_emplace(key, static_cast<uint32_t>(batches_.size()));
+            if (inserted) {
+                batches_.push_back(Batch{pMaterial, pPipeline, pMeshBuffer});
+            }
+            batch = it->second;
+        }
+        Batch &rBatch = batches_[batch];
+        rBatch.instanceCount++;
+        const Bounds bounds = bounds_.Get(index);
+        if (bounds.IsFinite()) {
+            rBatch.centerSum += bounds.center;
+            rBatch.finiteCount++;
+        }
+        instances_.push_back(Instance{index, batch, materialIndex});
+    };
+
+    if (culled_) {
+        for (uint32_t index : visible_) {
+            collect(index);
+        }
+    } else {
+        for (uint32_t index = 0; index < drawItems_.size(); index++) {
+            collect(index);
+        }
+    }
+    if (instances_.empty()) {
+        return;
+    }
+
+    // Counting sort of the instance data by batch, then one copy into the mapped instance buffer
+    uint32_t firstInstance = 0;
+    for (Batch &rBatch : batches_) {
+        rBatch.firstInstance = firstInstance;
+        firstInstance += rBatch.instanceCount;
+        rBatch.instanceCount = 0;
+    }
+    instanceData_.resize(instances_.size());
+    for (const Instance &rInstance : instances_) {
+        Batch &rBatch = batches_[rInstance.batch];
+        InstanceData &rInstanceData = instanceData_[rBatch.firstInstance + rBatch.instanceCount++];
+        rInstanceData.transform = transforms_[rInstance.object];
+        rInstanceData.materialIndex = rInstance.materialIndex;
+    }
+    const VkDeviceSize instanceDataSize = instanceData_.size() * sizeof(InstanceData);
+    FrameContext::BufferRange range = rContext.frameContext.AllocateInstanceData(instanceDataSize);
+    std::memcpy(range.pData, instanceData_.data(), instanceDataSize);
+
+    for (const Batch &rBatch : batches_) {
+        const float depth =
+            rBatch.finiteCount > 0
+                ? RenderQueue::ViewDepth(rContext.viewProjection,
+                                         rBatch.centerSum / static_cast<float>(rBatch.finiteCount))
+                : 0.0f;
+        uint64_t sortKey = RenderQueue::MakeSortKey(RenderQueue::Pass::Opaque, rBatch.pPipeline->GetId(),
+                                                    rBatch.pMaterial->GetId(), rBatch.pMeshBuffer->GetId(), depth);
+        DrawPacket packet{rBatch.pPipeline, rBatch.pMaterial, rBatch.pMeshBuffer, range.buffer,
+                          range.offset, rBatch.firstInstance, rBatch.instanceCount};
+        packet.uniformSet = rContext.frameUniforms.descriptorSet;
+        packet.uniformOffset = rContext.frameUniforms.offset;
+        rQueue.Push(sortKey, packet);
+    }
+    rQueue.Sort();
+}
+
+void Scene::QueryFrustum(const Frustum &rFrustum, std::vector<ObjectHandle> &rObjects) const {
+    std::vector<uint32_t> indices;
+    queryFrustum(rFrustum, indices, false);
+    for (uint32_t index : indices) {
+        rObjects.push_back(entities_.GetHandle(index));
+    }
+}
+
+void Scene::QuerySphere(const glm::vec3 &rCenter, float radius, std::vector<ObjectHandle> &rObjects) const {
+    std::vector<uint32_t> indices;
+    bvh_.QuerySphere(rCenter, radius, indices);
+    for (uint32_t index : indices) {
+        rObjects.push_back(entities_.GetHandle(index));
+    }
+}
+
+Scene::ObjectHandle Scene::Raycast(const glm::vec3 &rOrigin, const glm::vec3 &rDirection, float maxDistance) const {
+    uint32_t index;
+    float distance;
+    if (!bvh_.Raycast(rOrigin, rDirection, maxDistance, index, distance)) {
+        return ObjectHandle{};
+    }
+    return entities_.GetHandle(index);
+}
+
+uint32_t Scene::indexOf(ObjectHandle handle) const {
+    if (!entities_.Contains(handle)) {
+        throw std::runtime_error("failed to access object, it was removed!");
+    }
+    return entities_.GetIndex(handle);
+}
+
+void Scene::setMaterial(uint32_t index, const std::shared_ptr<Material> &rMaterial) {
+    std::shared_ptr<Material> &rspCurrent = materials_[index];
+    if (rspCurrent == rMaterial) {
+        return;
+    }
+
+    if (rspCurrent != nullptr) {
+        auto it = materialUsages_.find(rspCurrent.get());
+        if (--it->second.objectCount == 0) {
+            materialUsages_.erase(it);
+        }
+        retired_.push_back(std::move(rspCurrent));
+    }
+
+    rspCurrent = rMaterial;
+    setDrawItem(index, rMaterial.get(), drawItems_[index].pMeshBuffer);
+    if (rMaterial != nullptr) {
+        MaterialUsage &rUsage = materialUsages_[rMaterial.get()];
+        rUsage.spMaterial = rMaterial;
+        rUsage.objectCount++;
+        if (meshes_[index].spVertexData != nullptr) {
+            rMaterial->SetVertexLayout(*meshes_[index].spVertexData);
+        }
+    }
+}
+
+void Scene::setVertexData(ObjectHandle handle, const std::shared_ptr<VertexData> &rVertexData,
+                          const AssetHandle<VertexData> &rVertexDataHandle) {
+    const uint32_t index = indexOf(handle);
+    Mesh &rMesh = meshes_[index];
+    if (rMesh.spMeshBuffer != nullptr) {
+        retired_.push_back(std::move(rMesh.spMeshBuffer));
+    }
+    rMesh.spMeshBuffer = nullptr;
+    rMesh.spVertexData = rVertexData;
+    rMesh.vertexDataHandle = rVertexDataHandle;
+    rMesh.localBounds = Bounds::Infinite();
+    setDrawItem(index, drawItems_[index].pMaterial, nullptr);
+    // Visible until the new extent is known
+    setBounds(index, Bounds::Infinite());
+
+    if (!rMesh.pending) {
+        rMesh.pending = true;
+        pendingMeshes_.push_back(handle);
+    }
+}
+
+void Scene::setTransform(uint32_t index, const glm::mat4 &rTransform) {
+    transforms_[index] = rTransform;
+    if (spGpuCuller_ != nullptr) {
+        spGpuCuller_->SetTransform(index, rTransform);
+    }
+    if (meshes_[index].localBounds.IsFinite()) {
+        setBounds(index, meshes_[index].localBounds.Transformed(rTransform));
+    }
+}
+
+void Scene::setBounds(uint32_t index, const Bounds &rBounds) {
+    bounds_.Set(index, rBounds);
+    if (spGpuCuller_ != nullptr) {
+        spGpuCuller_->SetBounds(index, rBounds);
+    }
+
+    Entity &rEntity = entities_[index];
+    if (rBounds.IsFinite()) {
+        if (rEntity.leaf == Bvh::INVALID_NODE) {
+            removeUnbounded(index);
+            rEntity.leaf = bvh_.Insert(Bvh::Aabb{rBounds.min, rBounds.max}, index);
+        } else {
+            bvh_.Update(rEntity.leaf, Bvh::Aabb{rBounds.min, rBounds.max});
+        }
+    } else if (rEntity.leaf != Bvh::INVALID_NODE) {
+        bvh_.Remove(rEntity.leaf);
+        rEntity.leaf = Bvh::INVALID_NODE;
+        addUnbounded(index);
+    }
+}
+
+void Scene::setDrawItem(uint32_t index, Material *pMaterial, const MeshBuffer *pMeshBuffer) {
+    drawItems_[index] = DrawItem{pMaterial, pMeshBuffer};
+    if (spGpuCuller_ != nullptr) {
+        spGpuCuller_->SetDrawItem(index, pMaterial, pMeshBuffer);
+    }
+}
+
+void Scene::updateMeshes(const RenderContext &rContext) {
+    size_t stillPending = 0;
+    for (size_t i = 0; i < pendingMeshes_.size(); i++) {
+        const ObjectHandle handle = pendingMeshes_[i];
+        if (!entities_.Contains(handle)) {
+            continue;
+        }
+        const uint32_t index = entities_.GetIndex(handle);
+        Mesh &rMesh = meshes_[index];
+
+        if (rMesh.vertexDataHandle.IsReady()) {
+            rMesh.spVertexData = rMesh.vertexDataHandle.Get();
+            rMesh.vertexDataHandle.Reset();
+        }
+
+        if (rMesh.spVertexData != nullptr && rMesh.spMeshBuffer == nullptr) {
+            acquireMeshBuffer(rContext, rMesh);
+            setBounds(index, rMesh.localBounds.Transformed(transforms_[index]));
+            if (materials_[index] != nullptr) {
+                materials_[index]->SetVertexLayout(*rMesh.spVertexData);
+            }
+        }
+
+        const bool uploaded = rMesh.spMeshBuffer != nullptr && rMesh.spMeshBuffer->IsReady();
+        if (uploaded) {
+            setDrawItem(index, drawItems_[index].pMaterial, rMesh.spMeshBuffer.get());
+        }
+        if (uploaded || (rMesh.spMeshBuffer == nullptr && !rMesh.vertexDataHandle.IsValid())) {
+            // Drawable, or there is nothing to wait for
+            rMesh.pending = false;
+            continue;
+        }
+        pendingMeshes_[stillPending++] = handle;
+    }
+    pendingMeshes_.resize(stillPending);
+}
+
+void Scene::acquireMeshBuffer(const RenderContext &rContext, Mesh &rMesh) {
+    SharedMesh &rSharedMesh = sharedMeshes_[rMesh.spVertexData.get()];
+    std::shared_ptr<MeshBuffer> spMeshBuffer = rSharedMesh.wpMeshBuffer.lock();
+    // Freed vertex data may leave its address to new data, only buffers of the very same data are shared
+    if (spMeshBuffer != nullptr && rSharedMesh.wpVertexData.lock() == rMesh.spVertexData) {
+        rMesh.spMeshBuffer = std::move(spMeshBuffer);
+        rMesh.localBounds = rSharedMesh.localBounds;
+        return;
+    }
+
+    // Upload is batched with all others of this frame
+    rMesh.spMeshBuffer = rContext.deviceContext.GetResourceManager().CreateVertexDataBuffer(*rMesh.spVertexData);
+    rMesh.localBounds = computeBounds(*rMesh.spVertexData);
+    rSharedMesh = SharedMesh{rMesh.spVertexData, rMesh.spMeshBuffer, rMesh.localBounds};
+
+    if (sharedMeshes_.size() > sharedMeshPruneSize_) {
+        std::erase_if(sharedMeshes_, [](const auto &rEntry) { return rEntry.second.wpMeshBuffer.expired(); });
+        sharedMeshPruneSize_ = 2 * sharedMeshes_.size() + 64;
+    }
+}
+
+void Scene::addUnbounded(uint32_t index) {
+    entities_[index].unboundedPosition = static_cast<uint32_t>(unbounded_.size());
+    unbounded_.push_back(index);
+}
+
+void Scene::removeUnbounded(uint32_t index) {
+    const uint32_t position = entities_[index].unboundedPosition;
+    unbounded_[position] = unbounded_.back();
+    entities_[unbounded_[position]].unboundedPosition = position;
+    unbounded_.pop_back();
+    entities_[index].unboundedPosition = INVALID_POSITION;
+}
+
+void Scene::queryFrustum(const Frustum &rFrustum, std::vector<uint32_t> &rIndices, bool mostlyVisible) const {
+    if (mostlyVisible || bounds_.GetSize() <= LINEAR_CULL_MAX_OBJECTS) {
+        // Little of the scene can be skipped, infinite bounds always pass
+        bounds_.Cull(rFrustum, rIndices);
+        return;
+    }
+
+    // The tree only knows boxes, candidates are tested against the spheres as well
+    rIndices.clear();
+    bvh_.QueryFrustum(rFrustum, rIndices);
+    auto end = std::remove_if(rIndices.begin(), rIndices.end(), [&](uint32_t index) {
+        return !sphereIntersects(rFrustum, bounds_.Get(index));
+    });
+    rIndices.erase(end, rIndices.end());
+    rIndices.insert(rIndices.end(), unbounded_.begin(), unbounded_.end());
+}
+
+void Scene::drawPerObject(const RenderContext &rContext, RenderQueue &rQueue) {
+    instances_.clear();
+    auto collect = [&](uint32_t index) {
+        const DrawItem &rItem = drawItems_[index];
+        if (rItem.pMaterial != nullptr && rItem.pMeshBuffer != nullptr && rItem.pMaterial->IsReady()) {
+            instances_.push_back(Instance{index, 0, rItem.pMaterial->GetBindlessIndex()});
+        }
+    };
+    if (culled_) {
+        for (uint32_t index : visible_) {
+            collect(index);
+        }
+    } else {
+        for (uint32_t index = 0; index < drawItems_.size(); index++) {
+            collect(index);
+        }
+    }
+
+    // Sized up front, packets point into it
+    drawConstants_.resize(instances_.size());
+    for (size_t i = 0; i < instances_.size(); i++) {
+        const Instance &rInstance = instances_[i];
+        const DrawItem &rItem = drawItems_[rInstance.object];
+        DrawConstants &rConstants = drawConstants_[i];
+        rConstants.transform = transforms_[rInstance.object];
+        rConstants.objectIndex = rInstance.object;
+        rConstants.materialIndex = rInstance.materialIndex;
+
+        DrawPacket packet{&rItem.pMaterial->GetPipeline(), rItem.pMaterial, rItem.pMeshBuffer};
+        if (rContext.drawMode == DrawMode::PushConstants) {
+            packet.uniformSet = rContext.frameUniforms.descriptorSet;
+            packet.uniformOffset = rContext.frameUniforms.offset;
+            packet.pConstants = &rConstants;
+        } else {
+            // One slice per draw, consecutive draws only differ in the dynamic offset of the uniform set
+            FrameContext::UniformRange range = rContext.frameContext.AllocateUniformData(sizeof(DrawUniforms));
+            DrawUniforms uniforms{FrameUniforms{rContext.viewProjection}, rConstants};
+            std::memcpy(range.pData, &uniforms, sizeof(uniforms));
+            packet.uniformSet = range.descriptorSet;
+            packet.uniformOffset = range.offset;
+        }
+        // Objects without known extent sort as nearest
+        const Bounds bounds = bounds_.Get(rInstance.object);
+        const float depth = bounds.IsFinite() ? RenderQueue::ViewDepth(rContext.viewProjection, bounds.center) : 0.0f;
+        uint64_t sortKey = RenderQueue::MakeSortKey(RenderQueue::Pass::Opaque, packet.pPipeline->GetId(),
+                                                    rItem.pMaterial->GetId(), rItem.pMeshBuffer->GetId(), depth);
+        rQueue.Push(sortKey, packet);
     }
 }
@@ -1,18 +1,228 @@
 #pragma once
 
+#include <glm/glm.hpp>
+
+#include <limits>
 #include <memory>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <vulkan/vulkan.h>
-#include "objects/Object.h"
+#include "AssetLoader.h"
+#include "BoundsArray.h"
+#include "Bvh.h"
+#include "DrawConstants.h"
+#include "Frustum.h"
+#include "InstanceData.h"
+#include "Light.h"
+#include "RenderQueue.h"
+#include "SlotMap.h"
+#include "objects/MeshObject.h"
+
+class GpuCuller;
+class GraphicsPipeline;
+class Material;
+class MeshBuffer;
+struct RenderContext;
+struct VertexData;
 
+/**
+ * @brief Owns all objects as components in packed arrays (one archetype: transform, mesh, material, bounds), so
+ * update and draw are loops over arrays instead of virtual calls per object. Objects are addressed by handles,
+ * MeshObject is a view of one object.
+ */
 class Scene
 {
 public:
-    void AddObject(std::unique_ptr<Object> &&rrObject);
-    void RemoveObject(const Object &rObject);
-    
+    using ObjectHandle = SlotMapHandle;
+
+public:
+    MeshObject CreateMeshObject();
+
+    /**
+     * @brief Destroys the object, the last object takes its place in update and draw order.
+     * @return false if the handle is stale
+     */
+    bool RemoveObject(ObjectHandle handle);
+
+    bool Contains(ObjectHandle handle) const { return entities_.Contains(handle); }
+
+    /// Invalid view if the object was removed
+    MeshObject FindObject(ObjectHandle handle);
+
+    /**
+     * @brief Selects the objects intersecting the frustum, only those are drawn afterwards.
+     * Until the first call every object is visible.
+     */
+    void Cull(const Frustum &rFrustum);
+
+    /**
+     * @brief Culls and batches on the GPU instead, Draw then records a compute pass and one indirect draw per batch
+     * and its CPU cost no longer depends on the number of objects. Needs RenderContext::frameIndex, only applies to
+     * DrawMode::Instanced.
+     */
+    void SetGpuCulling(bool enabled);
+    bool IsGpuCulling() const { return spGpuCuller_ != nullptr; }
+
+    /**
+     * @brief Creates the buffers of meshes whose data arrived and updates every material once.
+     */
     void Update(const RenderContext &rContext);
-    void Draw(const RenderContext &rContext);
+
+    /**
+     * @brief Fills the queue with the draws of all visible objects and sorts it. Objects sharing material and vertex
+     * data are drawn as one instanced draw, their transforms are written to the instance buffer of the frame.
+     * Bindless materials with the same pipeline share draws, each instance carries its material index.
+     * The per-draw modes of RenderContext::drawMode draw every visible object on its own instead.
+     */
+    void Draw(const RenderContext &rContext, RenderQueue &rQueue);
+
+    /**
+     * @brief Appends the objects whose bounds intersect the frustum, objects with infinite bounds always do.
+     */
+    void QueryFrustum(const Frustum &rFrustum, std::vector<ObjectHandle> &rObjects) const;
+
+    /**
+     * @brief Appends the objects whose box intersects the sphere, objects with infinite bounds are skipped.
+     */
+    void QuerySphere(const glm::vec3 &rCenter, float radius, std::vector<ObjectHandle> &rObjects) const;
+
+    /**
+     * @brief Object whose box the ray enters first, an invalid handle if none. Objects with infinite bounds are
+     * skipped.
+     */
+    ObjectHandle Raycast(const glm::vec3 &rOrigin, const glm::vec3 &rDirection,
+                         float maxDistance = std::numeric_limits<float>::infinity()) const;
+
+    size_t GetObjectCount() const { return entities_.GetSize(); }
+    size_t GetVisibleObjectCount() const { return culled_ ? visible_.size() : entities_.GetSize(); }
+
+    /// Lights of the scene, lit by deferred shading (see DeferredRenderer) and clustered lighting (see LightCuller)
+    void SetLights(std::vector<Light> lights) { lights_ = std::move(lights); }
+    const std::vector<Light> &GetLights() const { return lights_; }
+
 private:
-    std::vector<std::unique_ptr<Object>> objects_;
+    friend class MeshObject;
+
+    static constexpr uint32_t INVALID_POSITION = std::numeric_limits<uint32_t>::max();
+
+    struct Entity {
+        // BVH leaf, Bvh::INVALID_NODE for infinite bounds
+        uint32_t leaf = Bvh::INVALID_NODE;
+        // Position in unbounded_, INVALID_POSITION for finite bounds
+        uint32_t unboundedPosition = INVALID_POSITION;
+    };
+
+    struct Mesh {
+        std::shared_ptr<VertexData> spVertexData;
+        AssetHandle<VertexData> vertexDataHandle;
+        std::shared_ptr<MeshBuffer> spMeshBuffer;
+        // Model space, infinite until the vertex data arrived
+        Bounds localBounds = Bounds::Infinite();
+        // In pendingMeshes_ until the buffer is ready to draw
+        bool pending = false;
+    };
+
+    /**
+     * @brief Everything the draw loop reads per object, only set once both material and mesh buffer are usable.
+     */
+    struct DrawItem {
+        Material *pMaterial = nullptr;
+        const MeshBuffer *pMeshBuffer = nullptr;
+    };
+
+    struct MaterialUsage {
+        std::shared_ptr<Material> spMaterial;
+        uint32_t objectCount = 0;
+    };
+
+    /**
+     * @brief Mesh buffer created for vertex data, handed to every object with the same data.
+     */
+    struct SharedMesh {
+        std::weak_ptr<const VertexData> wpVertexData;
+        std::weak_ptr<MeshBuffer> wpMeshBuffer;
+        Bounds localBounds;
+    };
+
+    /**
+     * @brief Visible objects with equal material (or pipeline, for bindless materials) and mesh buffer, drawn with
+     * one instanced draw.
+     */
+    struct Batch {
+        Material *pMaterial = nullptr;
+        GraphicsPipeline *pPipeline = nullptr;
+        const MeshBuffer *pMeshBuffer = nullptr;
+        uint32_t firstInstance = 0;
+        uint32_t instanceCount = 0;
+        // Sum of the bounds centers of the instances with finite bounds, their mean gives the sort depth
+        glm::vec3 centerSum = glm::vec3(0.0f);
+        uint32_t finiteCount = 0;
+    };
+
+    struct Instance {
+        uint32_t object;
+        uint32_t batch;
+        uint32_t materialIndex;
+    };
+
+    /// Dense index of the object, throws for stale handles
+    uint32_t indexOf(ObjectHandle handle) const;
+
+    void setMaterial(uint32_t index, const std::shared_ptr<Material> &rMaterial);
+    void setVertexData(ObjectHandle handle, const std::shared_ptr<VertexData> &rVertexData,
+                       const AssetHandle<VertexData> &rVertexDataHandle);
+    void setTransform(uint32_t index, const glm::mat4 &rTransform);
+    void setBounds(uint32_t index, const Bounds &rBounds);
+    void setDrawItem(uint32_t index, Material *pMaterial, const MeshBuffer *pMeshBuffer);
+
+    void updateMeshes(const RenderContext &rContext);
+    void acquireMeshBuffer(const RenderContext &rContext, Mesh &rMesh);
+    void addUnbounded(uint32_t index);
+    void removeUnbounded(uint32_t index);
+    /// Replaces rIndices with the visible objects, testing all bounds with SIMD for small or mostly visible scenes
+    void queryFrustum(const Frustum &rFrustum, std::vector<uint32_t> &rIndices, bool mostlyVisible) const;
+    void drawPerObject(const RenderContext &rContext, RenderQueue &rQueue);
+
+private:
+    // Component arrays are indexed like the dense entities and reordered the same way on removal
+    SlotMap<Entity> entities_;
+    BoundsArray bounds_;
+    std::vector<glm::mat4> transforms_;
+    std::vector<Mesh> meshes_;
+    std::vector<std::shared_ptr<Material>> materials_;
+    std::vector<DrawItem> drawItems_;
+    std::vector<Light> lights_;
+
+    // Spatial index over all objects with finite bounds, leaf user data is the dense index
+    Bvh bvh_;
+    // Objects with infinite bounds (still loading) are never culled
+    std::vector<uint32_t> unbounded_;
+
+    // Meshes waiting for their data or upload, only these are looked at by Update
+    std::vector<ObjectHandle> pendingMeshes_;
+    // Mesh buffers and materials dropped since the last update, the next frame keeps them alive until the GPU
+    // finished the frames that may still use them
+    std::vector<std::shared_ptr<const void>> retired_;
+    // Materials in use, each is updated once per frame however many objects share it
+    std::unordered_map<const Material *, MaterialUsage> materialUsages_;
+    // Objects sharing vertex data share its buffer, so they can be instanced. Expired entries are pruned whenever
+    // the map doubled.
+    std::unordered_map<const VertexData *, SharedMesh> sharedMeshes_;
+    size_t sharedMeshPruneSize_ = 64;
+
+    // Scratch of Draw, members so their memory is reused every frame
+    std::vector<Batch> batches_;
+    std::unordered_map<uint64_t, uint32_t> batchLookup_;
+    std::vector<Instance> instances_;
+    std::vector<InstanceData> instanceData_;
+    // Pushed by the packets of DrawMode::PushConstants, so they live until the queue was submitted
+    std::vector<DrawConstants> drawConstants_;
+
+    std::vector<uint32_t> visible_;
+    bool culled_ = false;
+
+    // Mirrors the objects on the GPU while GPU culling is enabled, shared so it can be retired with frames in flight
+    std::shared_ptr<GpuCuller> spGpuCuller_;
+    Frustum frustum_ = Frustum(glm::mat4(1.0f));
 };
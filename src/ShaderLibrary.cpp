@@ -0,0 +1,102 @@
+#include "ShaderLibrary.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+
+#include "DeviceContext.h"
+#include "Hash.h"
+
+ShaderLibrary::ShaderLibrary(DeviceContext &rDeviceContext)
+    : rDeviceContext_(rDeviceContext), lastWatch_(std::chrono::steady_clock::now()) {}
+
+std::shared_ptr<const ShaderModule> ShaderLibrary::GetShaderModule(const std::filesystem::path &rFilePath) {
+    auto [it, inserted] = entries_.try_emplace(rFilePath.string());
+    Entry &rEntry = it->second;
+    if (inserted) {
+        // Timestamp before reading, so a change during the load is picked up by the next check
+        std::error_code error;
+        rEntry.filePath = rFilePath;
+        rEntry.lastWriteTime = std::filesystem::last_write_time(rFilePath, error);
+
+        // Everything using the shader waits for it, so it goes before other assets
+        rEntry.pendingLoad = rDeviceContext_.GetResourceManager().GetAssetLoader().ReadBinaryFileAsync(
+            rFilePath, AssetLoader::Priority::High);
+    }
+    if (rEntry.spModule == nullptr && rEntry.pendingLoad.IsReady()) {
+        finishLoad(rEntry);
+    }
+    return rEntry.spModule;
+}
+
+void ShaderLibrary::Update() {
+    for (auto &[rKey, rEntry] : entries_) {
+        if (rEntry.pendingLoad.IsReady()) {
+            finishLoad(rEntry);
+        }
+    }
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (now - lastWatch_ >= WATCH_INTERVAL) {
+        lastWatch_ = now;
+        watchFiles();
+    }
+}
+
+void ShaderLibrary::finishLoad(Entry &rEntry) {
+    AssetHandle<std::vector<char>> load = rEntry.pendingLoad;
+    rEntry.pendingLoad.Reset();
+
+    std::shared_ptr<const ShaderModule> spModule;
+    try {
+        std::shared_ptr<std::vector<char>> spCode = load.Get();
+        spModule = getOrCreateModule(std::move(*spCode));
+    } catch (const std::exception &rException) {
+        // A broken load keeps the previous module, or none at first, the next change of the file is tried again
+        std::cerr << "failed to load shader " << rEntry.filePath.string() << ": " << rException.what() << std::endl;
+        return;
+    }
+
+    if (spModule != rEntry.spModule) {
+        // Touching a file without changing it keeps the module and so all pipelines using it
+        rEntry.spModule = std::move(spModule);
+        generation_++;
+    }
+}
+
+void ShaderLibrary::watchFiles() {
+    for (auto &[rKey, rEntry] : entries_) {
+        if (rEntry.pendingLoad.IsValid()) {
+            continue;
+        }
+
+        std::error_code error;
+        std::filesystem::file_time_type lastWriteTime = std::filesystem::last_write_time(rEntry.filePath, error);
+        if (error || lastWriteTime == rEntry.lastWriteTime) {
+            continue;
+        }
+        rEntry.lastWriteTime = lastWriteTime;
+        rEntry.pendingLoad = rDeviceContext_.GetResourceManager().GetAssetLoader().ReadBinaryFileAsync(
+            rEntry.filePath, AssetLoader::Priority::High);
+    }
+}
+
+std::shared_ptr<const ShaderModule> ShaderLibrary::getOrCreateModule(std::vector<char> &&rrCode) {
+    uint64_t hash = Hash::Bytes(rrCode);
+
+    std::weak_ptr<const ShaderModule> &rwpModule = modules_[hash];
+    std::shared_ptr<const ShaderModule> spModule = rwpModule.lock();
+    if (spModule != nullptr && spModule->GetCode() == rrCode) {
+        return spModule;
+    }
+
+    // Modules of old file versions are gone once no pipeline uses them anymore
+    std::erase_if(modules_, [hash](const auto &rEntry) { return rEntry.first != hash && rEntry.second.expired(); });
+
+    spModule = std::make_shared<const ShaderModule>(rDeviceContext_.GetDevice(), std::move(rrCode), hash);
+    if (rwpModule.expired()) {
+        // On a hash collision the first module stays the shared one
+        rwpModule = spModule;
+    }
+    return spModule;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "AssetLoader.h"
+#include "ShaderModule.h"
+
+class DeviceContext;
+
+/**
+ * @brief Loads SPIR-V files once and shares their shader modules, modules are content addressed so files with equal
+ * code share one module. Loaded files are watched and reloaded when they change on disk.
+ * Used from the update thread only.
+ */
+class ShaderLibrary final {
+public:
+    /// How often loaded files are checked for changes
+    static constexpr std::chrono::milliseconds WATCH_INTERVAL{500};
+
+public:
+    explicit ShaderLibrary(DeviceContext &rDeviceContext);
+
+    ShaderLibrary(const ShaderLibrary &) = delete;
+    ShaderLibrary &operator=(const ShaderLibrary &) = delete;
+
+    /**
+     * @brief Returns the current module of the file, nullptr until it is loaded or while it fails to load.
+     * The first request starts loading.
+     */
+    std::shared_ptr<const ShaderModule> GetShaderModule(const std::filesystem::path &rFilePath);
+
+    /**
+     * @brief Takes over finished loads and starts reloading changed files. Called once per frame.
+     */
+    void Update();
+
+    /**
+     * @brief Changes whenever the module of any file changed, users can skip looking up their modules while equal.
+     */
+    uint64_t GetGeneration() const { return generation_; }
+
+private:
+    struct Entry {
+        std::filesystem::path filePath;
+        std::filesystem::file_time_type lastWriteTime;
+        AssetHandle<std::vector<char>> pendingLoad;
+        std::shared_ptr<const ShaderModule> spModule;
+    };
+
+    void finishLoad(Entry &rEntry);
+    void watchFiles();
+    std::shared_ptr<const ShaderModule> getOrCreateModule(std::vector<char> &&rrCode);
+
+private:
+    DeviceContext &rDeviceContext_;
+    std::unordered_map<std::string, Entry> entries_;
+    // Content hash to module, only alive modules are shared
+    std::unordered_map<uint64_t, std::weak_ptr<const ShaderModule>> modules_;
+    uint64_t generation_ = 0;
+    std::chrono::steady_clock::time_point lastWatch_;
+};
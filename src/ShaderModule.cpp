@@ -0,0 +1,30 @@
+#include "ShaderModule.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+const uint32_t SPIRV_MAGIC = 0x07230203u;
+}  // namespace
+
+ShaderModule::ShaderModule(VkDevice device, std::vector<char> &&rrCode, uint64_t hash)
+    : device_(device), code_(std::move(rrCode)), hash_(hash) {
+    // Catches files that are still being written when hot reloading
+    uint32_t magic = 0;
+    if (code_.size() >= sizeof(magic)) {
+        std::memcpy(&magic, code_.data(), sizeof(magic));
+    }
+    if (code_.size() % sizeof(uint32_t) != 0 || magic != SPIRV_MAGIC) {
+        throw std::runtime_error("failed to create shader module, invalid SPIR-V code!");
+    }
+
+    VkShaderModuleCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = code_.size();
+    createInfo.pCode = reinterpret_cast<const uint32_t *>(code_.data());
+    if (vkCreateShaderModule(device_, &createInfo, nullptr, &shaderModule_) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shader module!");
+    }
+}
+
+ShaderModule::~ShaderModule() { vkDestroyShaderModule(device_, shaderModule_, nullptr); }
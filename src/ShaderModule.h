@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief SPIR-V code and the VkShaderModule created from it, identified by the hash of the code.
+ * Created by the ShaderLibrary, which shares one module between all users of equal code.
+ */
+class ShaderModule final {
+public:
+    ShaderModule(VkDevice device, std::vector<char> &&rrCode, uint64_t hash);
+    ~ShaderModule();
+
+    ShaderModule(const ShaderModule &) = delete;
+    ShaderModule &operator=(const ShaderModule &) = delete;
+
+    VkShaderModule GetHandle() const { return shaderModule_; }
+    uint64_t GetHash() const { return hash_; }
+    const std::vector<char> &GetCode() const { return code_; }
+
+private:
+    VkDevice device_;
+    std::vector<char> code_;
+    uint64_t hash_;
+    VkShaderModule shaderModule_ = VK_NULL_HANDLE;
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 32 bit handle into a SlotMap, the low bits select the slot and the high bits are its generation.
+ * Handles of removed elements are detected, the default handle is never valid.
+ */
+struct SlotMapHandle {
+    static constexpr uint32_t INDEX_BITS = 22;
+    static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+    static constexpr uint32_t MAX_GENERATION = (1u << (32 - INDEX_BITS)) - 1;
+
+    uint32_t value = 0;
+
+    uint32_t GetSlot() const { return value & INDEX_MASK; }
+    uint32_t GetGeneration() const { return value >> INDEX_BITS; }
+
+    bool operator==(const SlotMapHandle &rOther) const { return value == rOther.value; }
+    bool operator!=(const SlotMapHandle &rOther) const { return value != rOther.value; }
+};
+
+/**
+ * @brief Elements in a dense array addressed by generational handles, adding, removing and looking up are O(1).
+ * Removing moves the last element into the hole, so the dense order changes but iteration stays contiguous.
+ */
+template <typename T>
+class SlotMap {
+public:
+    using Handle = SlotMapHandle;
+
+public:
+    Handle Insert(T &&rrValue) {
+        uint32_t slot;
+        if (!freeSlots_.empty()) {
+            slot = freeSlots_.front();
+            freeSlots_.pop_front();
+        } else {
+            if (slots_.size() > Handle::INDEX_MASK) {
+                throw std::runtime_error("failed to insert into slot map, it is full!");
+            }
+            slot = static_cast<uint32_t>(slots_.size());
+            // Generation 0 is never used, so the default handle stays invalid
+            slots_.push_back(Slot{0, 1});
+        }
+
+        slots_[slot].denseIndex = static_cast<uint32_t>(dense_.size());
+        dense_.push_back(std::move(rrValue));
+        denseToSlot_.push_back(slot);
+        return Handle{slots_[slot].generation << Handle::INDEX_BITS | slot};
+    }
+
+    /**
+     * @brief Removes the element by moving the last one into its place.
+     * @return false if the handle was stale
+     */
+    bool Remove(Handle handle) {
+        if (!Contains(handle)) {
+            return false;
+        }
+
+        const uint32_t slot = handle.GetSlot();
+        const uint32_t index = slots_[slot].denseIndex;
+        const uint32_t last = static_cast<uint32_t>(dense_.size()) - 1;
+        if (index != last) {
+            dense_[index] = std::move(dense_[last]);
+            denseToSlot_[index] = denseToSlot_[last];
+            slots_[denseToSlot_[index]].denseIndex = index;
+        }
+        dense_.pop_back();
+        denseToSlot_.pop_back();
+
+        // Slots are reused oldest first to spread generations, a slot whose generation ran out is retired so old
+        // handles can never become valid again
+        if (slots_[slot].generation < Handle::MAX_GENERATION) {
+            slots_[slot].generation++;
+            freeSlots_.push_back(slot);
+        } else {
+            slots_[slot].generation = 0;
+        }
+        return true;
+    }
+
+    bool Contains(Handle handle) const {
+        const uint32_t slot = handle.GetSlot();
+        // Removing bumps the generation, so free slots never match a handle that was handed out
+        return slot < slots_.size() && handle.GetGeneration() != 0 &&
+               slots_[slot].generation == handle.GetGeneration();
+    }
+
+    /// nullptr for stale handles
+    T *Get(Handle handle) { return Contains(handle) ? &dense_[slots_[handle.GetSlot()].denseIndex] : nullptr; }
+    const T *Get(Handle handle) const {
+        return Contains(handle) ? &dense_[slots_[handle.GetSlot()].denseIndex] : nullptr;
+    }
+
+    /// Position of a valid handle in the dense array, it changes when other elements are removed
+    uint32_t GetIndex(Handle handle) const { return slots_[handle.GetSlot()].denseIndex; }
+    Handle GetHandle(uint32_t index) const {
+        const uint32_t slot = denseToSlot_[index];
+        return Handle{slots_[slot].generation << Handle::INDEX_BITS | slot};
+    }
+
+    size_t GetSize() const { return dense_.size(); }
+    bool IsEmpty() const { return dense_.empty(); }
+
+    T &operator[](uint32_t index) { return dense_[index]; }
+    const T &operator[](uint32_t index) const { return dense_[index]; }
+
+    auto begin() { return dense_.begin(); }
+    auto end() { return dense_.end(); }
+    auto begin() const { return dense_.begin(); }
+    auto end() const { return dense_.end(); }
+
+private:
+    struct Slot {
+        uint32_t denseIndex;
+        uint32_t generation;
+    };
+
+    std::vector<T> dense_;
+    std::vector<uint32_t> denseToSlot_;
+    std::vector<Slot> slots_;
+    std::deque<uint32_t> freeSlots_;
+};
@@ -4,10 +4,6 @@
 
 #include "Window.h"
 
-namespace {
-    const uint32_t MAX_FRAMES_IN_FLIGHT = 2u;
-}
-
 Swapchain::Swapchain(DeviceContext &rDeviceContext, Window &rWindow)
     : rDeviceContext_(rDeviceContext), rWindow_(rWindow) {
         rWindow.RegisterResizeCallback(std::bind(&Swapchain::OnWindowResize, this));
@@ -172,6 +168,7 @@ Swapchain::AvailableImageInfo Swapchain::AcquireImage()
 
 	AvailableImageInfo availableInfo;
 	availableInfo.imageIndex = imageIndex;
+	availableInfo.frameIndex = m_currentFrame;
 	availableInfo.imageAvailableSemaphore = imageAvailableSemaphores_[m_currentFrame];
 	availableInfo.renderFinishedSemaphore = renderFinishedSemaphores_[m_currentFrame];
 	availableInfo.inFlightFence = inFlightFences_[m_currentFrame];
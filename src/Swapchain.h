@@ -4,8 +4,9 @@
 #include <vector>
 
 #include "DeviceContext.h"
+#include "RenderTarget.h"
 
-class Swapchain final {
+class Swapchain final : public RenderTarget {
 public:
     struct SwapChainSupportDetails {
         VkSurfaceCapabilitiesKHR capabilities;
@@ -15,36 +16,28 @@ public:
         bool IsAdequate() { return !formats.empty() && !presentModes.empty(); }
     };
 
-    struct AvailableImageInfo {
-        uint32_t imageIndex = std::numeric_limits<uint32_t>::max();
-        VkSemaphore imageAvailableSemaphore = VK_NULL_HANDLE;
-        VkSemaphore renderFinishedSemaphore = VK_NULL_HANDLE;
-        VkFence inFlightFence = VK_NULL_HANDLE;
-
-        bool IsValid() { return imageIndex != std::numeric_limits<uint32_t>::max(); }
-    };
-
 public:
     Swapchain(DeviceContext &rDeviceContext, Window &rWindow);
-    ~Swapchain();
+    ~Swapchain() override;
 
     void OnWindowResize();
 
-    bool Update();
+    bool Update() override;
 
     void DestroyResources();
 
-	void WaitForNextFrame();
+	void WaitForNextFrame() override;
 
-	AvailableImageInfo AcquireImage();
+	AvailableImageInfo AcquireImage() override;
 
-	bool Present(const AvailableImageInfo &availableInfo);
+	bool Present(const AvailableImageInfo &availableInfo) override;
 
-    VkFormat &GetImageFormat() { return swapchainImageFormat_; }
-	VkExtent2D &GetExtent2D() { return swapchainExtent_; }
+    VkFormat &GetImageFormat() override { return swapchainImageFormat_; }
+	VkExtent2D &GetExtent2D() override { return swapchainExtent_; }
 	VkSurfaceKHR &GetSurface() { return surface_; }
-	std::vector<VkImageView> &GetImageViews() { return swapchainImageViews_; }
-    uint32_t GetNumberOfImages() const { return static_cast<uint32_t>(swapchainImages_.size()); }
+	std::vector<VkImageView> &GetImageViews() override { return swapchainImageViews_; }
+    uint32_t GetNumberOfImages() const override { return static_cast<uint32_t>(swapchainImages_.size()); }
+    VkImageLayout GetFinalLayout() const override { return VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; }
 
 public:
     static SwapChainSupportDetails QuerySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface);
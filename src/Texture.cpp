@@ -0,0 +1,61 @@
+#include "Texture.h"
+
+#include <stdexcept>
+
+#include "DeviceContext.h"
+
+Texture::Texture(DeviceContext &rDeviceContext, VkExtent2D extent, VkFormat format)
+    : rDeviceContext_(rDeviceContext), extent_(extent) {
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = format;
+    imageInfo.extent = {extent.width, extent.height, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (vkCreateImage(rDeviceContext_.GetDevice(), &imageInfo, nullptr, &image_) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create texture image!");
+    }
+    allocation_ = rDeviceContext_.GetMemoryAllocator().AllocateImageMemory(image_, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = image_;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = format;
+    viewInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.baseMipLevel = 0;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    if (vkCreateImageView(rDeviceContext_.GetDevice(), &viewInfo, nullptr, &imageView_) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create texture image view!");
+    }
+
+    if (BindlessTable *pBindlessTable = rDeviceContext_.GetBindlessTable()) {
+        bindlessIndex_ = pBindlessTable->AddTexture(imageView_);
+    }
+}
+
+Texture::~Texture() {
+    // Destroyed once no frame reads the image anymore, so neither its slot
+    if (BindlessTable *pBindlessTable = rDeviceContext_.GetBindlessTable()) {
+        pBindlessTable->RemoveTexture(bindlessIndex_);
+    }
+    vkDestroyImageView(rDeviceContext_.GetDevice(), imageView_, nullptr);
+    vkDestroyImage(rDeviceContext_.GetDevice(), image_, nullptr);
+    rDeviceContext_.GetMemoryAllocator().Free(allocation_);
+}
+
+bool Texture::IsReady() const { return rDeviceContext_.GetUploadManager().IsComplete(uploadTicket_); }
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include "BindlessTable.h"
+#include "MemoryAllocator.h"
+#include "UploadManager.h"
+
+class DeviceContext;
+
+/**
+ * @brief Device local sampled 2D image, filled through the UploadManager. Registered in the bindless table while it
+ * lives, if there is one.
+ */
+class Texture final {
+public:
+    Texture(DeviceContext &rDeviceContext, VkExtent2D extent, VkFormat format);
+    ~Texture();
+
+    Texture(const Texture &) = delete;
+    Texture &operator=(const Texture &) = delete;
+
+    /**
+     * @brief Image can only be sampled once the upload finished.
+     */
+    bool IsReady() const;
+
+    VkImage GetImage() const { return image_; }
+    VkImageView GetImageView() const { return imageView_; }
+    VkExtent2D GetExtent() const { return extent_; }
+    /// Index in the texture array of the bindless table, BindlessTable::INVALID_INDEX without bindless drawing
+    uint32_t GetBindlessIndex() const { return bindlessIndex_; }
+
+private:
+    friend class ResourceManager;
+
+    DeviceContext &rDeviceContext_;
+    VkExtent2D extent_;
+    VkImage image_ = VK_NULL_HANDLE;
+    VkImageView imageView_ = VK_NULL_HANDLE;
+    MemoryAllocator::Allocation allocation_;
+    UploadManager::Ticket uploadTicket_ = 0;
+    uint32_t bindlessIndex_ = BindlessTable::INVALID_INDEX;
+};
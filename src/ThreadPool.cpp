@@ -0,0 +1,68 @@
+#include "ThreadPool.h"
+
+#include <iostream>
+
+ThreadPool::ThreadPool(uint32_t numThreads) {
+    threads_.reserve(numThreads);
+    for (uint32_t i = 0; i < numThreads; i++) {
+        threads_.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    condition_.notify_all();
+    for (std::thread &rThread : threads_) {
+        rThread.join();
+    }
+}
+
+void ThreadPool::Submit(Priority priority, std::function<void()> &&rrJob) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queues_[static_cast<uint32_t>(priority)].push_back(std::move(rrJob));
+    }
+    condition_.notify_one();
+}
+
+size_t ThreadPool::GetPendingJobCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (const auto &rQueue : queues_) {
+        count += rQueue.size();
+    }
+    return count;
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this] {
+                return stop_ || !queues_[0].empty() || !queues_[1].empty() || !queues_[2].empty();
+            });
+            if (stop_) {
+                return;
+            }
+
+            for (auto &rQueue : queues_) {
+                if (!rQueue.empty()) {
+                    job = std::move(rQueue.front());
+                    rQueue.pop_front();
+                    break;
+                }
+            }
+        }
+
+        try {
+            job();
+        } catch (const std::exception &rException) {
+            // Jobs report their errors themselves, this only keeps the worker alive
+            std::cerr << "Unhandled exception in worker thread: " << rException.what() << std::endl;
+        }
+    }
+}
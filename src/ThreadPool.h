@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed number of worker threads executing jobs by priority, jobs of the same priority run in FIFO order.
+ */
+class ThreadPool final {
+public:
+    enum class Priority : uint32_t { High = 0, Normal = 1, Low = 2 };
+
+public:
+    explicit ThreadPool(uint32_t numThreads);
+    /// Waits for running jobs, pending jobs are dropped
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void Submit(Priority priority, std::function<void()> &&rrJob);
+
+    size_t GetPendingJobCount() const;
+
+private:
+    void workerLoop();
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    std::array<std::deque<std::function<void()>>, 3> queues_;
+    bool stop_ = false;
+    std::vector<std::thread> threads_;
+};
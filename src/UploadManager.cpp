@@ -0,0 +1,311 @@
+#include "UploadManager.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "DeviceContext.h"
+#include "RenderTarget.h"
+
+namespace {
+// One command buffer per frame in flight plus one being recorded
+const uint32_t BATCH_COUNT = RenderTarget::MAX_FRAMES_IN_FLIGHT + 1;
+
+// Satisfies optimalBufferCopyOffsetAlignment on common hardware and texel alignment of all formats we upload
+const VkDeviceSize COPY_ALIGNMENT = 16;
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) { return (value + alignment - 1) / alignment * alignment; }
+}  // namespace
+
+UploadManager::UploadManager(DeviceContext &rDeviceContext, VkDeviceSize ringSize)
+    : rDeviceContext_(rDeviceContext), ringSize_(ringSize) {
+    VkDevice device = rDeviceContext_.GetDevice();
+
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = ringSize_;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(device, &bufferInfo, nullptr, &ringBuffer_) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create staging buffer!");
+    }
+    ringAllocation_ = rDeviceContext_.GetMemoryAllocator().AllocateBufferMemory(
+        ringBuffer_, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    pRing_ = static_cast<unsigned char *>(ringAllocation_.pMapped);
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = rDeviceContext_.GetQueueFamilyIndices().graphicsFamily.value();
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+    if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool_) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create upload command pool!");
+    }
+
+    batches_.resize(BATCH_COUNT);
+    std::vector<VkCommandBuffer> commandBuffers(BATCH_COUNT);
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = commandPool_;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = BATCH_COUNT;
+
+    if (vkAllocateCommandBuffers(device, &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate upload command buffers!");
+    }
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    for (uint32_t i = 0; i < BATCH_COUNT; i++) {
+        batches_[i].commandBuffer = commandBuffers[i];
+        if (vkCreateFence(device, &fenceInfo, nullptr, &batches_[i].fence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create upload fence!");
+        }
+    }
+}
+
+UploadManager::~UploadManager() {
+    while (retireOldestBatch(true)) {
+    }
+
+    VkDevice device = rDeviceContext_.GetDevice();
+    for (Batch &rBatch : batches_) {
+        vkDestroyFence(device, rBatch.fence, nullptr);
+    }
+    // Command buffers are freed with the pool
+    vkDestroyCommandPool(device, commandPool_, nullptr);
+
+    vkDestroyBuffer(device, ringBuffer_, nullptr);
+    rDeviceContext_.GetMemoryAllocator().Free(ringAllocation_);
+}
+
+UploadManager::Ticket UploadManager::UploadBuffer(std::span<const unsigned char> data, VkBuffer dstBuffer,
+                                                  VkDeviceSize dstOffset) {
+    Ticket ticket = nextTicket_++;
+
+    // Split large buffers so a single upload never has to wait for the whole ring
+    const VkDeviceSize maxChunkSize = ringSize_ / 4;
+    for (VkDeviceSize done = 0; done < data.size();) {
+        VkDeviceSize chunkSize = std::min<VkDeviceSize>(data.size() - done, maxChunkSize);
+        VkDeviceSize offset = allocate(chunkSize, COPY_ALIGNMENT);
+        std::memcpy(pRing_ + offset, data.data() + done, chunkSize);
+
+        PendingCopy &rCopy = pendingCopies_.emplace_back();
+        rCopy.srcOffset = offset;
+        rCopy.size = chunkSize;
+        rCopy.dstBuffer = dstBuffer;
+        rCopy.dstOffset = dstOffset + done;
+        done += chunkSize;
+    }
+
+    lastQueuedTicket_ = ticket;
+    return ticket;
+}
+
+UploadManager::Ticket UploadManager::UploadImage(std::span<const unsigned char> data, VkImage dstImage,
+                                                 VkExtent3D extent) {
+    if (data.size() >= ringSize_) {
+        throw std::runtime_error("image does not fit into staging ring!");
+    }
+
+    Ticket ticket = nextTicket_++;
+
+    VkDeviceSize offset = allocate(data.size(), COPY_ALIGNMENT);
+    std::memcpy(pRing_ + offset, data.data(), data.size());
+
+    PendingCopy &rCopy = pendingCopies_.emplace_back();
+    rCopy.srcOffset = offset;
+    rCopy.size = data.size();
+    rCopy.dstImage = dstImage;
+    rCopy.extent = extent;
+
+    lastQueuedTicket_ = ticket;
+    return ticket;
+}
+
+void UploadManager::Flush() {
+    Update();
+
+    if (pendingCopies_.empty()) {
+        return;
+    }
+
+    Batch &rBatch = batches_[nextBatch_];
+    while (rBatch.inFlight) {
+        // All batches are in flight, wait for the oldest one (which is this one)
+        retireOldestBatch(true);
+    }
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if (vkBeginCommandBuffer(rBatch.commandBuffer, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin recording upload command buffer!");
+    }
+
+    VkImageSubresourceRange colorRange{};
+    colorRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    colorRange.baseMipLevel = 0;
+    colorRange.levelCount = 1;
+    colorRange.baseArrayLayer = 0;
+    colorRange.layerCount = 1;
+
+    // Transition all images to transfer destination with one barrier
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+    for (const PendingCopy &rCopy : pendingCopies_) {
+        if (rCopy.dstImage == VK_NULL_HANDLE) {
+            continue;
+        }
+        VkImageMemoryBarrier &rBarrier = imageBarriers.emplace_back();
+        rBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        rBarrier.srcAccessMask = 0;
+        rBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        rBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        rBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        rBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        rBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        rBarrier.image = rCopy.dstImage;
+        rBarrier.subresourceRange = colorRange;
+    }
+    if (!imageBarriers.empty()) {
+        vkCmdPipelineBarrier(rBatch.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                             0, nullptr, 0, nullptr, static_cast<uint32_t>(imageBarriers.size()),
+                             imageBarriers.data());
+    }
+
+    for (const PendingCopy &rCopy : pendingCopies_) {
+        if (rCopy.dstImage != VK_NULL_HANDLE) {
+            VkBufferImageCopy region{};
+            region.bufferOffset = rCopy.srcOffset;
+            region.bufferRowLength = 0;
+            region.bufferImageHeight = 0;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel = 0;
+            region.imageSubresource.baseArrayLayer = 0;
+            region.imageSubresource.layerCount = 1;
+            region.imageOffset = {0, 0, 0};
+            region.imageExtent = rCopy.extent;
+            vkCmdCopyBufferToImage(rBatch.commandBuffer, ringBuffer_, rCopy.dstImage,
+                                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        } else {
+            VkBufferCopy region{};
+            region.srcOffset = rCopy.srcOffset;
+            region.dstOffset = rCopy.dstOffset;
+            region.size = rCopy.size;
+            vkCmdCopyBuffer(rBatch.commandBuffer, ringBuffer_, rCopy.dstBuffer, 1, &region);
+        }
+    }
+
+    // Make copies visible to all later reads on this queue
+    for (VkImageMemoryBarrier &rBarrier : imageBarriers) {
+        rBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        rBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        rBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        rBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+
+    VkMemoryBarrier memoryBarrier{};
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+                                  VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier(rBatch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         0, 1, &memoryBarrier, 0, nullptr, static_cast<uint32_t>(imageBarriers.size()),
+                         imageBarriers.data());
+
+    if (vkEndCommandBuffer(rBatch.commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record upload command buffer!");
+    }
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &rBatch.commandBuffer;
+
+    rDeviceContext_.Submit(std::move(submitInfo), rBatch.fence);
+
+    rBatch.ringEnd = head_;
+    rBatch.lastTicket = lastQueuedTicket_;
+    rBatch.inFlight = true;
+    nextBatch_ = (nextBatch_ + 1) % BATCH_COUNT;
+    pendingCopies_.clear();
+}
+
+void UploadManager::Update() {
+    while (retireOldestBatch(false)) {
+    }
+}
+
+VkDeviceSize UploadManager::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+    VkDeviceSize offset = 0;
+    while (!tryAllocate(size, alignment, offset)) {
+        if (!pendingCopies_.empty()) {
+            // Submit what we have, so its space can be reclaimed
+            Flush();
+            continue;
+        }
+        if (!retireOldestBatch(true)) {
+            throw std::runtime_error("upload does not fit into staging ring!");
+        }
+    }
+    return offset;
+}
+
+bool UploadManager::tryAllocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &rOffset) {
+    if (!hasLiveData()) {
+        head_ = 0;
+        tail_ = 0;
+    }
+
+    VkDeviceSize offset = alignUp(head_, alignment);
+    if (head_ >= tail_) {
+        // Not wrapped: use space at the end, otherwise wrap around to the beginning
+        if (offset + size <= ringSize_) {
+            rOffset = offset;
+            head_ = offset + size;
+            return true;
+        }
+        if (size < tail_) {
+            rOffset = 0;
+            head_ = size;
+            return true;
+        }
+        return false;
+    }
+
+    // Wrapped: head must stay strictly behind tail
+    if (offset + size < tail_) {
+        rOffset = offset;
+        head_ = offset + size;
+        return true;
+    }
+    return false;
+}
+
+bool UploadManager::retireOldestBatch(bool wait) {
+    Batch &rBatch = batches_[oldestBatch_];
+    if (!rBatch.inFlight) {
+        return false;
+    }
+
+    if (wait) {
+        vkWaitForFences(rDeviceContext_.GetDevice(), 1, &rBatch.fence, VK_TRUE, UINT64_MAX);
+    } else if (vkGetFenceStatus(rDeviceContext_.GetDevice(), rBatch.fence) != VK_SUCCESS) {
+        return false;
+    }
+
+    tail_ = rBatch.ringEnd;
+    completedTicket_ = rBatch.lastTicket;
+    rBatch.inFlight = false;
+    oldestBatch_ = (oldestBatch_ + 1) % BATCH_COUNT;
+    return true;
+}
+
+bool UploadManager::hasLiveData() const { return !pendingCopies_.empty() || batches_[oldestBatch_].inFlight; }
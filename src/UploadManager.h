@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <span>
+#include <vector>
+
+#include "MemoryAllocator.h"
+
+class DeviceContext;
+
+/**
+ * @brief Batches uploads of buffer and image data through one persistently mapped staging ring buffer.
+ * Data is copied into the ring immediately, all copies of a frame are recorded into one transfer command buffer
+ * on Flush() and fences tell when an upload (identified by its ticket) finished and its ring space can be reused.
+ */
+class UploadManager final {
+public:
+    using Ticket = uint64_t;
+
+    static constexpr VkDeviceSize DEFAULT_RING_SIZE = 32ull * 1024 * 1024;
+
+public:
+    UploadManager(DeviceContext &rDeviceContext, VkDeviceSize ringSize = DEFAULT_RING_SIZE);
+    ~UploadManager();
+
+    UploadManager(const UploadManager &) = delete;
+    UploadManager &operator=(const UploadManager &) = delete;
+
+    /**
+     * @brief Copies data into the staging ring and queues a copy into dstBuffer (needs TRANSFER_DST usage).
+     * Buffers larger than the ring are split into several copies.
+     */
+    Ticket UploadBuffer(std::span<const unsigned char> data, VkBuffer dstBuffer, VkDeviceSize dstOffset = 0);
+
+    /**
+     * @brief Copies tightly packed texel data into the staging ring and queues a copy into mip level 0 of dstImage.
+     * The image is transitioned from UNDEFINED to SHADER_READ_ONLY_OPTIMAL.
+     */
+    Ticket UploadImage(std::span<const unsigned char> data, VkImage dstImage, VkExtent3D extent);
+
+    /**
+     * @brief Records all queued copies into one command buffer and submits it.
+     * Later submissions on the graphics queue see the uploaded data.
+     */
+    void Flush();
+
+    /**
+     * @brief Checks fences of submitted uploads and releases their staging memory. Does not block.
+     */
+    void Update();
+
+    bool IsComplete(Ticket ticket) const { return ticket <= completedTicket_; }
+
+private:
+    struct PendingCopy {
+        VkDeviceSize srcOffset = 0;
+        VkDeviceSize size = 0;
+        VkBuffer dstBuffer = VK_NULL_HANDLE;
+        VkDeviceSize dstOffset = 0;
+        VkImage dstImage = VK_NULL_HANDLE;
+        VkExtent3D extent{};
+    };
+
+    struct Batch {
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE;
+        VkDeviceSize ringEnd = 0;
+        Ticket lastTicket = 0;
+        bool inFlight = false;
+    };
+
+    VkDeviceSize allocate(VkDeviceSize size, VkDeviceSize alignment);
+    bool tryAllocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &rOffset);
+    bool retireOldestBatch(bool wait);
+    bool hasLiveData() const;
+
+private:
+    DeviceContext &rDeviceContext_;
+    VkDeviceSize ringSize_;
+    VkBuffer ringBuffer_ = VK_NULL_HANDLE;
+    MemoryAllocator::Allocation ringAllocation_;
+    unsigned char *pRing_ = nullptr;
+
+    // Live staging data is [tail_, head_) or, once wrapped, [tail_, ringSize_) + [0, head_)
+    VkDeviceSize head_ = 0;
+    VkDeviceSize tail_ = 0;
+
+    VkCommandPool commandPool_ = VK_NULL_HANDLE;
+    std::vector<Batch> batches_;
+    uint32_t nextBatch_ = 0;
+    uint32_t oldestBatch_ = 0;
+
+    std::vector<PendingCopy> pendingCopies_;
+    Ticket nextTicket_ = 1;
+    // Last upload whose copies are all queued, a batch never completes a partially queued upload
+    Ticket lastQueuedTicket_ = 0;
+    Ticket completedTicket_ = 0;
+};
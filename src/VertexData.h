@@ -1,11 +1,37 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <span>
 #include <vector>
 #include <vulkan/vulkan.h>
 
+class MappedFile;
+
 struct VertexData {
     VkVertexInputBindingDescription inputBindingDescription;
     std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
 
     std::vector<unsigned char> vertexBuffer;
+
+    // Optional, mesh is drawn non-indexed if empty
+    std::vector<unsigned char> indexBuffer;
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+
+    // Used instead of the vectors above if the data lives in a memory mapped file (see MeshCache)
+    std::shared_ptr<MappedFile> spMappedFile;
+    std::span<const unsigned char> mappedVertexBuffer;
+    std::span<const unsigned char> mappedIndexBuffer;
+
+    std::span<const unsigned char> GetVertexBuffer() const {
+        return spMappedFile != nullptr ? mappedVertexBuffer : std::span<const unsigned char>(vertexBuffer);
+    }
+
+    std::span<const unsigned char> GetIndexBuffer() const {
+        return spMappedFile != nullptr ? mappedIndexBuffer : std::span<const unsigned char>(indexBuffer);
+    }
+
+    uint32_t GetIndexCount() const {
+        return static_cast<uint32_t>(GetIndexBuffer().size() / (indexType == VK_INDEX_TYPE_UINT16 ? 2 : 4));
+    }
 };
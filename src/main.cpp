@@ -1,33 +1,381 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <utility>
 
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "BoundsArray.h"
+#include "Bvh.h"
 #include "DeviceContext.h"
 #include "Engine.h"
+#include "ResourceManager.h"
 #include "Scene.h"
 #include "WindowManager.h"
 
 #include "objects/MeshObject.h"
 #include "materials/PhongMaterial.h"
 
+namespace {
+std::shared_ptr<VertexData> createTriangle() {
+    const std::array<float, 9> positions = {0.0f, -0.5f, 0.0f, 0.5f, 0.5f, 0.0f, -0.5f, 0.5f, 0.0f};
+
+    auto spVertexData = std::make_shared<VertexData>();
+    spVertexData->inputBindingDescription.binding = 0;
+    spVertexData->inputBindingDescription.stride = 3 * sizeof(float);
+    spVertexData->inputBindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    VkVertexInputAttributeDescription &rAttribute = spVertexData->attributeDescriptions.emplace_back();
+    rAttribute.binding = 0;
+    rAttribute.location = 0;
+    rAttribute.format = VK_FORMAT_R32G32B32_SFLOAT;
+    rAttribute.offset = 0;
+
+    spVertexData->vertexBuffer.resize(sizeof(positions));
+    std::memcpy(spVertexData->vertexBuffer.data(), positions.data(), sizeof(positions));
+    return spVertexData;
+}
+
+/**
+ * Adds numObjects objects sharing a mesh, laid out on a grid covering the view. They cycle through a few materials,
+ * each material is drawn instanced (all of them in one draw when drawing bindless).
+ */
+void populateScene(Scene &rScene, ResourceManager &rResourceManager, const std::filesystem::path &rMeshPath,
+                   uint32_t numObjects) {
+    const std::array<glm::vec4, 4> colors = {glm::vec4(1.0f, 0.0f, 0.0f, 1.0f), glm::vec4(0.0f, 1.0f, 0.0f, 1.0f),
+                                             glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), glm::vec4(1.0f, 1.0f, 0.0f, 1.0f)};
+    std::vector<std::shared_ptr<PhongMaterial>> materials;
+    for (const glm::vec4 &rColor : colors) {
+        // Without bindless drawing the color is ignored
+        materials.push_back(std::make_shared<PhongMaterial>());
+        materials.back()->SetColor(rColor);
+    }
+    std::shared_ptr<VertexData> spVertexData;
+    AssetHandle<VertexData> vertexDataHandle;
+    if (rMeshPath.empty()) {
+        spVertexData = createTriangle();
+    } else {
+        // Loads in the background, frames are rendered without the mesh until then
+        vertexDataHandle = rResourceManager.GetAssetLoader().LoadVertexDataAsync(rMeshPath);
+    }
+
+    const uint32_t gridSize = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(numObjects))));
+    const float cellSize = 2.0f / static_cast<float>(gridSize);
+    for (uint32_t i = 0; i < numObjects; i++) {
+        MeshObject meshObject = rScene.CreateMeshObject();
+        meshObject.SetMaterial(materials[i % materials.size()]);
+        if (spVertexData != nullptr) {
+            meshObject.SetVertexData(spVertexData);
+        } else {
+            meshObject.SetVertexData(vertexDataHandle);
+        }
+        if (numObjects > 1) {
+            glm::vec3 cellCenter(-1.0f + (static_cast<float>(i % gridSize) + 0.5f) * cellSize,
+                                 -1.0f + (static_cast<float>(i / gridSize) + 0.5f) * cellSize, 0.0f);
+            meshObject.SetTransform(glm::scale(glm::translate(glm::mat4(1.0f), cellCenter),
+                                               glm::vec3(cellSize, cellSize, 1.0f)));
+        }
+    }
+}
+
+/**
+ * Adds numLights lights spread over a disc in front of the objects (the view looks along +z), every other one a spot
+ * light shining at them. The more lights, the smaller their radius, so any number of them covers the view about
+ * evenly. Colors cycle through a few. Only lit with deferred shading or clustered lighting.
+ */
+void addLights(Scene &rScene, uint32_t numLights) {
+    const std::array<glm::vec3, 4> colors = {glm::vec3(1.0f, 1.0f, 1.0f), glm::vec3(1.0f, 0.6f, 0.3f),
+                                             glm::vec3(0.3f, 0.6f, 1.0f), glm::vec3(0.5f, 1.0f, 0.5f)};
+    const float radius = std::clamp(1.6f / std::sqrt(static_cast<float>(std::max(numLights, 1u))), 0.05f, 0.8f);
+    // Golden angle, consecutive lights never line up
+    const float angleStep = glm::pi<float>() * (3.0f - std::sqrt(5.0f));
+    std::vector<Light> lights(numLights);
+    for (uint32_t i = 0; i < numLights; i++) {
+        const float distance = 0.9f * std::sqrt((static_cast<float>(i) + 0.5f) / static_cast<float>(numLights));
+        const float angle = angleStep * static_cast<float>(i);
+        lights[i].position = glm::vec3(distance * std::cos(angle), distance * std::sin(angle), -0.5f * radius);
+        lights[i].radius = radius;
+        lights[i].color = colors[i % colors.size()];
+        if (i % 2 == 1) {
+            lights[i].direction = glm::vec3(0.0f, 0.0f, 1.0f);
+            lights[i].spotCosine = std::cos(glm::radians(35.0f));
+        }
+    }
+    rScene.SetLights(std::move(lights));
+}
+
+struct FrameTimes {
+    double avgMs = 0.0;
+    double minMs = 0.0;
+    double maxMs = 0.0;
+};
+
+FrameTimes measureFrames(Engine &rEngine, uint32_t numFrames) {
+    double totalMs = 0.0;
+    double minMs = std::numeric_limits<double>::max();
+    double maxMs = 0.0;
+    for (uint32_t i = 0; i < numFrames; i++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        rEngine.Render();
+        auto end = std::chrono::high_resolution_clock::now();
+
+        double frameMs = std::chrono::duration<double, std::milli>(end - start).count();
+        totalMs += frameMs;
+        minMs = std::min(minMs, frameMs);
+        maxMs = std::max(maxMs, frameMs);
+    }
+    return numFrames > 0 ? FrameTimes{totalMs / numFrames, minMs, maxMs} : FrameTimes{};
+}
+
+std::ostream &operator<<(std::ostream &rStream, const FrameTimes &rTimes) {
+    return rStream << "avg " << rTimes.avgMs << " ms, min " << rTimes.minMs << " ms, max " << rTimes.maxMs << " ms";
+}
+
+/**
+ * Renders a fixed number of frames without window (e.g. on CI machines with lavapipe) and reports frame times.
+ */
+int runHeadless(uint32_t numFrames, const std::filesystem::path &rMeshPath, uint32_t numObjects, bool gpuCulling,
+                bool bindless, DrawMode drawMode, bool deferred, bool clustered, uint32_t numLights) {
+    // No window, so no surface extensions are required
+    DeviceContext context({}, bindless);
+
+    Scene scene;
+    Engine engine(scene, context, VkExtent2D{800u, 600u});
+    engine.SetDrawMode(drawMode);
+    engine.SetDeferredShading(deferred);
+    engine.SetClusteredLighting(clustered);
+    populateScene(scene, context.GetResourceManager(), rMeshPath, numObjects);
+    addLights(scene, numLights);
+    scene.SetGpuCulling(gpuCulling);
+
+    FrameTimes times = measureFrames(engine, numFrames);
+    context.WaitIdle();
+
+    if (numFrames > 0) {
+        std::cout << "Rendered " << numFrames << " frames headless: " << times << std::endl;
+    }
+    context.GetMemoryAllocator().PrintStatistics(std::cout);
+    context.GetPipelineCache().PrintStatistics(std::cout);
+    context.GetPipelineRegistry().PrintStatistics(std::cout);
+    engine.GetRenderQueue().PrintStatistics(std::cout);
+    return 0;
+}
+
+/**
+ * Renders numObjects objects headless with every draw mode in turn and reports the frame times of each: instanced
+ * draws as the baseline, then one draw per object with its transform in a uniform slice (a descriptor bind with a new
+ * dynamic offset per draw) and in push constants.
+ */
+int runDrawBenchmark(uint32_t numObjects, uint32_t numFrames, bool bindless) {
+    // Plenty for shaders and pipelines of a mode to arrive, they load in the background
+    const uint32_t maxWarmUpFrames = 10000u;
+
+    DeviceContext context({}, bindless);
+    Scene scene;
+    Engine engine(scene, context, VkExtent2D{800u, 600u});
+    populateScene(scene, context.GetResourceManager(), {}, numObjects);
+
+    const std::array<std::pair<DrawMode, const char *>, 3> drawModes = {{
+        {DrawMode::Instanced, "instanced"},
+        {DrawMode::Uniforms, "uniform buffers"},
+        {DrawMode::PushConstants, "push constants"},
+    }};
+    for (const auto &[drawMode, pName] : drawModes) {
+        engine.SetDrawMode(drawMode);
+
+        // Materials are not drawn until the pipelines of the mode exist, afterwards the per-frame buffers still grow
+        // for a few frames
+        uint64_t frameDraws = 0;
+        for (uint32_t i = 0; i < maxWarmUpFrames && frameDraws == 0; i++) {
+            const uint64_t draws = engine.GetRenderQueue().GetStatistics().draws;
+            engine.Render();
+            frameDraws = engine.GetRenderQueue().GetStatistics().draws - draws;
+        }
+        if (frameDraws == 0) {
+            std::cerr << "Nothing drawn in draw mode " << pName << "!" << std::endl;
+            return 1;
+        }
+        measureFrames(engine, RenderTarget::MAX_FRAMES_IN_FLIGHT);
+
+        const uint64_t draws = engine.GetRenderQueue().GetStatistics().draws;
+        FrameTimes times = measureFrames(engine, numFrames);
+        std::cout << "Draw mode " << pName << " (" << numObjects << " objects, "
+                  << (engine.GetRenderQueue().GetStatistics().draws - draws) / std::max(numFrames, 1u)
+                  << " draws per frame): " << times << std::endl;
+    }
+    context.WaitIdle();
+    engine.GetRenderQueue().PrintStatistics(std::cout);
+    return 0;
+}
+
+/**
+ * Culls random bounds against a perspective camera with the SIMD and the scalar linear implementation and with a
+ * BVH, reports the time per pass. Needs no device.
+ */
+int runCullingBenchmark(uint32_t numObjects) {
+    const uint32_t numPasses = 20u;
+
+    std::mt19937 random(42u);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> halfSize(0.1f, 2.0f);
+    BoundsArray bounds;
+    for (uint32_t i = 0; i < numObjects; i++) {
+        glm::vec3 center(position(random), position(random), position(random));
+        glm::vec3 halfExtent(halfSize(random), halfSize(random), halfSize(random));
+        bounds.Add(Bounds{center - halfExtent, center + halfExtent, center, glm::length(halfExtent)});
+    }
+
+    glm::mat4 projection = glm::perspectiveRH_ZO(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 150.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum(projection * view);
+
+    auto measure = [&](auto &&rrCull, std::vector<uint32_t> &rVisible) {
+        double minMs = std::numeric_limits<double>::max();
+        for (uint32_t i = 0; i < numPasses; i++) {
+            auto start = std::chrono::high_resolution_clock::now();
+            rrCull(rVisible);
+            auto end = std::chrono::high_resolution_clock::now();
+            minMs = std::min(minMs, std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        return minMs;
+    };
+
+    std::vector<uint32_t> visible;
+    std::vector<uint32_t> visibleScalar;
+    double simdMs = measure([&](std::vector<uint32_t> &rVisible) { bounds.Cull(frustum, rVisible); }, visible);
+    double scalarMs =
+        measure([&](std::vector<uint32_t> &rVisible) { bounds.CullScalar(frustum, rVisible); }, visibleScalar);
+
+    std::cout << "Culled " << numObjects << " objects, " << visible.size() << " visible: " << BoundsArray::GetSimdName()
+              << " " << simdMs << " ms, scalar " << scalarMs << " ms (best of " << numPasses << ")" << std::endl;
+
+    Bvh bvh;
+    for (uint32_t i = 0; i < numObjects; i++) {
+        Bounds objectBounds = bounds.Get(i);
+        bvh.Insert(Bvh::Aabb{objectBounds.min, objectBounds.max}, i);
+    }
+    auto buildStart = std::chrono::high_resolution_clock::now();
+    bvh.Rebuild();
+    auto buildEnd = std::chrono::high_resolution_clock::now();
+    std::vector<uint32_t> visibleBvh;
+    double bvhMs = measure(
+        [&](std::vector<uint32_t> &rVisible) {
+            rVisible.clear();
+            bvh.QueryFrustum(frustum, rVisible);
+        },
+        visibleBvh);
+    std::cout << "BVH built in " << std::chrono::duration<double, std::milli>(buildEnd - buildStart).count()
+              << " ms, " << visibleBvh.size() << " boxes visible: " << bvhMs << " ms" << std::endl;
+    if (visible != visibleScalar) {
+        std::cerr << "SIMD and scalar culling disagree!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+}  // namespace
+
 int main(int argc, char *argv[]) {
+    bool headless = false;
+    uint32_t numFrames = 100u;
+    uint32_t numObjects = 1u;
+    bool objectsGiven = false;
+    bool gpuCulling = false;
+    bool bindless = false;
+    DrawMode drawMode = DrawMode::Instanced;
+    bool deferred = false;
+    bool clustered = false;
+    uint32_t numLights = 4u;
+    bool drawBenchmark = false;
+    std::filesystem::path meshPath;
+    for (int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--cull-benchmark") {
+            uint32_t cullObjects = 1000000u;
+            if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                cullObjects = static_cast<uint32_t>(std::stoul(argv[++i]));
+            }
+            return runCullingBenchmark(cullObjects);
+        } else if (arg == "--draw-benchmark") {
+            drawBenchmark = true;
+            if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                numObjects = static_cast<uint32_t>(std::stoul(argv[++i]));
+                objectsGiven = true;
+            }
+        } else if (arg == "--frames" && i + 1 < argc) {
+            numFrames = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--objects" && i + 1 < argc) {
+            numObjects = static_cast<uint32_t>(std::stoul(argv[++i]));
+            objectsGiven = true;
+        } else if (arg == "--gpu-culling") {
+            gpuCulling = true;
+        } else if (arg == "--bindless") {
+            bindless = true;
+        } else if (arg == "--draw-mode" && i + 1 < argc) {
+            std::string mode(argv[++i]);
+            if (mode == "instanced") {
+                drawMode = DrawMode::Instanced;
+            } else if (mode == "push") {
+                drawMode = DrawMode::PushConstants;
+            } else if (mode == "uniforms") {
+                drawMode = DrawMode::Uniforms;
+            } else {
+                std::cerr << "Unknown draw mode " << mode << ", expected instanced, push or uniforms!" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--deferred") {
+            deferred = true;
+        } else if (arg == "--clustered") {
+            clustered = true;
+        } else if (arg == "--lights" && i + 1 < argc) {
+            numLights = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else {
+            meshPath = arg;
+        }
+    }
+
+    if (drawBenchmark) {
+        // Per-draw costs only show with many objects
+        return runDrawBenchmark(objectsGiven ? numObjects : 10000u, numFrames, bindless);
+    }
+    if (headless) {
+        return runHeadless(numFrames, meshPath, numObjects, gpuCulling, bindless, drawMode, deferred, clustered,
+                           numLights);
+    }
+
     WindowManager manager;
 
     Window *pWindow = manager.CreateWindow("Test", 800u, 600u);
 
-    DeviceContext context(manager.GetRequiredExtensions(pWindow));
-    
+    DeviceContext context(manager.GetRequiredExtensions(pWindow), bindless);
+
     Scene scene;
     Engine engine(scene, context, *pWindow);
-
-    auto spPhongMaterial = std::make_shared<PhongMaterial>();
-    auto spMeshObject = std::make_unique<MeshObject>();
-    spMeshObject->SetMaterial(spPhongMaterial);
-    scene.AddObject(std::move(spMeshObject));
+    engine.SetDrawMode(drawMode);
+    engine.SetDeferredShading(deferred);
+    engine.SetClusteredLighting(clustered);
+    populateScene(scene, context.GetResourceManager(), meshPath, numObjects);
+    addLights(scene, numLights);
+    scene.SetGpuCulling(gpuCulling);
 
     while (true) {
         manager.PollEvents();
 
         if (manager.ShouldQuit()) {
             std::cout << "Quit" << std::endl;
+            context.GetPipelineCache().PrintStatistics(std::cout);
+            context.GetPipelineRegistry().PrintStatistics(std::cout);
+            engine.GetRenderQueue().PrintStatistics(std::cout);
             break;
         }
 
@@ -2,15 +2,65 @@
 
 #include <vulkan/vulkan.h>
 
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
 class DeviceContext;
+class GraphicsPipeline;
 class RenderContext;
 class Swapchain;
+struct VertexData;
 
 class Material
 {
+public:
+    /// Equals BindlessTable::INVALID_INDEX
+    static constexpr uint32_t INVALID_BINDLESS_INDEX = std::numeric_limits<uint32_t>::max();
+
 public:
     virtual ~Material() = default;
     
+    /**
+     * @brief Vertex input layout the material pipeline is created with.
+     * Meshes sharing a material have to share the layout.
+     */
+    virtual void SetVertexLayout(const VertexData &rVertexData) = 0;
+
     virtual void Update(const RenderContext &rContext) = 0;
+
+    /**
+     * @brief False while resources (e.g. shaders) are still loading, the material must not be bound then.
+     */
+    virtual bool IsReady() const = 0;
+
+    /**
+     * @brief Pipeline the material draws with, only valid while IsReady().
+     */
+    virtual GraphicsPipeline &GetPipeline() const = 0;
+
+    /**
+     * @brief Binds the material resources. The pipeline is bound separately, so materials sharing a pipeline do not
+     * bind it again.
+     */
     virtual void Bind(VkCommandBuffer &rCommandBuffer) = 0;
+
+    /**
+     * @brief Materials with equal keys bind the same resources, so while the pipeline layout stays the same only the
+     * first of them is bound. Ids only use 32 bits, larger keys are free for resources shared by many materials.
+     */
+    virtual uint64_t GetBindKey() const { return id_; }
+
+    /**
+     * @brief Index of the material parameters in the bindless table, passed to the shaders in the instance data.
+     * Materials with the same pipeline and a valid index can be drawn in one instanced draw.
+     */
+    virtual uint32_t GetBindlessIndex() const { return INVALID_BINDLESS_INDEX; }
+
+    /// Unique per material, used to sort draws
+    uint32_t GetId() const { return id_; }
+
+private:
+    static inline std::atomic<uint32_t> nextId_ = 0;
+    uint32_t id_ = nextId_++;
 };
@@ -1,25 +1,251 @@
 #include "PhongMaterial.h"
 
+#include <cstring>
+
+#include "../BindlessTable.h"
+#include "../DeferredRenderer.h"
+#include "../DeviceContext.h"
 #include "../GraphicsPipeline.h"
+#include "../InstanceData.h"
+#include "../LightCuller.h"
 #include "../RenderContext.h"
-#include "../ResourceManager.h"
+#include "../ShaderLibrary.h"
+#include "../Texture.h"
+#include "../VertexData.h"
+
+namespace {
+const char *VERTEX_SHADER_FILE = "shaders/shader.vert.spv";
+const char *FRAGMENT_SHADER_FILE = "shaders/shader.frag.spv";
+const char *BINDLESS_VERTEX_SHADER_FILE = "shaders/bindless.vert.spv";
+const char *BINDLESS_FRAGMENT_SHADER_FILE = "shaders/bindless.frag.spv";
+const char *PUSH_CONSTANTS_VERTEX_SHADER_FILE = "shaders/push_constants.vert.spv";
+const char *DRAW_UNIFORMS_VERTEX_SHADER_FILE = "shaders/draw_uniforms.vert.spv";
+const char *GBUFFER_FRAGMENT_SHADER_FILE = "shaders/gbuffer.frag.spv";
+const char *GBUFFER_BINDLESS_FRAGMENT_SHADER_FILE = "shaders/gbuffer_bindless.frag.spv";
+const char *CLUSTERED_FRAGMENT_SHADER_FILE = "shaders/clustered.frag.spv";
+const char *CLUSTERED_BINDLESS_FRAGMENT_SHADER_FILE = "shaders/clustered_bindless.frag.spv";
+
+constexpr uint32_t BINDLESS_TEX_COORD_LOCATION = 2;
+// All bindless materials bind the same table, ids stay below
+constexpr uint64_t BINDLESS_BIND_KEY = 1ull << 32;
+
+// Material in shaders/bindless.frag (std430)
+struct Parameters {
+    glm::vec4 color;
+    uint32_t texture;
+    float specular;
+    float shininess;
+    uint32_t padding;
+};
+
+/**
+ * @brief Position (location 0) and texture coordinates, the only inputs of bindless.vert and the per-draw shaders.
+ * Meshes without texture coordinates feed the position instead, so one pipeline layout serves every mesh.
+ */
+std::vector<VkVertexInputAttributeDescription> getBindlessAttributes(
+    const std::vector<VkVertexInputAttributeDescription> &rAttributes) {
+    std::vector<VkVertexInputAttributeDescription> attributes;
+    const VkVertexInputAttributeDescription *pTexCoord = nullptr;
+    for (const VkVertexInputAttributeDescription &rAttribute : rAttributes) {
+        if (rAttribute.location == 0) {
+            attributes.push_back(rAttribute);
+        } else if (rAttribute.format == VK_FORMAT_R32G32_SFLOAT && pTexCoord == nullptr) {
+            pTexCoord = &rAttribute;
+        }
+    }
+    if (attributes.empty()) {
+        return rAttributes;
+    }
+
+    VkVertexInputAttributeDescription texCoord = pTexCoord != nullptr ? *pTexCoord : attributes[0];
+    texCoord.location = BINDLESS_TEX_COORD_LOCATION;
+    texCoord.format = VK_FORMAT_R32G32_SFLOAT;
+    attributes.push_back(texCoord);
+    return attributes;
+}
+
+const char *getVertexShaderFile(DrawMode drawMode, bool bindless, bool worldPosition) {
+    switch (drawMode) {
+        case DrawMode::PushConstants:
+            return PUSH_CONSTANTS_VERTEX_SHADER_FILE;
+        case DrawMode::Uniforms:
+            return DRAW_UNIFORMS_VERTEX_SHADER_FILE;
+        default:
+            // Only bindless.vert of the instanced shaders outputs the world position
+            return bindless || worldPosition ? BINDLESS_VERTEX_SHADER_FILE : VERTEX_SHADER_FILE;
+    }
+}
+
+const char *getFragmentShaderFile(bool bindless, bool deferred, bool clustered) {
+    if (deferred) {
+        return bindless ? GBUFFER_BINDLESS_FRAGMENT_SHADER_FILE : GBUFFER_FRAGMENT_SHADER_FILE;
+    }
+    if (clustered) {
+        return bindless ? CLUSTERED_BINDLESS_FRAGMENT_SHADER_FILE : CLUSTERED_FRAGMENT_SHADER_FILE;
+    }
+    return bindless ? BINDLESS_FRAGMENT_SHADER_FILE : FRAGMENT_SHADER_FILE;
+}
+}  // namespace
 
 PhongMaterial::~PhongMaterial() = default;
 
+void PhongMaterial::SetVertexLayout(const VertexData &rVertexData) {
+    inputBindingDescription_ = rVertexData.inputBindingDescription;
+    attributeDescriptions_ = rVertexData.attributeDescriptions;
+    vertexLayoutDirty_ = true;
+}
+
+bool PhongMaterial::IsReady() const {
+    return spPipeline_ != nullptr && (pBindlessTable_ == nullptr || spParameters_ != nullptr);
+}
+
+void PhongMaterial::SetColor(const glm::vec4 &rColor) {
+    color_ = rColor;
+    parametersDirty_ = true;
+}
+
+void PhongMaterial::SetSpecular(float strength, float shininess) {
+    specular_ = strength;
+    shininess_ = shininess;
+    parametersDirty_ = true;
+}
+
+void PhongMaterial::SetTexture(std::shared_ptr<Texture> spTexture) {
+    spTexture_ = std::move(spTexture);
+    parametersDirty_ = true;
+}
+
 void PhongMaterial::Update(const RenderContext &rContext) {
-    if (spPipeline_ == nullptr || rContext.outOfDate) {
-        // Recreate pipeline
-        spPipeline_ = std::make_unique<GraphicsPipeline>(rContext.deviceContext, rContext.swapchain, rContext.renderPass, rContext.imageFormat);
+    pBindlessTable_ = rContext.deviceContext.GetBindlessTable();
+    ShaderLibrary &rShaderLibrary = rContext.deviceContext.GetShaderLibrary();
+    bool shadersChanged = false;
+    // Deferred shading lights the G-buffer instead, clustered or not
+    const bool clustered = rContext.lightSet != VK_NULL_HANDLE && !rContext.deferred;
+    const bool modeChanged =
+        drawMode_ != rContext.drawMode || deferred_ != rContext.deferred || clustered_ != clustered;
+    if (modeChanged && spPipeline_ != nullptr) {
+        // Draws of the new mode do not match the pipeline, the material is not drawn until its own one exists
+        rContext.frameContext.Retain(spPipeline_);
+        spPipeline_.reset();
+    }
+    // Every draw mode has its own vertex shader, deferred shading and clustered lighting their own fragment shaders,
+    // so a new mode always means new modules and a new pipeline
+    if (spVertexShader_ == nullptr || shaderGeneration_ != rShaderLibrary.GetGeneration() || modeChanged) {
+        const bool bindless = pBindlessTable_ != nullptr;
+        std::shared_ptr<const ShaderModule> spVertexShader = rShaderLibrary.GetShaderModule(
+            getVertexShaderFile(rContext.drawMode, bindless, rContext.deferred || clustered));
+        std::shared_ptr<const ShaderModule> spFragmentShader =
+            rShaderLibrary.GetShaderModule(getFragmentShaderFile(bindless, rContext.deferred, clustered));
+        if (spVertexShader == nullptr || spFragmentShader == nullptr) {
+            // Not drawn until the shaders arrived
+            return;
+        }
 
-        GraphicsPipeline::ShaderModule vertexModule{VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT,
-                                                    ResourceManager::ReadBinaryFile("shaders/shader.vert.spv")};
-        GraphicsPipeline::ShaderModule fragmentModule{VkShaderStageFlagBits::VK_SHADER_STAGE_FRAGMENT_BIT,
-                                                      ResourceManager::ReadBinaryFile("shaders/shader.frag.spv")};
+        // Only a reload of one of our own files needs a new pipeline
+        shadersChanged = spVertexShader != spVertexShader_ || spFragmentShader != spFragmentShader_;
+        spVertexShader_ = std::move(spVertexShader);
+        spFragmentShader_ = std::move(spFragmentShader);
+        shaderGeneration_ = rShaderLibrary.GetGeneration();
+        drawMode_ = rContext.drawMode;
+        deferred_ = rContext.deferred;
+        clustered_ = clustered;
+    }
 
-        spPipeline_->SetShaderModules({vertexModule, fragmentModule});
+    // A resize keeps the render pass, only a new format (and so a new render pass) needs another pipeline
+    if (spPipeline_ == nullptr || shadersChanged || vertexLayoutDirty_ || renderPass_ != rContext.renderPass ||
+        imageFormat_ != rContext.imageFormat) {
+        // Materials with equal state share one pipeline, usually this is a lookup instead of a compilation
+        GraphicsPipeline::State state;
+        state.shaderStages = {{VK_SHADER_STAGE_VERTEX_BIT, spVertexShader_},
+                              {VK_SHADER_STAGE_FRAGMENT_BIT, spFragmentShader_}};
+        if (drawMode_ == DrawMode::Instanced) {
+            // Meshes are drawn instanced, the transforms come from the instance binding
+            state.inputBindingDescriptions = {inputBindingDescription_, InstanceData::GetBindingDescription()};
+            state.inputAttributeDescriptions = pBindlessTable_ != nullptr || deferred_ || clustered_
+                                                   ? getBindlessAttributes(attributeDescriptions_)
+                                                   : attributeDescriptions_;
+            for (const VkVertexInputAttributeDescription &rAttribute : InstanceData::GetAttributeDescriptions()) {
+                state.inputAttributeDescriptions.push_back(rAttribute);
+            }
+        } else {
+            // Every object is drawn on its own, its transform comes from push constants or its uniform slice
+            state.inputBindingDescriptions = {inputBindingDescription_};
+            state.inputAttributeDescriptions = getBindlessAttributes(attributeDescriptions_);
+            if (drawMode_ == DrawMode::PushConstants) {
+                state.pushConstantRanges = {DrawConstants::GetPushConstantRange()};
+            }
+        }
+        // Frame constants in set 0, the bindless table after them
+        state.descriptorSetLayoutBindings = FrameContext::GetUniformBindings();
+        if (pBindlessTable_ != nullptr) {
+            state.extraSetLayouts = {pBindlessTable_->GetSetLayout()};
+        }
+        if (clustered_) {
+            // The light set follows the others (set 1 or 2 in shaders/clustered(_bindless).frag)
+            lightSetIndex_ = static_cast<uint32_t>(state.extraSetLayouts.size()) + 1;
+            state.extraSetLayouts.push_back(
+                rContext.deviceContext.GetPipelineRegistry().GetDescriptorSetLayout(LightCuller::GetSetLayoutBindings()));
+        }
+        state.renderPass = rContext.renderPass;
+        state.colorFormat = rContext.imageFormat;
+        if (deferred_) {
+            // Drawn into the G-buffer, only the closest surface gets lit
+            state.subpass = DeferredRenderer::GEOMETRY_SUBPASS;
+            state.colorAttachmentCount = DeferredRenderer::GBUFFER_COLOR_COUNT;
+            state.depthTestEnable = true;
+            state.depthWriteEnable = true;
+        }
+
+        if (spPipeline_ != nullptr) {
+            // Frames still in flight may use the previous pipeline
+            rContext.frameContext.Retain(spPipeline_);
+        }
+        spPipeline_ = rContext.deviceContext.GetPipelineRegistry().GetGraphicsPipeline(state);
+        renderPass_ = rContext.renderPass;
+        imageFormat_ = rContext.imageFormat;
+        vertexLayoutDirty_ = false;
     }
 
-    spPipeline_->Update();
+    lightSet_ = clustered_ ? rContext.lightSet : VK_NULL_HANDLE;
+
+    // Frames in flight read the current parameters, so changes go into a new buffer. Until its upload finished the
+    // texture is left out.
+    std::shared_ptr<Texture> spTexture = spTexture_ != nullptr && spTexture_->IsReady() ? spTexture_ : nullptr;
+    if (pBindlessTable_ != nullptr && (parametersDirty_ || spTexture != spParametersTexture_)) {
+        auto spParameters = std::make_shared<BindlessBuffer>(rContext.deviceContext, sizeof(Parameters));
+        Parameters parameters{};
+        parameters.color = color_;
+        parameters.texture = spTexture != nullptr ? spTexture->GetBindlessIndex() : BindlessTable::INVALID_INDEX;
+        parameters.specular = specular_;
+        parameters.shininess = shininess_;
+        std::memcpy(spParameters->GetData(), &parameters, sizeof(parameters));
+
+        if (spParameters_ != nullptr) {
+            rContext.frameContext.Retain(spParameters_);
+            rContext.frameContext.Retain(spParametersTexture_);
+        }
+        spParameters_ = std::move(spParameters);
+        spParametersTexture_ = std::move(spTexture);
+        parametersDirty_ = false;
+    }
 }
 
-void PhongMaterial::Bind(VkCommandBuffer &rCommandBuffer) { spPipeline_->Bind(rCommandBuffer); }
+void PhongMaterial::Bind(VkCommandBuffer &rCommandBuffer) {
+    // Only the bindless table and the light set of the frame, they stay bound for all bindless materials (see
+    // GetBindKey)
+    if (pBindlessTable_ != nullptr) {
+        pBindlessTable_->Bind(rCommandBuffer, spPipeline_->GetLayout().GetHandle());
+    }
+    if (lightSet_ != VK_NULL_HANDLE) {
+        vkCmdBindDescriptorSets(rCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, spPipeline_->GetLayout().GetHandle(),
+                                lightSetIndex_, 1, &lightSet_, 0, nullptr);
+    }
+}
+
+uint64_t PhongMaterial::GetBindKey() const {
+    return pBindlessTable_ != nullptr ? BINDLESS_BIND_KEY : Material::GetBindKey();
+}
+
+uint32_t PhongMaterial::GetBindlessIndex() const {
+    return spParameters_ != nullptr ? spParameters_->GetIndex() : INVALID_BINDLESS_INDEX;
+}
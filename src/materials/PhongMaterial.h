@@ -1,20 +1,75 @@
 #pragma once
 
+#include <glm/glm.hpp>
+
 #include <memory>
+#include <vector>
+#include "../DrawConstants.h"
 #include "Material.h"
 
+class BindlessBuffer;
+class BindlessTable;
 class GraphicsPipeline;
-class ImageData;
+struct ImageData;
+class ShaderModule;
+class Texture;
 
+/**
+ * @brief With a bindless table (see DeviceContext::GetBindlessTable) color and texture are parameters in a bindless
+ * buffer and every PhongMaterial shares one pipeline, without it the material draws a fixed color. Unlit, unless
+ * lighting is clustered (see LightCuller) or deferred.
+ */
 class PhongMaterial : public Material {
 public:
     ~PhongMaterial() override;
+    void SetVertexLayout(const VertexData &rVertexData) override;
     void Update(const RenderContext &rContext) override;
+    bool IsReady() const override;
+    GraphicsPipeline &GetPipeline() const override { return *spPipeline_; }
     void Bind(VkCommandBuffer &rCommandBuffer) override;
+    uint64_t GetBindKey() const override;
+    uint32_t GetBindlessIndex() const override;
 
     void SetImage(const std::shared_ptr<ImageData> &imageData);
 
+    /// Bindless only, applied by the next update
+    void SetColor(const glm::vec4 &rColor);
+    /// Bindless only, multiplies the color once the upload finished. Sampled at the texture coordinates of the mesh.
+    void SetTexture(std::shared_ptr<Texture> spTexture);
+    /// Bindless only, highlights of deferred shading and clustered lighting
+    void SetSpecular(float strength, float shininess);
+
 private:
-    std::unique_ptr<GraphicsPipeline> spPipeline_;
+    std::shared_ptr<GraphicsPipeline> spPipeline_;
+    // Pipeline was created for these
+    VkRenderPass renderPass_ = VK_NULL_HANDLE;
+    VkFormat imageFormat_ = VK_FORMAT_UNDEFINED;
     std::shared_ptr<ImageData> imageData_;
+
+    // Set while drawing bindless, the parameters are rewritten into a new buffer whenever they changed
+    BindlessTable *pBindlessTable_ = nullptr;
+    glm::vec4 color_ = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
+    std::shared_ptr<Texture> spTexture_;
+    float specular_ = 0.5f;
+    float shininess_ = 32.0f;
+    bool parametersDirty_ = true;
+    std::shared_ptr<BindlessBuffer> spParameters_;
+    // Texture the current parameters refer to
+    std::shared_ptr<Texture> spParametersTexture_;
+
+    VkVertexInputBindingDescription inputBindingDescription_{};
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions_;
+    bool vertexLayoutDirty_ = false;
+
+    std::shared_ptr<const ShaderModule> spVertexShader_;
+    std::shared_ptr<const ShaderModule> spFragmentShader_;
+    // Shader library generation and modes the modules were looked up for
+    uint64_t shaderGeneration_ = 0;
+    DrawMode drawMode_ = DrawMode::Instanced;
+    bool deferred_ = false;
+    bool clustered_ = false;
+
+    // Light set of the current frame while lighting clustered, bound at lightSetIndex_
+    VkDescriptorSet lightSet_ = VK_NULL_HANDLE;
+    uint32_t lightSetIndex_ = 0;
 };
@@ -1,54 +1,56 @@
 #include "MeshObject.h"
-#include "../RenderContext.h"
-#include "../ResourceManager.h"
 
-MeshObject::~MeshObject() = default;
+#include <stdexcept>
+
+#include "../Scene.h"
+
+bool MeshObject::IsValid() const { return pScene_ != nullptr && pScene_->Contains(handle_); }
+
+Scene &MeshObject::scene() const
+{
+    // Default views, e.g. from Scene::FindObject with a stale handle, have no scene
+    if (pScene_ == nullptr) {
+        throw std::runtime_error("failed to access object, it was removed!");
+    }
+    return *pScene_;
+}
 
 void MeshObject::SetMaterial(const std::shared_ptr<Material> &rMaterial)
 {
-    material_ = rMaterial;
+    Scene &rScene = scene();
+    rScene.setMaterial(rScene.indexOf(handle_), rMaterial);
 }
 
 std::shared_ptr<Material> MeshObject::GetMaterial() const
 {
-    return material_;
+    Scene &rScene = scene();
+    return rScene.materials_[rScene.indexOf(handle_)];
 }
 
 void MeshObject::SetVertexData(const std::shared_ptr<VertexData> &rVertexData)
 {
-    vertexData_ = rVertexData;
+    scene().setVertexData(handle_, rVertexData, AssetHandle<VertexData>());
 }
 
-void MeshObject::Update(const RenderContext &rContext) {
-    if(material_ == nullptr)
-    {
-        return;
-    }
-
-    material_->Update(rContext);
-
-    if(vertexData_ != nullptr){
-        // Create vertex buffer
-    }
+void MeshObject::SetVertexData(const AssetHandle<VertexData> &rVertexDataHandle)
+{
+    scene().setVertexData(handle_, nullptr, rVertexDataHandle);
+}
 
+void MeshObject::SetTransform(const glm::mat4 &rTransform)
+{
+    Scene &rScene = scene();
+    rScene.setTransform(rScene.indexOf(handle_), rTransform);
 }
 
-void MeshObject::Draw(const RenderContext &rContext) {
-    if(material_ == nullptr)
-    {
-        return;
-    }
+const glm::mat4 &MeshObject::GetTransform() const
+{
+    Scene &rScene = scene();
+    return rScene.transforms_[rScene.indexOf(handle_)];
+}
 
-    /*
-    VkBuffer vertexBuffers[] = {m_vertexBuffer};
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(m_commandBuffers[i], 0, 1, vertexBuffers, offsets);
-    vkCmdBindIndexBuffer(m_commandBuffers[i], m_indexBuffer, 0, VK_INDEX_TYPE_UINT16);
-    */
-
-    // Bind graphics pipeline
-    material_->Bind(rContext.commandBuffer);
-    // Draw
-    // vkCmdDrawIndexed(m_commandBuffers[i], static_cast<uint32_t>(c_indices.size()), 1, 0, 0, 0);
-    vkCmdDraw(rContext.commandBuffer, 3, 1, 0, 0);
+Bounds MeshObject::GetBounds() const
+{
+    Scene &rScene = scene();
+    return rScene.bounds_.Get(rScene.indexOf(handle_));
 }
@@ -1,23 +1,49 @@
 #pragma once
 
+#include <glm/glm.hpp>
+
 #include <memory>
-#include "Object.h"
-#include "../materials/Material.h"
+#include "../AssetLoader.h"
+#include "../Bounds.h"
+#include "../SlotMap.h"
 
-class VertexData;
+class Material;
+class Scene;
+struct VertexData;
 
-class MeshObject final : public Object {
+/**
+ * @brief View of a mesh object in a scene, the object itself is a set of components stored packed by the Scene.
+ * Views are cheap to copy. Using the view of a removed object throws, IsValid() tells whether it still exists.
+ */
+class MeshObject final {
 public:
-    ~MeshObject() override;
+    MeshObject() = default;
+    MeshObject(Scene &rScene, SlotMapHandle handle) : pScene_(&rScene), handle_(handle) {}
+
+    bool IsValid() const;
+    SlotMapHandle GetHandle() const { return handle_; }
+
     void SetMaterial(const std::shared_ptr<Material> &rMaterial);
     std::shared_ptr<Material> GetMaterial() const;
 
     void SetVertexData(const std::shared_ptr<VertexData> &rVertexData);
+    /**
+     * @brief Vertex data loaded in the background, object is drawn once it arrived.
+     */
+    void SetVertexData(const AssetHandle<VertexData> &rVertexDataHandle);
 
-    void Update(const RenderContext &context) override;
-    void Draw(const RenderContext &context) override;
+    void SetTransform(const glm::mat4 &rTransform);
+    const glm::mat4 &GetTransform() const;
+
+    /**
+     * @brief World space bounds, infinite until the vertex data arrived.
+     */
+    Bounds GetBounds() const;
+
+private:
+    Scene &scene() const;
 
 private:
-    std::shared_ptr<Material> material_;
-    std::shared_ptr<VertexData> vertexData_;
+    Scene *pScene_ = nullptr;
+    SlotMapHandle handle_;
 };